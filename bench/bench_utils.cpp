@@ -0,0 +1,132 @@
+#include "bench_utils.hpp"
+#include "matchem_exception.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace matchem {
+namespace bench {
+
+////////////////////////////////////////////////////////////////////////////////
+double median(std::vector<double> samples)
+////////////////////////////////////////////////////////////////////////////////
+{
+  my_require(!samples.empty(), "No samples");
+  const size_t mid = samples.size() / 2;
+  std::nth_element(samples.begin(), samples.begin() + mid, samples.end());
+  if (samples.size() % 2 == 1) {
+    return samples[mid];
+  }
+  const double upper = samples[mid];
+  return 0.5 * (upper + *std::max_element(samples.begin(), samples.begin() + mid));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double mad(const std::vector<double>& samples)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const double center = median(samples);
+  std::vector<double> deviations;
+  for (const double sample : samples) {
+    deviations.push_back(std::fabs(sample - center));
+  }
+  return median(deviations);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+BenchResult summarize(const std::string& name, const std::vector<double>& samples)
+////////////////////////////////////////////////////////////////////////////////
+{
+  return BenchResult{name, median(samples), mad(samples), static_cast<int>(samples.size())};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void write_json(std::ostream& out, const std::string& backend, const int threads,
+                const std::vector<BenchResult>& results)
+////////////////////////////////////////////////////////////////////////////////
+{
+  out << "{\n  \"backend\": \"" << backend << "\",\n  \"threads\": " << threads << ",\n  \"unit\": \"ns\",\n"
+      << "  \"benchmarks\": [";
+  for (size_t r = 0; r < results.size(); ++r) {
+    const BenchResult& result = results[r];
+    out << (r == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"median\": " << result.median
+        << ", \"mad\": " << result.mad << ", \"trials\": " << result.trials << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void write_json(const std::string& filename, const std::string& backend, const int threads,
+                const std::vector<BenchResult>& results)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ofstream out(filename);
+  my_require(out.good(), "Could not write benchmark file: " + filename);
+  out << std::setprecision(10);
+  write_json(out, backend, threads, results);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<BenchResult> read_json(const std::string& filename)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ifstream in(filename);
+  my_require(in.good(), "Could not open benchmark file: " + filename);
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  const std::string text = buffer.str();
+
+  // Only has to read what write_json writes: one object per benchmark
+  const auto field = [&](const size_t from, const std::string& key) {
+    const size_t at = text.find("\"" + key + "\":", from);
+    my_require(at != std::string::npos, "Missing " + key + " in benchmark file: " + filename);
+    return at + key.size() + 3;
+  };
+
+  std::vector<BenchResult> results;
+  for (size_t at = text.find("{\"name\":"); at != std::string::npos; at = text.find("{\"name\":", at + 1)) {
+    BenchResult result;
+    const size_t name_start = text.find('"', field(at, "name")) + 1;
+    result.name   = text.substr(name_start, text.find('"', name_start) - name_start);
+    result.median = std::atof(text.c_str() + field(at, "median"));
+    result.mad    = std::atof(text.c_str() + field(at, "mad"));
+    result.trials = std::atoi(text.c_str() + field(at, "trials"));
+    results.push_back(result);
+  }
+  return results;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int compare(std::ostream& out, const std::vector<BenchResult>& results,
+            const std::vector<BenchResult>& baseline, const double tolerance)
+////////////////////////////////////////////////////////////////////////////////
+{
+  int regressions = 0;
+  out << std::setw(28) << "benchmark" << std::setw(14) << "median (ns)" << std::setw(14) << "baseline"
+      << std::setw(10) << "change" << "\n";
+  for (const BenchResult& result : results) {
+    const auto base = std::find_if(baseline.begin(), baseline.end(),
+                                   [&](const BenchResult& b) { return b.name == result.name; });
+    out << std::setw(28) << result.name << std::setw(14) << result.median;
+    if (base == baseline.end()) {
+      out << std::setw(14) << "-" << std::setw(10) << "-" << "  new\n";
+      continue;
+    }
+    const double change = base->median > 0.0 ? result.median / base->median - 1.0 : 0.0;
+    // Both runs' noise counts, a change inside it is no change
+    const double noise = 3.0 * std::max(result.mad, base->mad);
+    const bool slower = change > tolerance && result.median - base->median > noise;
+    const bool faster = change < -tolerance && base->median - result.median > noise;
+    out << std::setw(14) << base->median << std::setw(9) << std::fixed << std::setprecision(1) << 100.0 * change
+        << "%" << std::defaultfloat << std::setprecision(6) << (slower ? "  SLOWER" : faster ? "  faster" : "") << "\n";
+    regressions += slower ? 1 : 0;
+  }
+  return regressions;
+}
+
+}
+}
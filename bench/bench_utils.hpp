@@ -0,0 +1,60 @@
+#ifndef MATCHEM_BENCH_UTILS_HPP
+#define MATCHEM_BENCH_UTILS_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace matchem {
+namespace bench {
+
+/**
+ * The outcome of one benchmark: the median and the median absolute deviation
+ * of its trials, in ns per operation (lower is better). Medians shrug off the
+ * odd trial that got preempted, which means would not.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct BenchResult
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::string name;
+  double median;
+  double mad;
+  int trials;
+};
+
+// Keeps the compiler from dropping the computation of value, or moving it out
+// of the timed loop, without storing it anywhere
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Median of the samples, which must not be empty
+double median(std::vector<double> samples);
+
+// Median absolute deviation from the median
+double mad(const std::vector<double>& samples);
+
+BenchResult summarize(const std::string& name, const std::vector<double>& samples);
+
+// The results as JSON, with what they were run on
+void write_json(std::ostream& out, const std::string& backend, const int threads,
+                const std::vector<BenchResult>& results);
+void write_json(const std::string& filename, const std::string& backend, const int threads,
+                const std::vector<BenchResult>& results);
+
+// The results in a file written by write_json
+std::vector<BenchResult> read_json(const std::string& filename);
+
+// Print every result next to its baseline, returns how many got slower by
+// more than the tolerance (a fraction) and more than their noise (3 MADs)
+int compare(std::ostream& out, const std::vector<BenchResult>& results,
+            const std::vector<BenchResult>& baseline, const double tolerance);
+
+}
+}
+
+#endif
@@ -0,0 +1,313 @@
+#include "bench_utils.hpp"
+
+#include "matchem.hpp"
+#include "matchem_budget.hpp"
+#include "matchem_exception.hpp"
+#include "matchem_kokkos.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace matchem {
+namespace bench {
+
+/**
+ * Benchmarks of the hot paths, in ns per call (micro) and ns per game
+ * (macro). Every benchmark is warmed up, then timed over a number of trials
+ * and reported as the median and MAD of the trials.
+ *
+ * Micro benchmarks start from the same position every call: a fixed game a
+ * few rounds in. Calls that change the position are timed one at a time and
+ * the position is set up again, untimed, before each of them.
+ */
+
+struct Benchmarks
+{
+  // The game and how many rounds of it to play before the micro benchmarks
+  static constexpr int FIXED_GAME   = 1234567;
+  static constexpr int SETUP_ROUNDS = 3;
+
+  // Calls per trial of a micro benchmark
+  static constexpr int CALLS = 200;
+
+  // Draws the hidden states of the macro benchmarks
+  static constexpr uint64_t GAMES_SEED = 1;
+
+  int trials;
+  int warmup;
+  std::string filter;
+  std::vector<BenchResult> results;
+
+  // One trial, returns ns per operation
+  using Trial = std::function<double()>;
+
+  /////////////////////////////////////////////////////////////////////////////
+  bool wanted(const std::string& name) const
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    return name.find(filter) != std::string::npos;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  void run(const std::string& name, const Trial& trial)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    if (!wanted(name)) {
+      return;
+    }
+    for (int w = 0; w < warmup; ++w) {
+      trial();
+    }
+    std::vector<double> samples;
+    for (int t = 0; t < trials; ++t) {
+      samples.push_back(trial());
+    }
+    results.push_back(summarize(name, samples));
+    std::cout << "  " << name << ": " << results.back().median << " ns (+/- " << results.back().mad << ")"
+              << std::endl;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static double to_ns(const double cycles)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    return 1e3 * cycles / cycles_per_usec();
+  }
+
+  // What reading the clock twice costs, taken off every timed call
+  /////////////////////////////////////////////////////////////////////////////
+  static double timer_overhead()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    std::vector<double> samples;
+    for (int s = 0; s < 1000; ++s) {
+      const uint64_t start = read_cycles();
+      samples.push_back(read_cycles() - start);
+    }
+    return median(samples);
+  }
+
+  // Play the fixed game up to the position the micro benchmarks start from
+  /////////////////////////////////////////////////////////////////////////////
+  static void set_up(Matchem& matchem)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    matchem.init_indv_exact(0, FIXED_GAME % factorial(Matchem::SIZE));
+    for (int round = 0; round < SETUP_ROUNDS; ++round) {
+      matchem.ask_truth(0, round);
+      matchem.make_guess(0, round);
+      const int matches = matchem.get_num_matches(0);
+      my_require(matches < Matchem::SIZE, "Fixed game ended during setup");
+      matchem.process_guess_result(0, round, matches);
+    }
+  }
+
+  // Time op on a fresh copy of the fixed position per call, prep runs
+  // untimed between the setup and op
+  /////////////////////////////////////////////////////////////////////////////
+  static Trial per_call(Matchem& matchem, const std::function<void()>& prep, const std::function<void()>& op)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const double overhead = timer_overhead();
+    return [&matchem, prep, op, overhead] {
+      double cycles = 0.0;
+      for (int c = 0; c < CALLS; ++c) {
+        set_up(matchem);
+        prep();
+        const uint64_t start = read_cycles();
+        op();
+        cycles += read_cycles() - start;
+      }
+      return to_ns(std::max(0.0, cycles / CALLS - overhead));
+    };
+  }
+
+  // Time a batch of op calls that leave the position alone
+  /////////////////////////////////////////////////////////////////////////////
+  static Trial batched(const std::function<int(int)>& op)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    return [op] {
+      const int calls = CALLS * Matchem::SIZE;
+      const uint64_t start = read_cycles();
+      for (int c = 0; c < calls; ++c) {
+        do_not_optimize(op(c));
+      }
+      return to_ns(static_cast<double>(read_cycles() - start) / calls);
+    };
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  void micro()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    std::cout << "Micro benchmarks (ns/call):" << std::endl;
+    Matchem matchem(MatchemConfig(BASIC, 1, false));
+    const int n = Matchem::SIZE;
+
+    set_up(matchem);
+    run("get_state", batched([&](const int c) {
+      return static_cast<int>(matchem.get_state(0, c % n, c / n % n));
+    }));
+    run("get_num_pot_matches", batched([&](const int c) {
+      return matchem.get_num_pot_matches(0, c % n);
+    }));
+    run("get_num_pot_back_matches", batched([&](const int c) {
+      return matchem.get_num_pot_back_matches(0, c % n);
+    }));
+
+    // An unknown pair that is no match, which set_state learns
+    int side1 = -1, side2 = -1;
+    for (int i = 0; i < n && side1 == -1; ++i) {
+      for (int j = 0; j < n && side1 == -1; ++j) {
+        if (matchem.get_state(0, i, j) == Matchem::UNKNOWN_MATCH && matchem.m_game_state(0, i) != j) {
+          side1 = i;
+          side2 = j;
+        }
+      }
+    }
+    my_require(side1 != -1, "Fixed game has no unknown miss to set");
+    run("set_state", per_call(matchem, [] {}, [&] {
+      matchem.set_state(0, side1, side2, Matchem::NO_MATCH);
+    }));
+
+    run("get_best_truth_query", per_call(matchem, [] {}, [&] {
+      do_not_optimize(matchem.get_best_truth_query(0, SETUP_ROUNDS));
+    }));
+
+    std::pair<int, int> query;
+    run("process_ask_result", per_call(matchem, [&] {
+      query = matchem.get_best_truth_query(0, SETUP_ROUNDS);
+    }, [&] {
+      matchem.process_ask_result(0, SETUP_ROUNDS, query.first, query.second,
+                                 matchem.m_game_state(0, query.first) == query.second);
+    }));
+
+    run("make_guess", per_call(matchem, [&] {
+      matchem.ask_truth(0, SETUP_ROUNDS);
+    }, [&] {
+      matchem.make_guess(0, SETUP_ROUNDS);
+    }));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  void macro(const StrategyType strategy, const int num_games)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const std::string name = std::string("games/") + strategy_name(strategy);
+    if (!wanted(name)) {
+      return;
+    }
+    // The same games every trial and every build: game n replays a hidden
+    // state drawn from n alone, and the bandit's random streams start from
+    // the game and the seed configure draws
+    std::vector<int> games(num_games);
+    for (int game = 0; game < num_games; ++game) {
+      games[game] = static_cast<int>(Rng(hash_combine(GAMES_SEED, game)).below(factorial(Matchem::SIZE)));
+    }
+    MatchemConfig config(BASIC, num_games, false);
+    config.set_strategy(strategy);
+    config.set_replay_games(games);
+    srand(GAMES_SEED);
+    Matchem matchem(config);
+    run(name, [&] {
+      const uint64_t start = read_cycles();
+      matchem.play_games();
+      return to_ns(static_cast<double>(read_cycles() - start) / num_games);
+    });
+  }
+};
+
+}
+}
+
+namespace {
+
+const std::string HELP =
+  "matchem_bench [options]\n"
+  "  Micro benchmarks of the hot paths and games per second per strategy, in ns.\n"
+  "  --trials=N       Timed trials per benchmark (default 11)\n"
+  "  --warmup=N       Untimed trials first (default 2)\n"
+  "  --filter=str     Only run benchmarks whose name contains str\n"
+  "  --json=file      Write the results to file\n"
+  "  --baseline=file  Compare to results written with --json, exits with 1\n"
+  "                   if any benchmark got slower\n"
+  "  --tolerance=x    How much slower is slower, as a fraction (default 0.05)\n"
+  "\n"
+  "  The backend is picked when Kokkos is built; to compare Serial and OpenMP,\n"
+  "  write --json from one build and pass it as --baseline to the other.\n";
+
+}
+
+int main(int argc, char** argv)
+{
+  using namespace matchem;
+
+  Kokkos::initialize(argc, argv);
+
+  int regressions = 0;
+  {
+    bench::Benchmarks bench{11, 2, "", {}};
+    std::string json_file, baseline_file;
+    double tolerance = 0.05;
+
+    for (int i = 1; i < argc; ++i) {
+      const std::string full_arg = argv[i];
+      const std::string opt = full_arg.substr(0, full_arg.find('='));
+      const std::string arg = full_arg.find('=') == std::string::npos ? "" : full_arg.substr(full_arg.find('=') + 1);
+      if (opt == "-h" || opt == "--help") {
+        std::cout << HELP << std::endl;
+        Kokkos::finalize();
+        return 0;
+      }
+      else if (opt == "--trials") {
+        bench.trials = std::atoi(arg.c_str());
+      }
+      else if (opt == "--warmup") {
+        bench.warmup = std::atoi(arg.c_str());
+      }
+      else if (opt == "--filter") {
+        bench.filter = arg;
+      }
+      else if (opt == "--json") {
+        json_file = arg;
+      }
+      else if (opt == "--baseline") {
+        baseline_file = arg;
+      }
+      else if (opt == "--tolerance") {
+        tolerance = std::atof(arg.c_str());
+      }
+      // Anything else is for Kokkos
+    }
+    my_require(bench.trials > 0 && bench.warmup >= 0, "Need at least one trial");
+
+    const std::string backend = Kokkos::DefaultExecutionSpace::name();
+    const int threads = Kokkos::DefaultExecutionSpace::concurrency();
+    std::cout << "Backend " << backend << " with " << threads << " threads, set size " << Matchem::SIZE << ", "
+              << bench.trials << " trials" << std::endl;
+
+    bench.micro();
+
+    std::cout << "Macro benchmarks (ns/game):" << std::endl;
+    bench.macro(HEURISTIC, 2000);
+    bench.macro(BANDIT, 16);
+
+    if (!json_file.empty()) {
+      bench::write_json(json_file, backend, threads, bench.results);
+      std::cout << "Wrote results to " << json_file << std::endl;
+    }
+    if (!baseline_file.empty()) {
+      regressions = bench::compare(std::cout, bench.results, bench::read_json(baseline_file), tolerance);
+      std::cout << regressions << " benchmarks got slower than " << baseline_file << std::endl;
+    }
+  }
+
+  Kokkos::finalize();
+
+  return regressions > 0 ? 1 : 0;
+}
@@ -1,10 +1,16 @@
 #include "matchem.hpp"
 #include "matchem_exception.hpp"
+#include "matchem_solver.hpp"
 
 #include <sstream>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
 #include <type_traits>
 
+#include <unistd.h>
+
 namespace matchem {
 
 #define vprint(x) if (m_config.verbose()) { std::cout << x << std::endl; }
@@ -13,595 +19,2852 @@ namespace matchem {
 Matchem::Matchem(const MatchemConfig& config) :
 ////////////////////////////////////////////////////////////////////////////////
   m_config(config),
-  m_policy(ExeSpaceUtils<>::get_default_team_policy(m_config.num_runs())),
+  m_policy(ExeSpaceUtils<>::get_default_team_policy(get_num_games(m_config), get_team_size(m_config))),
   m_tu(m_policy),
-  m_game_state("m_game_state", m_tu.get_num_concurrent_teams(), SIZE),
+  m_num_ws(get_num_game_ws() * (m_config.strategy() == BANDIT ? 2 : 1)),
+  m_split{m_tu.get_num_concurrent_teams(), 1},
+  m_perf(),
+  m_game_state("m_game_state", m_num_ws, SIZE),
 #ifdef EXTRA_TRACKING
-  m_full_info( "m_full_info",  m_tu.get_num_concurrent_teams(), SIZE, MAX_ROUNDS),
-  m_round_info("m_round_info", m_tu.get_num_concurrent_teams(), MAX_ROUNDS),
-  m_odds_info( "m_odds_info",  m_tu.get_num_concurrent_teams(), SIZE, SIZE),
+  m_full_info( "m_full_info",  m_num_ws, SIZE, MAX_ROUNDS),
+  m_round_info("m_round_info", m_num_ws, MAX_ROUNDS),
+  m_odds_info( "m_odds_info",  m_num_ws, SIZE, SIZE),
+  m_row_best("m_row_best", m_num_ws, SIZE),
+  m_row_best_odds("m_row_best_odds", m_num_ws, SIZE),
+  m_query_tree("m_query_tree", m_num_ws, 2*QUERY_TREE_LEAVES),
+  m_dirty_rows("m_dirty_rows", m_num_ws),
+#endif
+  m_known_info("m_known_info", m_num_ws, SIZE),
+  m_guess_state("m_guess_state", m_num_ws, SIZE),
+  m_guess_pick("m_guess_pick", m_num_ws, SIZE),
+  m_guess_taken("m_guess_taken", m_num_ws, SIZE),
+  m_guess_dirty_rows("m_guess_dirty_rows", m_num_ws),
+  m_guess_rows_touched("m_guess_rows_touched", m_num_ws),
+  m_guess_builds("m_guess_builds", m_num_ws),
+  m_rook_ws("m_rook_ws", m_num_ws, match_count_dist_ws_size<SIZE>()),
+  m_history("m_history", m_num_ws),
+  m_rng_state("m_rng_state", m_num_ws),
+  m_rng_seed(0),
+  m_zobrist("m_zobrist", m_num_ws),
+  m_cache_hits("m_cache_hits", m_num_ws),
+  m_cache_misses("m_cache_misses", m_num_ws),
+  m_tree_lookups("m_tree_lookups", m_num_ws),
+  m_tree_computes("m_tree_computes", m_num_ws),
+  m_bandit_decisions("m_bandit_decisions", m_num_ws),
+  m_bandit_rollouts("m_bandit_rollouts", m_num_ws),
+#ifdef TELEMETRY
+  m_telemetry("m_telemetry", m_num_ws),
 #endif
-  m_known_info("m_known_info", m_tu.get_num_concurrent_teams(), SIZE),
-  m_guess_state("m_guess_state", m_tu.get_num_concurrent_teams(), SIZE)
+#ifdef PHASE_PROFILING
+  m_profile("m_profile", m_num_ws),
+  m_sections(),
+#endif
+  m_budget_used("m_budget_used", m_num_ws),
+  m_budget_decisions("m_budget_decisions", m_num_ws),
+  m_budget_deadlines("m_budget_deadlines", m_num_ws),
+  m_budget_cycles(DecisionBudget::UNLIMITED),
+  m_replay_games("m_replay_games", m_config.replay_games().size()),
+  m_track_curves(!m_config.curves_file().empty()),
+  m_policy_table(),
+  m_model(),
+  m_book(),
+  m_cache(),
+  m_tree()
 {
-  std::cout << "Running with " << m_tu.get_num_concurrent_teams() << " concurrent teams" << std::endl;
+  configure();
+
+  std::cout << "Running with " << m_tu.get_num_concurrent_teams() << " concurrent teams";
+  if (m_policy.team_size() > 1) {
+    std::cout << " of " << m_policy.team_size() << " threads";
+  }
+  std::cout << std::endl;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void Matchem::run()
+void Matchem::reconfigure(const MatchemConfig& config)
 ////////////////////////////////////////////////////////////////////////////////
 {
-  const auto start = std::chrono::steady_clock::now();
-  int total_rounds = 0;
-  Kokkos::parallel_reduce("Matchem::run", m_policy, KOKKOS_LAMBDA(const MemberType& team, int& rounds) {
-    const int ws_idx = m_tu.get_workspace_idx(team);
-
-    init_indv(ws_idx);
-    rounds += run_indv(ws_idx);
-
-    m_tu.release_workspace_idx(team, ws_idx);
-  }, total_rounds);
-
-  std::cout << static_cast<double>(total_rounds) / m_config.num_runs() << " avg rounds per game" << std::endl;
+  // Workspaces, the cache and the tree are kept, so they must suit the new config
+  my_require(config.strategy() != BANDIT || m_num_ws > get_num_game_ws(),
+             "These workspaces were not sized for bandit");
+  my_require(get_team_size(config) == m_policy.team_size(), "The bandit threads can not be changed");
+  my_require(config.replay_games().empty() && m_replay_games.extent(0) == 0, "Replays can not be reconfigured");
+  my_require(config.decision_cache_mb() == m_config.decision_cache_mb() &&
+             config.huge_pages() == m_config.huge_pages() &&
+             config.decision_tree_mb() == m_config.decision_tree_mb(),
+             "The decision cache and tree can not be resized");
+
+  m_config = config;
+  m_track_curves = !m_config.curves_file().empty();
+  m_budget_cycles = DecisionBudget::UNLIMITED;
+  reset_counters();
+
+  configure();
+}
 
-  const auto finish = std::chrono::steady_clock::now();
-  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
-  const double report_time = 1e-6*duration.count();
-  std::cout << "Simulation took " << report_time << " seconds" << std::endl;
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::reset_counters()
+////////////////////////////////////////////////////////////////////////////////
+{
+  for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+    m_guess_rows_touched(ws_idx) = 0;
+    m_guess_builds(ws_idx)       = 0;
+    m_cache_hits(ws_idx)         = 0;
+    m_cache_misses(ws_idx)       = 0;
+    m_tree_lookups(ws_idx)       = 0;
+    m_tree_computes(ws_idx)      = 0;
+    m_bandit_decisions(ws_idx)   = 0;
+    m_bandit_rollouts(ws_idx)    = 0;
+    m_budget_used(ws_idx)        = 0;
+    m_budget_decisions(ws_idx)   = 0;
+    m_budget_deadlines(ws_idx)   = 0;
+#ifdef TELEMETRY
+    m_telemetry(ws_idx).reset();
+#endif
+#ifdef PHASE_PROFILING
+    m_profile(ws_idx).reset();
+#endif
+  }
+  if (m_perf) {
+    m_perf->reset();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-int Matchem::run_indv(const int ws_idx)
+void Matchem::configure()
 ////////////////////////////////////////////////////////////////////////////////
 {
-  auto my_state = matchem::subview(m_game_state, ws_idx);
-  int rounds = 0;
-  int matches = 0;
+  if (m_config.strategy() == OPTIMAL) {
+    my_require(SIZE <= MatchemSolver::MAX_SIZE,
+               "Optimal strategy plays policies of solve mode, which solves set sizes up to " +
+               obj_to_str(MatchemSolver::MAX_SIZE) + ", but this build plays set size " + obj_to_str(static_cast<int>(SIZE)) +
+               " (MatchemConfig::SET_SIZE)");
+    my_require(!m_config.policy_file().empty(), "Optimal strategy requires a policy file");
+    m_policy_table.load(m_config.policy_file(), SIZE);
+  }
 
-  do {
-    assert(rounds < MAX_ROUNDS);
+  if (m_config.strategy() == DISTILLED || m_config.sim_type() == DISTILL) {
+#ifdef EXTRA_TRACKING
+    my_require(!m_config.model_file().empty(), "Distilled strategy requires a model file");
+    if (m_config.strategy() == DISTILLED) {
+      m_model.load(m_config.model_file(), SIZE);
+    }
+#else
+    my_require(false, "Distilled strategy requires EXTRA_TRACKING");
+#endif
+  }
 
-    ask_truth(ws_idx, rounds);
+  if (m_config.strategy() == BANDIT) {
+    my_require(m_config.bandit_rollouts() > 0, "The bandit needs at least one rollout per decision");
+    my_require(m_config.bandit_candidates() > 0 && m_config.bandit_candidates() <= MAX_BANDIT_ARMS,
+               "BANDIT candidates must be between 1 and " + obj_to_str(static_cast<int>(MAX_BANDIT_ARMS)));
+    my_require(m_config.bandit_exploration() >= 0.0, "Bandit exploration can not be negative");
+    // The threads of a team must make the same decisions, a cache shared with
+    // other teams could answer some of them and not others
+    my_require(m_policy.team_size() == 1 || m_config.decision_cache_mb() == 0,
+               "The decision cache can not be used with more than one bandit thread");
+
+    m_rng_seed = std::rand();
+  }
 
-    make_guess(ws_idx, rounds);
+  if (m_config.sim_type() == BUILD_BOOK) {
+    my_require(!m_config.book_file().empty(), "Building an opening book requires a book file");
+    my_require(m_config.book_depth() > 0 && m_config.book_depth() < MAX_ROUNDS, "Bad opening book depth");
+  }
+  else if (!m_config.book_file().empty()) {
+    m_book.open(m_config.book_file(), SIZE, get_strategy_tag());
+  }
 
-    matches = get_num_matches(ws_idx);
+  if (m_config.decision_cache_mb() > 0) {
+    if (m_cache.enabled()) {
+      // Reconfigured, the old decisions may not be this strategy's
+      m_cache.clear();
+    }
+    else {
+      m_cache.init(static_cast<size_t>(m_config.decision_cache_mb()) << 20, m_config.huge_pages());
+      std::cout << "Decision cache has " << m_cache.num_slots() << " slots"
+                << (m_cache.has_huge_pages() ? " on huge pages" : "") << std::endl;
+    }
+  }
 
-    process_guess_result(ws_idx, rounds, matches);
+  if (m_config.sim_type() == EXACT) {
+    my_require(m_config.strategy() != BANDIT, "Exact mode requires a deterministic strategy");
+  }
 
-    vprint("At end of round " << rounds << ", game state is:\n" << *this);
+  for (const int budget : m_config.decision_budgets_us()) {
+    my_require(budget >= 0, "Decision budgets can not be negative");
+  }
 
-    ++rounds;
-  } while(matches < SIZE);
+  for (const int limit : m_config.season_limits()) {
+    my_require(limit > 0, "Season limits must be positive");
+  }
 
-  return rounds;
-}
+#ifndef TELEMETRY
+  my_require(m_config.telemetry_file().empty(), "Telemetry requires a build configured with -DTELEMETRY=ON");
+#endif
 
-////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-void Matchem::init_indv(const int ws_idx)
-////////////////////////////////////////////////////////////////////////////////
-{
-  auto my_state = matchem::subview(m_game_state, ws_idx);
-  auto my_guess = matchem::subview(m_guess_state, ws_idx);
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
+  my_require(m_config.checkpoint_file().empty() || m_config.sim_type() == EXACT,
+             "Only exact mode can be checkpointed");
 
-  for (int i = 0; i < SIZE; ++i) {
-    my_state(i) = i;
-    my_guess(i) = -1;
-    my_info(i)  = 0;
+  if (m_config.target_ci() > 0.0) {
+    my_require((m_config.sim_type() == BASIC || m_config.sim_type() == TOURNAMENT) &&
+               m_config.replay_games().empty() && m_config.decision_budgets_us().empty(),
+               "A target CI is only for basic or tournament mode with random games and no decision budgets");
+    my_require(m_config.max_runs() > 0, "The cap on games must be positive");
   }
 
-  std::random_shuffle(&my_state(0), &my_state(0) + SIZE);
+  if (!m_config.replay_games().empty()) {
+    my_require(m_config.sim_type() == BASIC, "Replaying games is only for basic mode");
+    for (size_t g = 0; g < m_config.replay_games().size(); ++g) {
+      const int game = m_config.replay_games()[g];
+      my_require(game >= 0 && game < factorial(SIZE), "Bad game to replay: " + obj_to_str(game));
+      m_replay_games(g) = game;
+    }
+  }
 
+  if (m_track_curves) {
 #ifdef EXTRA_TRACKING
-  auto my_full_info  = matchem::subview(m_full_info, ws_idx);
-  auto my_round_info = matchem::subview(m_round_info, ws_idx);
-  auto my_odds_info  = matchem::subview(m_odds_info, ws_idx);
-
-  for (int i = 0; i < MAX_ROUNDS; ++i) {
-    my_round_info(i) = -1;
+    // Games that walk the tree do not keep their workspace up to date
+    my_require(m_config.decision_tree_mb() == 0, "Curves can not be tracked with a decision tree");
+#else
+    my_require(false, "Curves require EXTRA_TRACKING");
+#endif
   }
 
-  for (int i = 0; i < SIZE; ++i) {
-    for (int r = 0; r < MAX_ROUNDS; ++r) {
-      my_full_info(i, r) = -1;
+  if (m_config.decision_tree_mb() > 0) {
+    // Games that walk the tree never ask the strategy, so it must give the
+    // same decision every time it sees the same observations
+    my_require(m_config.strategy() != BANDIT, "The decision tree requires a deterministic strategy");
+    const size_t capacity = (static_cast<size_t>(m_config.decision_tree_mb()) << 20) / sizeof(decision_tree_t::Node);
+    my_require(capacity <= static_cast<size_t>(std::numeric_limits<int32_t>::max()), "Decision tree is too big");
+    if (m_tree.enabled()) {
+      m_tree.clear();
     }
-    for (int j = 0; j < SIZE; ++j) {
-      my_odds_info(i, j) = 1.0/SIZE;
+    else {
+      m_tree.init(capacity);
     }
+    seed_tree();
   }
-#endif
-}
-
-////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-int Matchem::get_num_matches(const int ws_idx) const
-////////////////////////////////////////////////////////////////////////////////
-{
-  auto my_state = matchem::subview(m_game_state, ws_idx);
-  auto my_guess = matchem::subview(m_guess_state, ws_idx);
 
-  int result = 0;
-  for (int i = 0; i < SIZE; ++i) {
-    if (my_state(i) == my_guess(i)) {
-      ++result;
+  const int max_workers = m_tu.get_num_concurrent_teams();
+  my_require(m_config.threads() >= 0 && m_config.games_per_item() >= 0,
+             "Threads and games per work item can not be negative");
+  m_split.workers = m_config.threads() > 0 ? std::min(m_config.threads(), max_workers) : max_workers;
+  m_split.games_per_item = m_config.games_per_item() > 0 ? m_config.games_per_item() : 1;
+
+  // What was asked for wins over what the probe would pick
+  const std::string& calibration_file = m_config.calibration_file();
+  if (!calibration_file.empty() && m_config.threads() == 0 && m_config.games_per_item() == 0) {
+    my_require(m_config.sim_type() == BASIC || m_config.sim_type() == EXACT || m_config.sim_type() == SWEEP,
+               "Calibration is only for basic, exact and sweep mode");
+    const std::string key = calibration_key();
+    if (load_calibration(calibration_file, key, m_split)) {
+      m_split.workers = std::min(m_split.workers, max_workers);
+      std::cout << "Using the calibration";
     }
+    else {
+      m_split = calibrate();
+      save_calibration(calibration_file, key, m_split);
+      std::cout << "Calibrated";
+    }
+    std::cout << " for " << key << ": " << m_split.workers << " threads, " << m_split.games_per_item
+              << " games per work item" << std::endl;
   }
 
-  return result;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-void Matchem::ask_truth(const int ws_idx, const int round)
-////////////////////////////////////////////////////////////////////////////////
-{
-  auto my_state = matchem::subview(m_game_state, ws_idx);
-
-  const auto query = get_best_truth_query(ws_idx, round);
-  const int side1_idx(query.first), side2_idx(query.second);
-  assert(side1_idx != -1 && side2_idx != -1);
-
-  // make the ask!
-  const bool is_match = my_state(side1_idx) == side2_idx;
-
-  process_ask_result(ws_idx, round, side1_idx, side2_idx, is_match);
+  m_perf.reset();
+  if (!m_config.perf_counters().empty()) {
+    my_require(m_config.sim_type() == BASIC || m_config.sim_type() == EXACT,
+               "Perf counters are only for basic and exact mode");
+    m_perf.reset(new PerfCounters(m_config.perf_counters(), max_workers));
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-Matchem::MatchState Matchem::get_state(const int ws_idx, const int side1, const int side2) const
+void Matchem::run()
 ////////////////////////////////////////////////////////////////////////////////
 {
-  static_assert(sizeof(int) == sizeof(int16_t)*2, "Incompatible int sizes");
-  static_assert(SIZE <= 16, "SIZE too big to fit into int16_t bitmask");
-
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
-
-  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
-  const int16_t known_matches = pieces[0];
-  const int16_t known_misses  = pieces[1];
+  const auto start = std::chrono::steady_clock::now();
+  const bool exact = m_config.sim_type() == EXACT;
+  const int num_games = get_num_games(m_config);
 
-  if (is_setb(known_matches, side2)) {
-    assert(!is_setb(known_misses, side2));
-    return YES_MATCH;
-  }
-  else if (is_setb(known_misses, side2)) {
-    assert(!is_setb(known_matches, side2));
-    return NO_MATCH;
+  // The phases nest in this region for an attached Kokkos tool
+  Kokkos::Profiling::pushRegion("Matchem::run");
+  if (!m_config.decision_budgets_us().empty()) {
+    run_budgets();
   }
   else {
-    return UNKNOWN_MATCH;
+    const RunStats stats = exact ? play_exhaustive() : m_config.target_ci() > 0.0 ? play_to_target() : play_games();
+    if (exact) {
+      std::cout << "Exact expected rounds over all " << num_games << " hidden states: " << stats.rounds.sum << "/"
+                << num_games << " = " << std::setprecision(10) << stats.rounds.mean() << std::setprecision(6)
+                << std::endl;
+    }
+    else {
+      std::cout << stats.rounds.mean() << " avg rounds per game" << std::endl;
+    }
+    report_stats(stats);
   }
-}
+  Kokkos::Profiling::popRegion();
 
-////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-void Matchem::set_state(const int ws_idx, const int side1, const int side2, const MatchState state)
-////////////////////////////////////////////////////////////////////////////////
-{
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
+  if (m_cache.enabled()) {
+    uint64_t hits = 0, misses = 0;
+    for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+      hits   += m_cache_hits(ws_idx);
+      misses += m_cache_misses(ws_idx);
+    }
+    std::cout << "Decision cache: " << hits << " hits, " << misses << " misses, "
+              << (hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0) << "% hit rate" << std::endl;
+  }
 
-#ifndef NDEBUG
-  const int before_num_pot_matches = get_num_pot_matches(ws_idx, side1);
+#ifdef TELEMETRY
+  Telemetry telemetry;
+  for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+    telemetry.merge(m_telemetry(ws_idx));
+  }
+  std::cout << "Telemetry (bandit rollouts and the copies of games on team threads included):\n";
+  telemetry.print(std::cout);
+  if (!m_config.telemetry_file().empty()) {
+    telemetry.write_json(m_config.telemetry_file());
+    std::cout << "Wrote telemetry to " << m_config.telemetry_file() << std::endl;
+  }
 #endif
 
-  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
-  int16_t& known_matches = pieces[0];
-  int16_t& known_misses  = pieces[1];
+#ifdef PHASE_PROFILING
+  PhaseProfile profile;
+  for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+    profile.merge(m_profile(ws_idx));
+  }
+  std::cout << "Time per phase (bandit rollouts excluded):\n";
+  profile.print(std::cout);
+#endif
 
-  assert(state != UNKNOWN_MATCH);
+  if (m_perf) {
+    m_perf->report(std::cout);
+  }
 
-  assert(!is_setb(known_matches, side2));
-  assert(!is_setb(known_misses, side2));
+#ifdef INCREMENTAL_GUESS
+  uint64_t rows_touched = 0, builds = 0;
+  for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+    rows_touched += m_guess_rows_touched(ws_idx);
+    builds       += m_guess_builds(ws_idx);
+  }
+  if (builds > 0) {
+    std::cout << "Heuristic guesses recomputed " << static_cast<double>(rows_touched) / builds << " of " << SIZE
+              << " rows per round on average" << std::endl;
+  }
+#endif
 
-  if (state == YES_MATCH) {
-    setb(known_matches, side2);
-    for (int j = 0; j < SIZE; ++j) {
-      if (j != side2) {
-        setb(known_misses, j);
-      }
+  if (m_config.strategy() == BANDIT) {
+    uint64_t decisions = 0, rollouts = 0;
+    for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+      decisions += m_bandit_decisions(ws_idx);
+      rollouts  += m_bandit_rollouts(ws_idx);
     }
+    std::cout << "Bandit: " << decisions << " decisions, "
+              << (decisions > 0 ? static_cast<double>(rollouts) / decisions : 0.0) << " rollouts per decision"
+              << std::endl;
+  }
 
-    // no other items can match to this j
-    for (int i = 0; i < SIZE; ++i) {
-      if (i != side1) {
-        int16_t* other_pieces       = reinterpret_cast<int16_t*>(&my_info(i));
-        int16_t& other_known_misses = other_pieces[1];
-
-        setb(other_known_misses, side2);
-      }
+  if (m_tree.enabled()) {
+    uint64_t lookups = 0, computes = 0;
+    for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+      lookups  += m_tree_lookups(ws_idx);
+      computes += m_tree_computes(ws_idx);
     }
-
-    assert(get_num_pot_matches(ws_idx, side1) == 1);
+    std::cout << "Decision tree: " << m_tree.num_nodes() << " nodes ("
+              << (m_tree.num_nodes() * sizeof(decision_tree_t::Node)) / (1024.0 * 1024.0) << " MB), "
+              << (lookups + computes > 0 ? 100.0 * lookups / (lookups + computes) : 0.0) << "% of decisions looked up"
+              << (m_tree.num_nodes() == m_tree.capacity() ? ", tree is full" : "") << std::endl;
   }
-  else {
-    assert(state == NO_MATCH);
-
-    setb(known_misses, side2);
 
-    assert(get_num_pot_matches(ws_idx, side1) == before_num_pot_matches - 1);
-  }
+  const auto finish = std::chrono::steady_clock::now();
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+  const double report_time = 1e-6*duration.count();
+  std::cout << "Simulation took " << report_time << " seconds" << std::endl;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-bool Matchem::has_match(const int ws_idx, const int side1) const
+RunStats Matchem::play_games()
 ////////////////////////////////////////////////////////////////////////////////
 {
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
-
-  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
-  const int16_t known_matches = pieces[0];
-
-  return known_matches != 0;
+  return play_games(0, get_num_games(m_config));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-int Matchem::get_match(const int ws_idx, const int side1) const
+template <typename PlayGame>
+RunStats Matchem::play_split(const WorkSplit& split, const int num_games, const PlayGame& play_game)
 ////////////////////////////////////////////////////////////////////////////////
 {
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
+  const int per_item = split.games_per_item;
+  const int workers = std::min(split.workers, (num_games + per_item - 1) / per_item);
+  int next_game = 0;
+  int* next = &next_game;
+  PerfCounters* perf = m_perf.get();
+
+  // Games differ a lot in length, so workers take the next item as they
+  // finish one
+  const auto policy = ExeSpaceUtils<>::get_default_team_policy(workers, m_policy.team_size());
+  RunStats stats;
+  Kokkos::parallel_reduce("Matchem::run", policy, KOKKOS_LAMBDA(const MemberType& team, RunStats& local) {
+    const int slot = m_tu.get_workspace_idx(team);
+    const int ws_idx = get_team_ws(team, slot);
+    const bool leader = team.team_rank() == 0;
+
+    // The other threads of the team play copies of the same games, which
+    // must not be counted again
+    RunStats copies;
+    RunStats& mine = leader ? local : copies;
+
+    // Counters are opened on the thread that plays, they count it only
+    const int64_t games_before = mine.rounds.count;
+    const int64_t rounds_before = mine.rounds.sum;
+    if (perf != nullptr && leader) {
+      perf->start(slot);
+    }
 
-  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
-  const int16_t known_matches = pieces[0];
+    for (int first = take_games(team, next, per_item); first < num_games; first = take_games(team, next, per_item)) {
+      const int last = first + per_item < num_games ? first + per_item : num_games;
+      for (int game = first; game < last; ++game) {
+        play_game(team, ws_idx, game, mine);
+      }
+    }
 
-  for (int j = 0; j < SIZE; ++j) {
-    if (is_setb(known_matches, j)) {
-      return j;
+    if (perf != nullptr && leader) {
+      perf->stop(slot, mine.rounds.count - games_before, mine.rounds.sum - rounds_before);
     }
-  }
+    m_tu.release_workspace_idx(team, slot);
+  }, StatsReducer<RunStats>(stats));
 
-  assert(false); // no match
-  return -1;
+  return stats;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-int Matchem::get_first_pot_match(const int ws_idx, const int side1) const
+RunStats Matchem::play_games(const int first_game, const int num_games)
 ////////////////////////////////////////////////////////////////////////////////
 {
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
-
-  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
-  const int16_t known_misses = pieces[1];
-
-  for (int j = 0; j < SIZE; ++j) {
-    if (!is_setb(known_misses, j)) {
-      return j;
+  assert(first_game >= 0 && first_game + num_games <= get_num_games(m_config));
+
+  const bool exact = m_config.sim_type() == EXACT;
+  const bool replay = m_replay_games.extent(0) > 0;
+  const bool fused = can_fuse();
+  const double ns_per_tick = 1e3 / cycles_per_usec();
+  return play_split(m_split, num_games, KOKKOS_LAMBDA(const MemberType& team, const int ws_idx, const int split_game,
+                                                      RunStats& local) {
+    const int game = first_game + split_game;
+    const uint64_t start = read_cycles();
+
+    if (exact) {
+      init_indv_exact(ws_idx, game);
     }
-  }
+    else if (replay) {
+      init_indv_exact(ws_idx, m_replay_games(game));
+    }
+    else if (team.team_rank() == 0) {
+      init_indv(ws_idx); // the others copy it, drawing their own would change the games
+    }
+    const int rounds = play_indv(ws_idx, fused, m_track_curves ? &local.curves : nullptr, &team);
 
-  assert(false);
-  return -1;
+    const uint64_t ns = static_cast<uint64_t>((read_cycles() - start) * ns_per_tick);
+    local.rounds.add(rounds);
+    local.latency.add(ns, local.latency.is_slow(ns) ? get_game_id(ws_idx) : -1);
+  });
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-int Matchem::get_first_pot_back_match(const int ws_idx, const int side2) const
+RunStats Matchem::play_exhaustive()
 ////////////////////////////////////////////////////////////////////////////////
 {
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
-
-  for (int i = 0; i < SIZE; ++i) {
-    int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(i));
-    const int16_t known_misses = pieces[1];
+  const int num_games = get_num_games(m_config);
+  const std::string& checkpoint = m_config.checkpoint_file();
+
+  RunStats stats;
+  int next_game = 0;
+  if (!checkpoint.empty() && std::ifstream(checkpoint).good()) {
+    next_game = load_checkpoint(checkpoint, stats.rounds);
+    std::cout << "Resuming from " << checkpoint << " at game " << next_game << " of " << num_games
+              << ", times and curves only cover the games played from here" << std::endl;
+  }
 
-    if (!is_setb(known_misses, side2)) {
-      return i;
+  // Chunks bound the work lost to an interruption
+  while (next_game < num_games) {
+    const int chunk = std::min(EXACT_CHUNK, num_games - next_game);
+    stats.merge(play_games(next_game, chunk));
+    next_game += chunk;
+    if (!checkpoint.empty()) {
+      save_checkpoint(checkpoint, next_game, stats.rounds);
     }
   }
 
-  assert(false);
-  return -1;
+  return stats;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-int Matchem::get_num_pot_matches(const int ws_idx, const int side1) const
+void Matchem::save_checkpoint(const std::string& filename, const int next_game, const SimStats& stats) const
 ////////////////////////////////////////////////////////////////////////////////
 {
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
-
-  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
-  const int16_t known_misses = pieces[1];
-
-  int result = 0;
-  for (int j = 0; j < SIZE; ++j) {
-    if (!is_setb(known_misses, j)) {
-      ++result;
-    }
+  // Write it aside and move it over the old one, so an interruption never
+  // leaves a half-written checkpoint behind
+  const std::string tmp_filename = filename + ".tmp";
+  {
+    std::ofstream out(tmp_filename);
+    my_require(out.good(), "Could not write checkpoint file: " + tmp_filename);
+    out << "size " << SIZE << " strategy " << m_config.strategy() << " next " << next_game << "\n";
+    stats.save(out);
+    my_require(out.good(), "Could not write checkpoint file: " + tmp_filename);
   }
-
-  return result;
+  my_require(std::rename(tmp_filename.c_str(), filename.c_str()) == 0, "Could not replace checkpoint file: " + filename);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-int Matchem::get_num_pot_back_matches(const int ws_idx, const int side2) const
+int Matchem::load_checkpoint(const std::string& filename, SimStats& stats) const
 ////////////////////////////////////////////////////////////////////////////////
 {
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
+  std::ifstream in(filename);
+  my_require(in.good(), "Could not open checkpoint file: " + filename);
+
+  std::string size_tag, strategy_tag, next_tag;
+  int size = 0, strategy = -1, next_game = -1;
+  in >> size_tag >> size >> strategy_tag >> strategy >> next_tag >> next_game;
+  my_require(size_tag == "size" && strategy_tag == "strategy" && next_tag == "next" && !in.fail(),
+             "Bad checkpoint file: " + filename);
+  my_require(size == SIZE && strategy == m_config.strategy(),
+             "Checkpoint file " + filename + " is for another set size or strategy");
+  my_require(next_game >= 0 && next_game <= get_num_games(m_config), "Bad checkpoint file: " + filename);
+
+  stats.load(in);
+  my_require(stats.count == next_game, "Bad checkpoint file: " + filename);
+  return next_game;
+}
 
-  int result = 0;
-  for (int i = 0; i < SIZE; ++i) {
+////////////////////////////////////////////////////////////////////////////////
+Matchem::WorkSplit Matchem::calibrate()
+////////////////////////////////////////////////////////////////////////////////
+{
+  // Fractions of the threads and games per work item to try, and about how
+  // long each try plays
+  constexpr int WORKER_DIVISORS[] = {1, 2, 4};
+  constexpr int GAMES_PER_ITEM[]  = {1, 4, 16, 64};
+  constexpr double PROBE_SECONDS  = 0.05;
+  constexpr int MAX_PROBE_GAMES   = 1 << 16;
+  constexpr uint64_t PROBE_SEED   = 0x9e3779b97f4a7c15ULL;
+
+  // Probe games are hidden states drawn from their index, so they never
+  // take random numbers from the run's games
+  const int64_t num_states = factorial(SIZE);
+  const bool fused = can_fuse();
+  const auto probe = [&](const WorkSplit& split, const int num_games) {
+    const auto start = std::chrono::steady_clock::now();
+    play_split(split, num_games, KOKKOS_LAMBDA(const MemberType& team, const int ws_idx, const int game, RunStats& local) {
+      Rng rng(hash_combine(PROBE_SEED, game));
+      init_indv_exact(ws_idx, static_cast<int>(rng.below(num_states)));
+      local.rounds.add(play_indv(ws_idx, fused, nullptr, &team));
+    });
+    const auto finish = std::chrono::steady_clock::now();
+    return 1e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count();
+  };
+
+  // One game per thread warms up and says how many games fill a try
+  const int max_workers = m_tu.get_num_concurrent_teams();
+  WorkSplit best{max_workers, 1};
+  const double pilot = std::max(probe(best, max_workers), 1e-6);
+  const int num_games = std::max(max_workers, std::min(MAX_PROBE_GAMES,
+                                                       static_cast<int>(PROBE_SECONDS * max_workers / pilot)));
+
+  double best_seconds = probe(best, num_games);
+  int last_workers = 0;
+  for (const int divisor : WORKER_DIVISORS) {
+    const int workers = std::max(1, max_workers / divisor);
+    if (workers == last_workers) {
+      continue;
+    }
+    last_workers = workers;
+    for (const int per_item : GAMES_PER_ITEM) {
+      // Every worker needs a few items or the try only measures the tail
+      if ((workers == max_workers && per_item == 1) || workers * per_item * 4 > num_games) {
+        continue;
+      }
+      const WorkSplit split{workers, per_item};
+      const double seconds = probe(split, num_games);
+      if (seconds < best_seconds) {
+        best = split;
+        best_seconds = seconds;
+      }
+    }
+  }
+
+  if (m_cache.enabled()) {
+    m_cache.clear();
+  }
+  if (m_tree.enabled()) {
+    m_tree.clear();
+    seed_tree();
+  }
+  reset_counters();
+
+  return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string Matchem::calibration_key() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  char host[256] = {0};
+  if (gethostname(host, sizeof(host) - 1) != 0 || host[0] == 0) {
+    std::snprintf(host, sizeof(host), "unknown");
+  }
+
+#ifdef EXTRA_TRACKING
+  const char* tracking = "full";
+#else
+  const char* tracking = "lean";
+#endif
+
+  // Fields are separated by slashes, the file separates keys by whitespace
+  std::ostringstream key;
+  key << host << "/" << Kokkos::DefaultExecutionSpace::name() << "/" << m_tu.get_num_concurrent_teams()
+      << "-threads/size-" << SIZE << "/" << tracking << "/" << strategy_name(m_config.strategy());
+  if (m_config.strategy() == BANDIT) {
+    key << "-" << m_config.bandit_rollouts() << "x" << m_config.bandit_candidates();
+  }
+  if (m_config.decision_cache_mb() > 0) {
+    key << "/cache-" << m_config.decision_cache_mb();
+  }
+  if (m_config.decision_tree_mb() > 0) {
+    key << "/tree-" << m_config.decision_tree_mb();
+  }
+  return key.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Matchem::load_calibration(const std::string& filename, const std::string& key, WorkSplit& split)
+////////////////////////////////////////////////////////////////////////////////
+{
+  // One line per calibration, the last one for a key wins
+  std::ifstream in(filename);
+  if (!in.good()) {
+    return false;
+  }
+  bool found = false;
+  std::string line_key;
+  WorkSplit line_split;
+  while (in >> line_key >> line_split.workers >> line_split.games_per_item) {
+    if (line_key == key) {
+      my_require(line_split.workers > 0 && line_split.games_per_item > 0, "Bad calibration file: " + filename);
+      split = line_split;
+      found = true;
+    }
+  }
+  my_require(in.eof(), "Bad calibration file: " + filename);
+  return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::save_calibration(const std::string& filename, const std::string& key, const WorkSplit& split)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ofstream out(filename, std::ios::app);
+  my_require(out.good(), "Could not write calibration file: " + filename);
+  out << key << " " << split.workers << " " << split.games_per_item << "\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RunStats Matchem::play_to_target()
+////////////////////////////////////////////////////////////////////////////////
+{
+  const double target = m_config.target_ci();
+  const int max_games = get_num_games(m_config);
+  const int min_batch = std::min(max_games, std::max(MIN_CI_BATCH, m_tu.get_num_concurrent_teams()));
+
+  // Plan each batch to be the last one: the spread so far says how many games
+  // the target needs in total. Stop short of that on the cap.
+  RunStats stats;
+  int batch = min_batch;
+  while (true) {
+    stats.merge(play_games(stats.rounds.count, batch));
+
+    const SimStats& rounds = stats.rounds;
+    std::cout << "After " << rounds.count << " games: " << rounds.mean() << " +/- " << rounds.ci95() << std::endl;
+    if (rounds.ci95() <= target || rounds.count >= max_games) {
+      break;
+    }
+
+    const double needed = std::pow(1.96 * rounds.stddev() / target, 2);
+    const int64_t remaining = max_games - rounds.count;
+    batch = static_cast<int>(std::min<double>(remaining, std::max<double>(min_batch, needed - rounds.count)));
+  }
+
+  if (stats.rounds.ci95() > target) {
+    std::cout << "Stopped at the cap of " << max_games << " games before reaching the target CI of +/- " << target
+              << std::endl;
+  }
+  return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::report_stats(const RunStats& stats) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::cout << stats.rounds << std::endl;
+  for (const int limit : m_config.season_limits()) {
+    std::cout << "P(rounds <= " << limit << "): " << stats.rounds.prob_within(limit) << std::endl;
+  }
+  std::cout << stats.latency << std::endl;
+  if (m_track_curves) {
+    stats.curves.write_csv(m_config.curves_file());
+    std::cout << "Wrote per-round curves to " << m_config.curves_file() << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::run_budgets()
+////////////////////////////////////////////////////////////////////////////////
+{
+  // Every budget plays the same hidden states: game n is the same state for
+  // all of them, drawn from n (or replayed, or permutation n in exact mode),
+  // and init_indv_exact restarts the random stream of the bandit from it, so
+  // the rounds of a game can be paired across budgets
+  const uint64_t seed = std::rand();
+  const int num_games = get_num_games(m_config);
+  const int64_t num_states = factorial(SIZE);
+  const bool exact = m_config.sim_type() == EXACT;
+  const bool replay = m_replay_games.extent(0) > 0;
+  const bool fused = can_fuse();
+  const double ticks_per_usec = cycles_per_usec();
+
+  std::vector<int> first_rounds, rounds(num_games);
+  int* game_rounds = rounds.data();
+
+  std::cout << std::setw(12) << "budget (us)" << std::setw(12) << "avg rounds" << std::setw(14) << "avg used (us)"
+            << std::setw(14) << "deadline hit" << std::setw(12) << "games/s" << std::setw(22) << "vs first (95% CI)"
+            << std::endl;
+
+  for (const int budget_us : m_config.decision_budgets_us()) {
+    m_budget_cycles = budget_us == 0 ? DecisionBudget::UNLIMITED : static_cast<uint64_t>(budget_us * ticks_per_usec);
+    for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+      m_budget_used(ws_idx)      = 0;
+      m_budget_decisions(ws_idx) = 0;
+      m_budget_deadlines(ws_idx) = 0;
+    }
+
+    // A budget must not reuse decisions taken under another one
+    if (m_cache.enabled()) {
+      m_cache.clear();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const SimStats stats = play_split(m_split, num_games, KOKKOS_LAMBDA(const MemberType& team, const int ws_idx,
+                                                                        const int game, RunStats& local) {
+      const int state = exact ? game : replay ? m_replay_games(game) :
+        static_cast<int>(Rng(hash_combine(seed, game)).below(num_states));
+      init_indv_exact(ws_idx, state);
+      const int played = play_indv(ws_idx, fused, nullptr, &team);
+      if (team.team_rank() == 0) {
+        game_rounds[game] = played;
+      }
+      local.rounds.add(played);
+    }).rounds;
+    const auto finish = std::chrono::steady_clock::now();
+    const double seconds = 1e-6*std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+
+    uint64_t used = 0, decisions = 0, deadlines = 0;
+    for (int ws_idx = 0; ws_idx < m_num_ws; ++ws_idx) {
+      used      += m_budget_used(ws_idx);
+      decisions += m_budget_decisions(ws_idx);
+      deadlines += m_budget_deadlines(ws_idx);
+    }
+
+    // Unlimited budgets do not time their decisions
+    std::cout << std::setw(12) << (budget_us == 0 ? std::string("none") : obj_to_str(budget_us))
+              << std::setw(12) << stats.mean()
+              << std::setw(14) << (budget_us == 0 ? std::string("-") : obj_to_str(used / ticks_per_usec / std::max<uint64_t>(decisions, 1)))
+              << std::setw(13) << (decisions > 0 ? 100.0 * deadlines / decisions : 0.0) << "%"
+              << std::setw(12) << (seconds > 0.0 ? num_games / seconds : 0.0);
+
+    // Paired by game, so how hard a game is cancels out
+    if (first_rounds.empty()) {
+      first_rounds = rounds;
+      std::cout << std::setw(22) << "-" << std::endl;
+    }
+    else {
+      PairedStats diff;
+      for (int game = 0; game < num_games; ++game) {
+        diff.add(rounds[game], first_rounds[game]);
+      }
+      std::cout << std::setw(12) << std::showpos << diff.mean() << std::noshowpos << " +/- " << std::setw(5)
+                << diff.ci95() << std::endl;
+    }
+  }
+
+  m_budget_cycles = DecisionBudget::UNLIMITED;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::charge_budget(const int ws_idx, const DecisionBudget& budget)
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (!is_leader_ws(ws_idx)) {
+    return;
+  }
+
+  m_budget_used(ws_idx) += budget.used();
+  ++m_budget_decisions(ws_idx);
+  if (budget.hit_deadline()) {
+    ++m_budget_deadlines(ws_idx);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+bool Matchem::find_cached_decision(const int ws_idx, const CachedDecision kind, int* decision)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int size = kind == CACHED_QUERY ? 2 : SIZE;
+  int8_t cached[DecisionCache::MAX_SIZE];
+
+  // The exact state comes first since its hash is free. Exact entries are
+  // stored with the real labels.
+  if (m_cache.find(DecisionCache::make_key(m_zobrist(ws_idx), 2*kind), cached)) {
+    for (int k = 0; k < size; ++k) {
+      decision[k] = cached[k];
+    }
+    ++m_cache_hits(ws_idx);
+    return true;
+  }
+
+  canonical_form_t form;
+  canonicalize(ws_idx, form);
+  if (m_cache.find(DecisionCache::make_key(form.key, 2*kind + 1), cached)) {
+    if (kind == CACHED_QUERY) {
+      decision[0] = form.rows[cached[0]];
+      decision[1] = form.cols[cached[1]];
+    }
+    else {
+      for (int p = 0; p < SIZE; ++p) {
+        decision[form.rows[p]] = form.cols[cached[p]];
+      }
+    }
+    ++m_cache_hits(ws_idx);
+    return true;
+  }
+
+  ++m_cache_misses(ws_idx);
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::store_cached_decision(const int ws_idx, const CachedDecision kind, const int* decision)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int size = kind == CACHED_QUERY ? 2 : SIZE;
+
+  // States with more unknowns come earlier in the game and are shared by more games
+  const uint32_t priority = get_num_unknown(ws_idx);
+
+  int8_t exact[DecisionCache::MAX_SIZE], relabeled[DecisionCache::MAX_SIZE];
+  for (int k = 0; k < DecisionCache::MAX_SIZE; ++k) {
+    exact[k] = k < size ? decision[k] : -1;
+    relabeled[k] = -1;
+  }
+
+  canonical_form_t form;
+  canonicalize(ws_idx, form);
+  if (kind == CACHED_QUERY) {
+    relabeled[0] = form.row_pos[decision[0]];
+    relabeled[1] = form.col_pos[decision[1]];
+  }
+  else {
+    for (int i = 0; i < SIZE; ++i) {
+      relabeled[form.row_pos[i]] = form.col_pos[decision[i]];
+    }
+  }
+
+  m_cache.store(DecisionCache::make_key(m_zobrist(ws_idx), 2*kind), priority, exact);
+  m_cache.store(DecisionCache::make_key(form.key, 2*kind + 1), priority, relabeled);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int Matchem::get_num_games(const MatchemConfig& config)
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (config.sim_type() == EXACT) {
+    return static_cast<int>(factorial(SIZE));
+  }
+  if (config.target_ci() > 0.0) {
+    return config.max_runs();
+  }
+  return config.replay_games().empty() ? config.num_runs() : static_cast<int>(config.replay_games().size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int Matchem::get_team_size(const MatchemConfig& config)
+////////////////////////////////////////////////////////////////////////////////
+{
+  // TeamUtils hands out workspace slots by thread number, which needs teams
+  // that tile the threads
+  const int max_threads = Kokkos::DefaultExecutionSpace::concurrency();
+  my_require(config.bandit_threads() > 0 && max_threads % config.bandit_threads() == 0,
+             "Bandit threads must divide the " + obj_to_str(max_threads) + " Kokkos threads");
+  return config.bandit_threads();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::take_games(const MemberType& team, int* next, const int n)
+////////////////////////////////////////////////////////////////////////////////
+{
+  int first = 0;
+  Kokkos::single(Kokkos::PerTeam(team), [&](int& value) { value = Kokkos::atomic_fetch_add(next, n); }, first);
+  return first;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::seed_tree()
+////////////////////////////////////////////////////////////////////////////////
+{
+  // The first query does not depend on the hidden state
+  const int ws_idx = 0;
+  reset_knowledge(ws_idx);
+  const auto query = get_best_truth_query(ws_idx, 0);
+  const int decision[2] = {query.first, query.second};
+  m_tree.add_root(decision, 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::replay_tree_path(const int ws_idx, const int32_t* path, const int* outcomes, const int length)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
+
+  reset_knowledge(ws_idx);
+
+  for (int level = 0; level < length; ++level) {
+    const int round = level / 2;
+    const int8_t* decision = m_tree.decision(path[level]);
+    if (level % 2 == 0) {
+      observe_truth(ws_idx, round, decision[0], decision[1], outcomes[level] == 1);
+    }
+    else {
+      for (int i = 0; i < SIZE; ++i) {
+        my_guess(i) = decision[i];
+      }
+      process_guess_result(ws_idx, round, outcomes[level]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::build_book()
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  m_book.reset(SIZE, get_strategy_tag(), m_config.book_depth());
+
+  std::vector<int> observations;
+  extend_book(observations);
+
+  m_book.save(m_config.book_file());
+
+  const auto finish = std::chrono::steady_clock::now();
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+  std::cout << "Wrote " << m_book.num_entries() << " decisions covering " << m_config.book_depth()
+            << " rounds to " << m_config.book_file() << std::endl;
+  std::cout << "Building the book took " << 1e-6*duration.count() << " seconds" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint32_t Matchem::get_strategy_tag() const
+////////////////////////////////////////////////////////////////////////////////
+{
+#ifdef EXTRA_TRACKING
+  const uint32_t tracking = 1;
+#else
+  const uint32_t tracking = 0;
+#endif
+  return 2*static_cast<uint32_t>(m_config.strategy()) + tracking;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::extend_book(std::vector<int>& observations)
+////////////////////////////////////////////////////////////////////////////////
+{
+  // The book only needs one workspace. Children replay their path from
+  // scratch; decisions along the path are already in the book, so the replay
+  // follows them even for strategies that are not deterministic.
+  const int ws_idx = 0;
+  const int round = observations.size() / 2;
+
+  replay_observations(ws_idx, observations);
+
+  if (observations.size() % 2 == 0) {
+    if (round == m_config.book_depth()) {
+      return;
+    }
+
+    const auto query = get_best_truth_query(ws_idx, round);
+    const int side1_idx(query.first), side2_idx(query.second);
+    m_book.add_query(m_history(ws_idx), side1_idx, side2_idx);
+
+    const MatchState state = get_state(ws_idx, side1_idx, side2_idx);
+    bool can_match = state == YES_MATCH;
+    bool can_miss  = state == NO_MATCH;
+    if (state == UNKNOWN_MATCH) {
+      can_match = fits_some_state(ws_idx, side1_idx, side2_idx);
+      for (int j = 0; j < SIZE && !can_miss; ++j) {
+        can_miss = j != side2_idx && get_state(ws_idx, side1_idx, j) == UNKNOWN_MATCH &&
+          fits_some_state(ws_idx, side1_idx, j);
+      }
+    }
+
+    for (int answer = 0; answer < 2; ++answer) {
+      if (answer == 1 ? can_match : can_miss) {
+        observations.push_back(answer);
+        extend_book(observations);
+        observations.pop_back();
+      }
+    }
+  }
+  else {
+    auto my_guess = matchem::subview(m_guess_state, ws_idx);
+
+    make_guess(ws_idx, round);
+    m_book.add_guess(m_history(ws_idx), my_guess.data());
+
+    // A perfect score ends the game, so there is nothing more to record
+    match_dist_t dist;
+    get_match_count_dist(ws_idx, my_guess, dist);
+    for (int matches = 0; matches < SIZE; ++matches) {
+      if (dist[matches] > 0) {
+        observations.push_back(matches);
+        extend_book(observations);
+        observations.pop_back();
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::replay_observations(const int ws_idx, const std::vector<int>& observations)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+
+  init_indv(ws_idx);
+
+  for (size_t n = 0; n < observations.size(); ++n) {
+    const int round = n / 2;
+    if (n % 2 == 0) {
+      const auto query = get_best_truth_query(ws_idx, round);
+      const int side1_idx(query.first), side2_idx(query.second);
+      const bool is_match = observations[n] == 1;
+
+      // There is no real game behind a path, but validation expects the
+      // secret state to agree with known info, so make up one that does.
+      Kokkos::Array<int, SIZE> allowed;
+      for (int i = 0; i < SIZE; ++i) {
+        allowed[i] = get_pot_match_mask(ws_idx, i);
+        if (is_match && i != side1_idx) {
+          clearb(allowed[i], side2_idx);
+        }
+        my_state(i) = -1;
+      }
+      if (is_match) {
+        allowed[side1_idx] = 1 << side2_idx;
+      }
+      else {
+        clearb(allowed[side1_idx], side2_idx);
+      }
+      const bool found = complete_placement<SIZE>(allowed.data(), my_state.data());
+      assert(found);
+      (void)found;
+
+      observe_truth(ws_idx, round, side1_idx, side2_idx, is_match);
+    }
+    else {
+      make_guess(ws_idx, round);
+      process_guess_result(ws_idx, round, observations[n]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::run_indv(const int ws_idx, RoundCurves* curves, const MemberType* team)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+  int rounds = 0;
+  int matches = 0;
+
+  do {
+    assert(rounds < MAX_ROUNDS);
+
+    ask_truth(ws_idx, rounds, team);
+
+    const DecisionBudget budget = start_budget(ws_idx);
+    make_guess(ws_idx, rounds, budget, team);
+    charge_budget(ws_idx, budget);
+
+    matches = get_num_matches(ws_idx);
+
+    process_guess_result(ws_idx, rounds, matches);
+#ifdef EXTRA_TRACKING
+    if (curves != nullptr) {
+      add_round_curves(ws_idx, rounds, matches, *curves);
+    }
+#endif
+
+    vprint("At end of round " << rounds << ", game state is:\n" << *this);
+
+    ++rounds;
+  } while(matches < SIZE);
+
+  return rounds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Matchem::can_fuse() const
+////////////////////////////////////////////////////////////////////////////////
+{
+#ifdef EXTRA_TRACKING
+  // The fused round hardcodes the heuristic strategy and skips printing and
+  // decision budgets
+  return m_config.strategy() == HEURISTIC && m_book.empty() && !m_config.verbose() &&
+    m_config.decision_budgets_us().empty();
+#else
+  return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::run_indv_fused(const int ws_idx, RoundCurves* curves)
+////////////////////////////////////////////////////////////////////////////////
+{
+#ifdef EXTRA_TRACKING
+  auto my_guess      = matchem::subview(m_guess_state, ws_idx);
+  auto my_full_info  = matchem::subview(m_full_info, ws_idx);
+#ifdef INCREMENTAL_GUESS
+  auto my_pick  = matchem::subview(m_guess_pick, ws_idx);
+  auto my_taken = matchem::subview(m_guess_taken, ws_idx);
+  int& dirty = m_guess_dirty_rows(ws_idx);
+#endif
+
+  // The hidden state is loaded once per game instead of once per phase
+  Kokkos::Array<int, SIZE> hidden;
+  for (int i = 0; i < SIZE; ++i) {
+    hidden[i] = m_game_state(ws_idx, i);
+  }
+
+  int rounds = 0;
+  int matches = 0;
+  do {
+    assert(rounds < MAX_ROUNDS);
+
+    // Truth query, what get_best_truth_query does for the heuristic
+    std::pair<int, int> query;
+    {
+      MATCHEM_PHASE(ws_idx, TRUTH_QUERY);
+      query = rounds == 0 ? std::make_pair(0, 0) : get_best_odds_query(ws_idx);
+    }
+    assert(query.first != -1 && query.second != -1);
+    observe_truth(ws_idx, rounds, query.first, query.second, hidden[query.first] == query.second);
+
+    // Build the guess, score it and record it in the same sweep over side1s,
+    // timed as one make_guess
+    {
+      MATCHEM_PHASE(ws_idx, MAKE_GUESS);
+      count_guess(ws_idx);
+      int16_t been_picked = 0;
+      matches = 0;
+      for (int i = 0; i < SIZE; ++i) {
+        int pick;
+#ifdef INCREMENTAL_GUESS
+        if (!is_setb(dirty, i) && my_taken(i) == been_picked) {
+          pick = my_pick(i);
+        }
+        else {
+          my_taken(i) = been_picked;
+          pick = pick_heuristic_side2(ws_idx, i, been_picked);
+          my_pick(i) = pick;
+          ++m_guess_rows_touched(ws_idx);
+          MATCHEM_COUNT(ws_idx, GUESS_ROWS, 1);
+        }
+#else
+        pick = pick_heuristic_side2(ws_idx, i, been_picked);
+        MATCHEM_COUNT(ws_idx, GUESS_ROWS, 1);
+#endif
+        if (pick != -1) {
+          setb(been_picked, pick);
+        }
+        my_guess(i) = pick;
+        my_full_info(i, rounds) = pick;
+        matches += pick == hidden[i] ? 1 : 0;
+      }
+#ifdef INCREMENTAL_GUESS
+      dirty = 0;
+      ++m_guess_builds(ws_idx);
+#endif
+    }
+
+    // What process_guess_result does, without revalidating everything
+    {
+      MATCHEM_PHASE(ws_idx, PROCESS_GUESS);
+      m_history(ws_idx) = history_after_guess(m_history(ws_idx), matches);
+      record_round(ws_idx, rounds, matches);
+    }
+    if (curves != nullptr) {
+      add_round_curves(ws_idx, rounds, matches, *curves);
+    }
+
+    ++rounds;
+  } while(matches < SIZE);
+
+  return rounds;
+#else
+  assert(false); // see can_fuse
+  return run_indv(ws_idx, curves);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::run_indv_tree(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
+
+  // Tree levels alternate truth queries and guesses, level 2r is the query of
+  // round r. While the game stays on the tree, the workspace is left alone;
+  // it only gets caught up (synced) once a decision has to be computed.
+  int32_t path[2*MAX_ROUNDS];
+  int outcomes[2*MAX_ROUNDS];
+  int decision[SIZE];
+  bool synced = false;
+  int32_t node = m_tree.root();
+
+  for (int level = 0; ; ++level) {
+    const int round = level / 2;
+    const bool is_query = level % 2 == 0;
+    assert(round < MAX_ROUNDS);
+
+    if (node != decision_tree_t::NONE) {
+      const int8_t* tree_decision = m_tree.decision(node);
+      for (int k = 0; k < SIZE; ++k) {
+        decision[k] = tree_decision[k];
+      }
+      ++m_tree_lookups(ws_idx);
+    }
+    else {
+      if (!synced) {
+        replay_tree_path(ws_idx, path, outcomes, level);
+        synced = true;
+      }
+
+      const DecisionBudget budget = start_budget(ws_idx);
+      if (is_query) {
+        const auto query = get_best_truth_query(ws_idx, round, budget);
+        decision[0] = query.first;
+        decision[1] = query.second;
+      }
+      else {
+        make_guess(ws_idx, round, budget);
+        for (int i = 0; i < SIZE; ++i) {
+          decision[i] = my_guess(i);
+        }
+      }
+      charge_budget(ws_idx, budget);
+      ++m_tree_computes(ws_idx);
+
+      // Once the tree is full, or we fell off it because it was, the rest of
+      // the game is played without it
+      assert(level > 0); // seed_tree adds the root
+      if (path[level-1] != decision_tree_t::NONE) {
+        node = m_tree.insert_child(path[level-1], outcomes[level-1], decision, is_query ? 2 : SIZE);
+      }
+    }
+    path[level] = node;
+
+    if (is_query) {
+      const bool is_match = my_state(decision[0]) == decision[1];
+      if (synced) {
+        observe_truth(ws_idx, round, decision[0], decision[1], is_match);
+      }
+      outcomes[level] = is_match ? 1 : 0;
+    }
+    else {
+      int matches = 0;
+      for (int i = 0; i < SIZE; ++i) {
+        if (my_state(i) == decision[i]) {
+          ++matches;
+        }
+      }
+      if (synced) {
+        for (int i = 0; i < SIZE; ++i) {
+          my_guess(i) = decision[i];
+        }
+        process_guess_result(ws_idx, round, matches);
+      }
+      if (matches == SIZE) {
+        return round + 1;
+      }
+      outcomes[level] = matches;
+    }
+
+    if (node != decision_tree_t::NONE) {
+      node = m_tree.child(node, outcomes[level]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::play_indv(const int ws_idx, const bool fused, RoundCurves* curves, const MemberType* team)
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (team != nullptr && team->team_size() == 1) {
+    team = nullptr; // a team of one plays like a thread alone
+  }
+
+  if (team != nullptr) {
+    // The other threads take over the first thread's hidden state, whatever
+    // they set up themselves. Their random streams stay their own.
+    team->team_barrier();
+    const int game = static_cast<int>(get_game_id(ws_idx - team->team_rank()));
+    team->team_barrier();
+    if (team->team_rank() > 0) {
+      init_indv_exact(ws_idx, game);
+    }
+  }
+
+  MATCHEM_COUNT(ws_idx, GAMES, 1);
+  if (m_tree.enabled()) {
+    return run_indv_tree(ws_idx); // configure keeps curves away from the tree
+  }
+  return fused ? run_indv_fused(ws_idx, curves) : run_indv(ws_idx, curves, team);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::init_indv(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  MATCHEM_PHASE(ws_idx, INIT);
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+
+  for (int i = 0; i < SIZE; ++i) {
+    my_state(i) = i;
+  }
+
+  std::random_shuffle(&my_state(0), &my_state(0) + SIZE);
+
+  reset_knowledge(ws_idx);
+  seed_game(ws_idx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::init_indv_exact(const int ws_idx, const int game)
+////////////////////////////////////////////////////////////////////////////////
+{
+  MATCHEM_PHASE(ws_idx, INIT);
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+
+  unrank_permutation<SIZE>(game, my_state.data());
+
+  reset_knowledge(ws_idx);
+  seed_game(ws_idx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::seed_game(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (m_config.strategy() == BANDIT) {
+    m_rng_state(ws_idx) = hash_combine(m_rng_seed, get_game_id(ws_idx));
+    // Each thread of a team samples for its own share of the rollouts
+    const int rank = ws_idx % m_policy.team_size();
+    if (rank > 0) {
+      m_rng_state(ws_idx) = hash_combine(m_rng_state(ws_idx), rank);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int64_t Matchem::get_game_id(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  return rank_permutation<SIZE>(matchem::subview(m_game_state, ws_idx).data());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::reset_knowledge(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  for (int i = 0; i < SIZE; ++i) {
+    my_guess(i) = -1;
+    my_info(i)  = 0;
+  }
+
+  m_history(ws_idx) = HISTORY_ROOT;
+  m_zobrist(ws_idx) = 0;
+
+#ifdef EXTRA_TRACKING
+  auto my_full_info  = matchem::subview(m_full_info, ws_idx);
+  auto my_round_info = matchem::subview(m_round_info, ws_idx);
+  auto my_odds_info  = matchem::subview(m_odds_info, ws_idx);
+
+  for (int i = 0; i < MAX_ROUNDS; ++i) {
+    my_round_info(i) = -1;
+  }
+
+  for (int i = 0; i < SIZE; ++i) {
+    for (int r = 0; r < MAX_ROUNDS; ++r) {
+      my_full_info(i, r) = -1;
+    }
+    for (int j = 0; j < SIZE; ++j) {
+      my_odds_info(i, j) = 1.0/SIZE;
+    }
+  }
+#endif
+
+  mark_all_dirty(ws_idx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::get_num_matches(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  MATCHEM_PHASE(ws_idx, COUNT_MATCHES);
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
+
+  int result = 0;
+  for (int i = 0; i < SIZE; ++i) {
+    if (my_state(i) == my_guess(i)) {
+      ++result;
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::ask_truth(const int ws_idx, const int round, const MemberType* team)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+
+  const DecisionBudget budget = start_budget(ws_idx);
+  const auto query = get_best_truth_query(ws_idx, round, budget, team);
+  charge_budget(ws_idx, budget);
+  const int side1_idx(query.first), side2_idx(query.second);
+  assert(side1_idx != -1 && side2_idx != -1);
+
+  // make the ask!
+  const bool is_match = my_state(side1_idx) == side2_idx;
+
+  observe_truth(ws_idx, round, side1_idx, side2_idx, is_match);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::observe_truth(const int ws_idx, const int round, const int side1, const int side2, const bool is_match)
+////////////////////////////////////////////////////////////////////////////////
+{
+  MATCHEM_COUNT(ws_idx, TRUTH_QUERIES, 1);
+
+  // Strategies that plan ahead may spend a query on a pair we already know,
+  // there is nothing new to process in that case.
+  if (get_state(ws_idx, side1, side2) == UNKNOWN_MATCH) {
+    // Timed here, process_ask_result calls itself for what it infers
+    MATCHEM_PHASE(ws_idx, PROCESS_ASK);
+    process_ask_result(ws_idx, round, side1, side2, is_match);
+  }
+
+  m_history(ws_idx) = history_after_ask(m_history(ws_idx), is_match);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+Matchem::MatchState Matchem::get_state(const int ws_idx, const int side1, const int side2) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  static_assert(sizeof(int) == sizeof(int16_t)*2, "Incompatible int sizes");
+  static_assert(SIZE <= 16, "SIZE too big to fit into int16_t bitmask");
+
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
+  const int16_t known_matches = pieces[0];
+  const int16_t known_misses  = pieces[1];
+
+  if (is_setb(known_matches, side2)) {
+    assert(!is_setb(known_misses, side2));
+    return YES_MATCH;
+  }
+  else if (is_setb(known_misses, side2)) {
+    assert(!is_setb(known_matches, side2));
+    return NO_MATCH;
+  }
+  else {
+    return UNKNOWN_MATCH;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::set_state(const int ws_idx, const int side1, const int side2, const MatchState state)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+#ifndef NDEBUG
+  const int before_num_pot_matches = get_num_pot_matches(ws_idx, side1);
+#endif
+
+  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
+  int16_t& known_matches = pieces[0];
+  int16_t& known_misses  = pieces[1];
+
+  assert(state != UNKNOWN_MATCH);
+
+  assert(!is_setb(known_matches, side2));
+  assert(!is_setb(known_misses, side2));
+
+  uint64_t& zobrist = m_zobrist(ws_idx);
+
+  mark_dirty(ws_idx, side1);
+  MATCHEM_COUNT(ws_idx, SET_STATE_CALLS, 1);
+
+  if (state == YES_MATCH) {
+    setb(known_matches, side2);
+    zobrist ^= zobrist_key(side1, side2, true);
+    for (int j = 0; j < SIZE; ++j) {
+      if (j != side2 && !is_setb(known_misses, j)) {
+        setb(known_misses, j);
+        zobrist ^= zobrist_key(side1, j, false);
+      }
+    }
+
+    // no other items can match to this j
+    for (int i = 0; i < SIZE; ++i) {
+      if (i != side1) {
+        int16_t* other_pieces       = reinterpret_cast<int16_t*>(&my_info(i));
+        int16_t& other_known_misses = other_pieces[1];
+
+        if (!is_setb(other_known_misses, side2)) {
+          setb(other_known_misses, side2);
+          zobrist ^= zobrist_key(i, side2, false);
+          mark_dirty(ws_idx, i);
+        }
+      }
+    }
+
+    assert(get_num_pot_matches(ws_idx, side1) == 1);
+  }
+  else {
+    assert(state == NO_MATCH);
+
+    setb(known_misses, side2);
+    zobrist ^= zobrist_key(side1, side2, false);
+
+    assert(get_num_pot_matches(ws_idx, side1) == before_num_pot_matches - 1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+bool Matchem::has_match(const int ws_idx, const int side1) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
+  const int16_t known_matches = pieces[0];
+
+  return known_matches != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::get_match(const int ws_idx, const int side1) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
+  const int16_t known_matches = pieces[0];
+
+  for (int j = 0; j < SIZE; ++j) {
+    if (is_setb(known_matches, j)) {
+      return j;
+    }
+  }
+
+  assert(false); // no match
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::get_first_pot_match(const int ws_idx, const int side1) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
+  const int16_t known_misses = pieces[1];
+
+  for (int j = 0; j < SIZE; ++j) {
+    if (!is_setb(known_misses, j)) {
+      return j;
+    }
+  }
+
+  assert(false);
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::get_first_pot_back_match(const int ws_idx, const int side2) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  for (int i = 0; i < SIZE; ++i) {
+    int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(i));
+    const int16_t known_misses = pieces[1];
+
+    if (!is_setb(known_misses, side2)) {
+      return i;
+    }
+  }
+
+  assert(false);
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::get_num_pot_matches(const int ws_idx, const int side1) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
+  const int16_t known_misses = pieces[1];
+
+  int result = 0;
+  for (int j = 0; j < SIZE; ++j) {
+    if (!is_setb(known_misses, j)) {
+      ++result;
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::get_num_pot_back_matches(const int ws_idx, const int side2) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  int result = 0;
+  for (int i = 0; i < SIZE; ++i) {
     int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(i));
     const int16_t known_misses = pieces[1];
 
-    if (!is_setb(known_misses, side2)) {
-      ++result;
+    if (!is_setb(known_misses, side2)) {
+      ++result;
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::get_pot_match_mask(const int ws_idx, const int side1) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  int16_t* pieces = reinterpret_cast<int16_t*>(&my_info(side1));
+  const int16_t known_misses = pieces[1];
+
+  return ~static_cast<int>(known_misses) & ((1 << SIZE) - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::get_match_count_dist(const int ws_idx, const uview_1d_int_t& guess, match_dist_t& dist) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_rook_ws = matchem::subview(m_rook_ws, ws_idx);
+
+  Kokkos::Array<int, SIZE> allowed;
+  for (int i = 0; i < SIZE; ++i) {
+    allowed[i] = get_pot_match_mask(ws_idx, i);
+  }
+
+  match_count_dist<SIZE>(allowed.data(), guess.data(), my_rook_ws.data(), dist);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+bool Matchem::fits_some_state(const int ws_idx, const int side1, const int side2) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  Kokkos::Array<int, SIZE> forced, placement;
+  for (int i = 0; i < SIZE; ++i) {
+    forced[i] = get_pot_match_mask(ws_idx, i);
+    clearb(forced[i], side2);
+    placement[i] = -1;
+  }
+  forced[side1] = 1 << side2;
+
+  return complete_placement<SIZE>(forced.data(), placement.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::get_num_unknown(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  int result = 0;
+  for (int i = 0; i < SIZE; ++i) {
+    const int16_t* pieces = reinterpret_cast<const int16_t*>(&my_info(i));
+    result += SIZE - popcount(pieces[0]) - popcount(pieces[1]);
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+uint64_t Matchem::compute_zobrist(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  uint64_t result = 0;
+  for (int i = 0; i < SIZE; ++i) {
+    for (int j = 0; j < SIZE; ++j) {
+      const MatchState state = get_state(ws_idx, i, j);
+      if (state != UNKNOWN_MATCH) {
+        result ^= zobrist_key(i, j, state == YES_MATCH);
+      }
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::canonicalize(const int ws_idx, canonical_form_t& form) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+  // None of the strategies learn from ceremony scores yet, so leaving the
+  // scored guesses out of the form loses nothing and lets far more states
+  // share. Pass m_full_info and m_round_info here once one does.
+  matchem::canonicalize<SIZE>(my_info.data(), 0, nullptr, 0, nullptr, form);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::validate_state(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+#ifndef NDEBUG
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+  auto my_info  = matchem::subview(m_known_info, ws_idx);
+
+ #ifdef EXTRA_TRACKING
+  // Rollout workspaces do not track odds
+  if (!is_rollout_ws(ws_idx)) {
+    auto my_odds = matchem::subview(m_odds_info, ws_idx);
+
+    Kokkos::Array<double, SIZE> incoming_odds; // idx = side2 id
+    for (int j = 0; j < SIZE; ++j) { incoming_odds[j] = 0.0; }
+
+    for (int i = 0; i < SIZE; ++i) {
+      double outgoing_odds = 0;
+      for (int j = 0; j < SIZE; ++j) {
+        const double curr_odds = my_odds(i, j);
+        outgoing_odds += curr_odds;
+        incoming_odds[j] += curr_odds;
+      }
+      if (!approx_equal(outgoing_odds, 1.0, 0.0001)) {
+        std::cout << "Problem with outgoing odds for side1 " << i << ":" << outgoing_odds << std::endl;
+        std::cout << *this << std::endl;
+      }
+      assert(approx_equal(outgoing_odds, 1.0, 0.0001));
+    }
+    for (int j = 0; j < SIZE; ++j) {
+      if (!approx_equal(incoming_odds[j], 1.0, 0.0001)) {
+        std::cout << "Problem with incoming odds for side2 " << j << ":" << incoming_odds[j] << std::endl;
+        std::cout << *this << std::endl;
+      }
+      assert(approx_equal(incoming_odds[j], 1.0, 0.0001));
+    }
+  }
+ #endif
+
+  check_even_spread<SIZE>(my_state);
+
+  assert(m_zobrist(ws_idx) == compute_zobrist(ws_idx));
+
+  for (int i = 0; i < SIZE; ++i) {
+    const int match = my_state(i);
+    for (int j = 0; j < SIZE; ++j) {
+      assert(get_state(ws_idx, i, j) != (j == match ? NO_MATCH : YES_MATCH));
+    }
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+std::pair<int, int> Matchem::get_best_truth_query(const int ws_idx, const int round, const DecisionBudget& budget,
+                                                  const MemberType* team)
+////////////////////////////////////////////////////////////////////////////////
+{
+  MATCHEM_PHASE(ws_idx, TRUTH_QUERY);
+  std::pair<int, int> query;
+  if (is_rollout_ws(ws_idx)) {
+    return get_rollout_truth_query(ws_idx);
+  }
+  else if (m_book.find_query(m_history(ws_idx), query)) {
+    return query;
+  }
+  else if (m_config.strategy() == OPTIMAL) {
+    if (m_policy_table.find_query(m_history(ws_idx), query)) {
+      return query;
+    }
+  }
+#ifdef EXTRA_TRACKING
+  else if (m_config.strategy() == DISTILLED) {
+    return get_distilled_truth_query(ws_idx);
+  }
+#endif
+  else if (m_config.strategy() == BANDIT && round > 0) {
+    int decision[2];
+    if (m_cache.enabled() && find_cached_decision(ws_idx, CACHED_QUERY, decision)) {
+      return std::make_pair(decision[0], decision[1]);
+    }
+    query = get_bandit_truth_query(ws_idx, round, budget, team);
+    if (m_cache.enabled()) {
+      decision[0] = query.first;
+      decision[1] = query.second;
+      store_cached_decision(ws_idx, CACHED_QUERY, decision);
+    }
+    return query;
+  }
+
+#ifdef EXTRA_TRACKING
+  if (round == 0) {
+    // we know nothing, so any guess is fine
+    return std::make_pair(0, 0);
+  }
+  else {
+    // For now, just select the match with the best odds of being a correct. We'd
+    // learn the most by selecting the closest to 50/50
+    return get_best_odds_query(ws_idx);
+  }
+#else
+  for (int i = 0; i < SIZE; ++i) {
+
+    if (!has_match(ws_idx, i)) {
+      // no match is known yet for this item
+      for (int j = 0; j < SIZE; ++j) {
+        if (get_state(ws_idx, i, j) == UNKNOWN_MATCH) {
+          return std::make_pair(i, j);
+        }
+      }
+    }
+  }
+#endif
+
+  assert(false); // Unable to select a query?
+  return std::make_pair(-1, -1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::process_ask_result(
+  const int ws_idx, const int round, const int side1_idx, const int side2_idx, bool was_match)
+////////////////////////////////////////////////////////////////////////////////
+{
+  set_state(ws_idx, side1_idx, side2_idx, was_match ? YES_MATCH : NO_MATCH);
+  assert(get_state(ws_idx, side1_idx, side2_idx) == (was_match ? YES_MATCH : NO_MATCH));
+
+  if (!was_match) {
+    const int num_pot_matches = get_num_pot_matches(ws_idx, side1_idx);
+    bool did_substitute_action = false;
+    if (num_pot_matches == 1) {
+      const int infer_side2_match = get_first_pot_match(ws_idx, side1_idx);
+      MATCHEM_ENTER_INFERENCE(ws_idx);
+      process_ask_result(ws_idx, round, side1_idx, infer_side2_match, true);
+      MATCHEM_LEAVE_INFERENCE(ws_idx);
+      did_substitute_action = true;
+    }
+    const int num_pot_back_matches = get_num_pot_back_matches(ws_idx, side2_idx);
+    if (num_pot_back_matches == 1) {
+      const int infer_side1_match = get_first_pot_back_match(ws_idx, side2_idx);
+      if (get_state(ws_idx, infer_side1_match, side2_idx) == UNKNOWN_MATCH) {
+        MATCHEM_ENTER_INFERENCE(ws_idx);
+        process_ask_result(ws_idx, round, infer_side1_match, side2_idx, true);
+        MATCHEM_LEAVE_INFERENCE(ws_idx);
+        did_substitute_action = true;
+      }
+    }
+    if (did_substitute_action) {
+      return;
+    }
+  }
+
+#ifdef EXTRA_TRACKING
+  // Rollouts play a cheap strategy that has no use for odds
+  if (is_rollout_ws(ws_idx)) {
+    return;
+  }
+
+  auto my_odds = matchem::subview(m_odds_info, ws_idx);
+
+  vprint("side1 " << side1_idx << (was_match ? " matched " : " did not match ") << "side2 " << side2_idx);
+
+  if (was_match) {
+    for (int j = 0; j < SIZE; ++j) {
+      if (j == side2_idx) {
+        my_odds(side1_idx, j) = 1.0;
+        MATCHEM_COUNT(ws_idx, ODDS_CELLS, 1);
+      }
+      else {
+        const double before_odds = my_odds(side1_idx, j);
+        if (before_odds > 0.0) {
+          my_odds(side1_idx, j) = 0.0;
+          MATCHEM_COUNT(ws_idx, ODDS_CELLS, 1);
+          int num_pot_back_matches = get_num_pot_back_matches(ws_idx, j);
+          if (num_pot_back_matches > 0) {
+            for (int i = 0; i < SIZE; ++i) {
+              if (i != side1_idx && get_state(ws_idx, i, j) == UNKNOWN_MATCH && my_odds(i, side2_idx) == 0.0) {
+                --num_pot_back_matches;
+              }
+            }
+            if (num_pot_back_matches > 0) {
+              for (int i = 0; i < SIZE; ++i) {
+                if (i != side1_idx && get_state(ws_idx, i, j) == UNKNOWN_MATCH && my_odds(i, side2_idx) > 0.0) {
+
+                  my_odds(i, j) += before_odds / num_pot_back_matches;
+                  MATCHEM_COUNT(ws_idx, ODDS_CELLS, 1);
+                  mark_dirty(ws_idx, i);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+    for (int i = 0; i < SIZE; ++i) {
+      if (i != side1_idx && my_odds(i, side2_idx) > 0.0) {
+        my_odds(i, side2_idx) = 0.0;
+        MATCHEM_COUNT(ws_idx, ODDS_CELLS, 1);
+        mark_dirty(ws_idx, i);
+      }
+    }
+  }
+  else {
+    const int num_pot_matches = get_num_pot_matches(ws_idx, side1_idx);
+    const double before_odds = my_odds(side1_idx, side2_idx);
+    const double fwd_delta_per_match = before_odds / num_pot_matches;
+    my_odds(side1_idx, side2_idx) = 0.0;
+    MATCHEM_COUNT(ws_idx, ODDS_CELLS, 1);
+
+    Kokkos::Array<double, SIZE> odds_lost; // idx = side1 id
+    for (int i = 0; i < SIZE; ++i) { odds_lost[i] = 0.0; }
+
+    for (int j = 0; j < SIZE; ++j) {
+      if (j != side2_idx && get_state(ws_idx, side1_idx, j) == UNKNOWN_MATCH) {
+        my_odds(side1_idx, j) += fwd_delta_per_match;
+        MATCHEM_COUNT(ws_idx, ODDS_CELLS, 1);
+        int num_pot_other_back_matches = get_num_pot_back_matches(ws_idx, j) - 1;
+        if (num_pot_other_back_matches > 0) {
+          for (int i = 0; i < SIZE; ++i) {
+            if (i != side1_idx && get_state(ws_idx, i, j) == UNKNOWN_MATCH && get_state(ws_idx, i, side2_idx) == NO_MATCH) {
+              --num_pot_other_back_matches;
+            }
+          }
+          if (num_pot_other_back_matches > 0) {
+            const double bwd_delta_per_match = fwd_delta_per_match / num_pot_other_back_matches;
+            for (int i = 0; i < SIZE; ++i) {
+              if (i != side1_idx && get_state(ws_idx, i, j) == UNKNOWN_MATCH && get_state(ws_idx, i, side2_idx) == UNKNOWN_MATCH) {
+                my_odds(i, j) -= bwd_delta_per_match;
+                MATCHEM_COUNT(ws_idx, ODDS_CELLS, 1);
+                odds_lost[i] += bwd_delta_per_match;
+                mark_dirty(ws_idx, i);
+                if (my_odds(i, j) < 0) {
+                  my_odds(i, j) = 0.0; // round-off issues can cause us to go very slightly below zero
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+    for (int i = 0; i < SIZE; ++i) {
+      if (i != side1_idx && get_state(ws_idx, i, side2_idx) == UNKNOWN_MATCH) {
+        my_odds(i, side2_idx) += odds_lost[i];
+        MATCHEM_COUNT(ws_idx, ODDS_CELLS, 1);
+        mark_dirty(ws_idx, i);
+      }
+    }
+  }
+
+  // The updates above keep the odds balanced for the queries the heuristic
+  // makes, but the other strategies and opening books can ask about any pair
+  // and knock them off. Heuristic games skip the check.
+  if (m_config.strategy() != HEURISTIC || !m_book.empty()) {
+    normalize_odds(ws_idx);
+  }
+#endif
+  validate_state(ws_idx);
+}
+
+#ifdef EXTRA_TRACKING
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::update_query_tree(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_odds      = matchem::subview(m_odds_info, ws_idx);
+  auto my_best      = matchem::subview(m_row_best, ws_idx);
+  auto my_best_odds = matchem::subview(m_row_best_odds, ws_idx);
+  auto my_tree      = matchem::subview(m_query_tree, ws_idx);
+
+  int& dirty = m_dirty_rows(ws_idx);
+  if (dirty == 0) {
+    return;
+  }
+
+  // Rows with no candidate keep odds 0 and never win, same as the scan which
+  // needs odds strictly above 0. On equal odds the lower row wins, like the
+  // first pair of the scan does.
+  auto row_wins = [&](const int a, const int b) {
+    if (a == -1 || b == -1) {
+      return b == -1;
+    }
+    return a < b ? my_best_odds(a) >= my_best_odds(b) : my_best_odds(a) > my_best_odds(b);
+  };
+
+  const bool rebuild = dirty == (1 << SIZE) - 1;
+  for (int i = 0; i < SIZE; ++i) {
+    if (!is_setb(dirty, i)) {
+      continue;
+    }
+
+    const int16_t* pieces = reinterpret_cast<const int16_t*>(&m_known_info(ws_idx, i));
+    const int known = pieces[0] | pieces[1];
+    int best_j = -1;
+    double best_odds = 0.0;
+    for (int j = 0; j < SIZE; ++j) {
+      if (!is_setb(known, j) && my_odds(i, j) > best_odds) {
+        best_j = j;
+        best_odds = my_odds(i, j);
+      }
+    }
+    my_best(i) = best_j;
+    my_best_odds(i) = best_odds;
+
+    if (!rebuild) {
+      for (int node = (QUERY_TREE_LEAVES + i) / 2; node > 0; node /= 2) {
+        const int left = my_tree(2*node), right = my_tree(2*node + 1);
+        my_tree(node) = row_wins(left, right) ? left : right;
+      }
+    }
+  }
+
+  if (rebuild) {
+    for (int leaf = 0; leaf < QUERY_TREE_LEAVES; ++leaf) {
+      my_tree(QUERY_TREE_LEAVES + leaf) = leaf < SIZE ? leaf : -1;
+    }
+    for (int node = QUERY_TREE_LEAVES - 1; node > 0; --node) {
+      const int left = my_tree(2*node), right = my_tree(2*node + 1);
+      my_tree(node) = row_wins(left, right) ? left : right;
+    }
+  }
+
+  dirty = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+std::pair<int, int> Matchem::get_best_odds_query(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  update_query_tree(ws_idx);
+
+  const int side1 = m_query_tree(ws_idx, 1);
+  if (side1 == -1 || m_row_best(ws_idx, side1) == -1) {
+    return std::make_pair(-1, -1);
+  }
+  return std::make_pair(side1, m_row_best(ws_idx, side1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+std::pair<int, int> Matchem::scan_best_odds_query(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_odds = matchem::subview(m_odds_info, ws_idx);
+  int best_side1_idx(-1), best_side2_idx(-1);
+  double best_odds_yet = 0.0;
+  for (int i = 0; i < SIZE; ++i) {
+    for (int j = 0; j < SIZE; ++j) {
+      if (get_state(ws_idx, i, j) == UNKNOWN_MATCH) {
+        const double odds = my_odds(i, j);
+        assert(odds >= 0.0 && odds <= 1.0);
+
+        if (odds > best_odds_yet) {
+          best_side1_idx = i;
+          best_side2_idx = j;
+          best_odds_yet = odds;
+        }
+      }
+    }
+  }
+  return std::make_pair(best_side1_idx, best_side2_idx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::normalize_odds(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_odds = matchem::subview(m_odds_info, ws_idx);
+
+  static constexpr double drift_tol = 1e-6;
+  static constexpr int max_iters = 1000;
+
+  auto max_drift = [&]() {
+    double result = 0.0;
+    for (int k = 0; k < SIZE; ++k) {
+      double row_sum = 0.0, col_sum = 0.0;
+      for (int l = 0; l < SIZE; ++l) {
+        row_sum += my_odds(k, l);
+        col_sum += my_odds(l, k);
+      }
+      result = std::max(result, std::max(std::fabs(row_sum - 1.0), std::fabs(col_sum - 1.0)));
+    }
+    return result;
+  };
+
+  if (max_drift() < drift_tol) {
+    return;
+  }
+
+  mark_all_dirty(ws_idx);
+
+  // Sinkhorn balancing. Every possible match needs some weight or the
+  // iteration may not be able to balance at all. Pairs that fit no hidden
+  // state must get none or it converges very slowly.
+  for (int i = 0; i < SIZE; ++i) {
+    for (int j = 0; j < SIZE; ++j) {
+      if (get_state(ws_idx, i, j) == NO_MATCH ||
+          (get_state(ws_idx, i, j) == UNKNOWN_MATCH && !fits_some_state(ws_idx, i, j))) {
+        my_odds(i, j) = 0.0;
+      }
+      else if (my_odds(i, j) < drift_tol) {
+        my_odds(i, j) = drift_tol;
+      }
+    }
+  }
+  MATCHEM_COUNT(ws_idx, ODDS_CELLS, SIZE*SIZE);
+
+  for (int iter = 0; iter < max_iters && max_drift() >= drift_tol*1e-3; ++iter) {
+    MATCHEM_COUNT(ws_idx, ODDS_CELLS, 2*SIZE*SIZE);
+    for (int i = 0; i < SIZE; ++i) {
+      double row_sum = 0.0;
+      for (int j = 0; j < SIZE; ++j) { row_sum += my_odds(i, j); }
+      for (int j = 0; j < SIZE; ++j) { my_odds(i, j) /= row_sum; }
+    }
+    for (int j = 0; j < SIZE; ++j) {
+      double col_sum = 0.0;
+      for (int i = 0; i < SIZE; ++i) { col_sum += my_odds(i, j); }
+      for (int i = 0; i < SIZE; ++i) { my_odds(i, j) /= col_sum; }
+    }
+  }
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::make_guess(const int ws_idx, const int round, const DecisionBudget& budget, const MemberType* team)
+////////////////////////////////////////////////////////////////////////////////
+{
+  MATCHEM_PHASE(ws_idx, MAKE_GUESS);
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
+
+  count_guess(ws_idx);
+
+  if (is_rollout_ws(ws_idx)) {
+    make_rollout_guess(ws_idx);
+  }
+  else if (m_book.find_guess(m_history(ws_idx), my_guess.data())) {
+    return;
+  }
+  else if (m_config.strategy() == OPTIMAL && m_policy_table.find_guess(m_history(ws_idx), my_guess.data())) {
+    return;
+  }
+#ifdef EXTRA_TRACKING
+  else if (m_config.strategy() == DISTILLED) {
+    make_distilled_guess(ws_idx);
+  }
+#endif
+  else if (m_config.strategy() == BANDIT) {
+    if (m_cache.enabled() && find_cached_decision(ws_idx, CACHED_GUESS, my_guess.data())) {
+      return;
+    }
+    make_bandit_guess(ws_idx, round, budget, team);
+    if (m_cache.enabled()) {
+      store_cached_decision(ws_idx, CACHED_GUESS, my_guess.data());
+    }
+  }
+  else {
+    make_heuristic_guess(ws_idx, round);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::make_heuristic_guess(const int ws_idx, const int round)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
+
+#ifdef INCREMENTAL_GUESS
+  auto my_pick  = matchem::subview(m_guess_pick, ws_idx);
+  auto my_taken = matchem::subview(m_guess_taken, ws_idx);
+  int& dirty = m_guess_dirty_rows(ws_idx);
+#endif
+
+  // clear previous guesses
+  for (int i = 0; i < SIZE; ++i) {
+    my_guess(i) = -1;
+  }
+
+  int16_t been_picked = 0;
+  for (int i = 0; i < SIZE; ++i) {
+
+#ifdef INCREMENTAL_GUESS
+    // The pick for side1 i only depends on its own known info and odds and on
+    // the side2s taken before it, so if none of that changed neither did it
+    if (!is_setb(dirty, i) && my_taken(i) == been_picked) {
+      my_guess(i) = my_pick(i);
+      setb(been_picked, my_pick(i));
+      continue;
+    }
+    my_taken(i) = been_picked;
+    ++m_guess_rows_touched(ws_idx);
+#endif
+    MATCHEM_COUNT(ws_idx, GUESS_ROWS, 1);
+
+    my_guess(i) = pick_heuristic_side2(ws_idx, i, been_picked);
+    if (my_guess(i) != -1) {
+      setb(been_picked, my_guess(i));
+    }
+
+#ifdef INCREMENTAL_GUESS
+    my_pick(i) = my_guess(i);
+#endif
+  }
+
+#ifdef INCREMENTAL_GUESS
+  dirty = 0;
+  ++m_guess_builds(ws_idx);
+#endif
+
+#ifndef NDEBUG
+  check_even_spread<SIZE>(my_guess);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::pick_heuristic_side2(const int ws_idx, const int side1, const int been_picked) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (has_match(ws_idx, side1)) {
+    const int match = get_match(ws_idx, side1);
+    assert(!is_setb(been_picked, match));
+    return match;
+  }
+
+  // no match is known yet for this item
+#ifdef EXTRA_TRACKING
+  auto my_odds = matchem::subview(m_odds_info, ws_idx);
+
+  // Start below zero so a side2 is picked even when the odds of every
+  // remaining one have been balanced down to zero
+  double best_odds_yet = -1.0;
+  int best_j = -1;
+  for (int j = 0; j < SIZE; ++j) {
+    if (get_state(ws_idx, side1, j) == UNKNOWN_MATCH && !is_setb(been_picked, j)) {
+      const double curr_odds = my_odds(side1, j);
+      if (curr_odds > best_odds_yet) {
+        best_odds_yet = curr_odds;
+        best_j = j;
+      }
+    }
+  }
+  return best_j;
+#else
+  // just pick the first possibility (very dumb).
+  for (int j = 0; j < SIZE; ++j) {
+    if (get_state(ws_idx, side1, j) == UNKNOWN_MATCH && !is_setb(been_picked, j)) {
+      return j;
+    }
+  }
+  return -1;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::count_guess(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+#ifdef TELEMETRY
+  if (is_rollout_ws(ws_idx)) {
+    return;
+  }
+
+  int num_pot_matches = 0;
+  for (int i = 0; i < SIZE; ++i) {
+    num_pot_matches += get_num_pot_matches(ws_idx, i);
+  }
+  MATCHEM_COUNT(ws_idx, GUESSES, 1);
+  MATCHEM_COUNT(ws_idx, DETERMINED_GUESSES, num_pot_matches == SIZE ? 1 : 0);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::process_guess_result(const int ws_idx, const int round, const int matches)
+////////////////////////////////////////////////////////////////////////////////
+{
+  MATCHEM_PHASE(ws_idx, PROCESS_GUESS);
+  m_history(ws_idx) = history_after_guess(m_history(ws_idx), matches);
+
+#ifdef EXTRA_TRACKING
+  auto my_guess      = matchem::subview(m_guess_state, ws_idx);
+  auto my_full_info  = matchem::subview(m_full_info, ws_idx);
+
+  for (int i = 0; i < SIZE; ++i) {
+    my_full_info(i, round) = my_guess(i);
+  }
+  record_round(ws_idx, round, matches);
+
+  // TODO - learn from the score
+#endif
+  validate_state(ws_idx);
+}
+
+#ifdef EXTRA_TRACKING
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::record_round(const int ws_idx, const int round, const int matches)
+////////////////////////////////////////////////////////////////////////////////
+{
+  m_round_info(ws_idx, round) = matches;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::add_round_curves(const int ws_idx, const int round, const int matches, RoundCurves& curves) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  int known = 0;
+  for (int i = 0; i < SIZE; ++i) {
+    known += has_match(ws_idx, i) ? 1 : 0;
+  }
+  curves.add(round, matches, known, get_entropy(ws_idx), get_marginal_entropy(ws_idx));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+double Matchem::get_entropy(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_rook_ws = matchem::subview(m_rook_ws, ws_idx);
+
+  Kokkos::Array<int, SIZE> allowed;
+  for (int i = 0; i < SIZE; ++i) {
+    allowed[i] = get_pot_match_mask(ws_idx, i);
+  }
+
+  count_completions<SIZE>(allowed.data(), my_rook_ws.data());
+  assert(my_rook_ws(0) > 0);
+  return std::log2(static_cast<double>(my_rook_ws(0)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+double Matchem::get_marginal_entropy(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  double result = 0.0;
+  for (int i = 0; i < SIZE; ++i) {
+    for (int j = 0; j < SIZE; ++j) {
+      const double odds = m_odds_info(ws_idx, i, j);
+      if (odds > 0.0) {
+        result -= odds * std::log2(odds);
+      }
     }
   }
+  return result;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::fork_workspace(const int src_ws_idx, const int dst_ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto src_info  = matchem::subview(m_known_info, src_ws_idx);
+  auto dst_info  = matchem::subview(m_known_info, dst_ws_idx);
+  auto src_guess = matchem::subview(m_guess_state, src_ws_idx);
+  auto dst_guess = matchem::subview(m_guess_state, dst_ws_idx);
+
+  for (int i = 0; i < SIZE; ++i) {
+    dst_info(i)  = src_info(i);
+    dst_guess(i) = src_guess(i);
+  }
+
+  m_history(dst_ws_idx) = m_history(src_ws_idx);
+  m_zobrist(dst_ws_idx) = m_zobrist(src_ws_idx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::prepare_sampling(const int ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_rook_ws = matchem::subview(m_rook_ws, ws_idx);
+
+  Kokkos::Array<int, SIZE> allowed;
+  for (int i = 0; i < SIZE; ++i) {
+    allowed[i] = get_pot_match_mask(ws_idx, i);
+  }
+
+  count_completions<SIZE>(allowed.data(), my_rook_ws.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::sample_hidden_state(const int ws_idx, const int dst_ws_idx)
+////////////////////////////////////////////////////////////////////////////////
+{
+  auto my_rook_ws = matchem::subview(m_rook_ws, ws_idx);
+  auto dst_state  = matchem::subview(m_game_state, dst_ws_idx);
+
+  Kokkos::Array<int, SIZE> allowed;
+  for (int i = 0; i < SIZE; ++i) {
+    allowed[i] = get_pot_match_mask(ws_idx, i);
+  }
+
+  Rng rng(m_rng_state(ws_idx));
+  sample_placement<SIZE>(allowed.data(), my_rook_ws.data(), rng, dst_state.data());
+  m_rng_state(ws_idx) = rng.state;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::rollout(const int rollout_ws_idx, const int first_round)
+////////////////////////////////////////////////////////////////////////////////
+{
+  int rounds = first_round;
+  int matches = 0;
+
+  // A rollout that runs out of rounds just scores as MAX_ROUNDS
+  while (matches < SIZE && rounds < MAX_ROUNDS) {
+    ask_truth(rollout_ws_idx, rounds);
+
+    make_guess(rollout_ws_idx, rounds);
+
+    matches = get_num_matches(rollout_ws_idx);
+
+    process_guess_result(rollout_ws_idx, rounds, matches);
+
+    ++rounds;
+  }
+
+  return rounds - first_round;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+int Matchem::finish_rollout_round(const int rollout_ws_idx, const int round)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int matches = get_num_matches(rollout_ws_idx);
+
+  process_guess_result(rollout_ws_idx, round, matches);
 
-  return result;
+  return matches == SIZE ? 1 : 1 + rollout(rollout_ws_idx, round + 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+template <typename Simulate>
 KOKKOS_FUNCTION
-void Matchem::validate_state(const int ws_idx) const
+int Matchem::run_bandit(const int ws_idx, const int num_arms, const DecisionBudget& budget, const MemberType* team,
+                        const Simulate& simulate)
 ////////////////////////////////////////////////////////////////////////////////
 {
-#ifndef NDEBUG
-  auto my_state = matchem::subview(m_game_state, ws_idx);
-  auto my_info  = matchem::subview(m_known_info, ws_idx);
-
- #ifdef EXTRA_TRACKING
-  auto my_odds = matchem::subview(m_odds_info, ws_idx);
+  assert(num_arms > 0 && num_arms <= MAX_BANDIT_ARMS);
 
-  Kokkos::Array<double, SIZE> incoming_odds; // idx = side2 id
-  for (int j = 0; j < SIZE; ++j) { incoming_odds[j] = 0.0; }
+  if (num_arms == 1) {
+    return 0;
+  }
 
-  for (int i = 0; i < SIZE; ++i) {
-    double outgoing_odds = 0;
-    for (int j = 0; j < SIZE; ++j) {
-      const double curr_odds = my_odds(i, j);
-      outgoing_odds += curr_odds;
-      incoming_odds[j] += curr_odds;
+  const int rollout_ws_idx = get_rollout_ws(ws_idx);
+  const int rank = team == nullptr ? 0 : team->team_rank();
+
+  prepare_sampling(ws_idx);
+
+  // Every arm gets one rollout, then UCB1 spends the rest of the rollouts. Fewer
+  // rounds is better, so we look for the smallest lower confidence bound. If
+  // time runs out first, we go with what we have. Each thread of a team does
+  // this on its own share of the rollouts, starting at its own arm.
+  const auto pull = [&](BanditArms& mine) {
+    const int t = mine.num_pulls;
+    int arm = (rank + t) % num_arms;
+    if (t >= num_arms) {
+      double best_score = std::numeric_limits<double>::max();
+      for (int a = 0; a < num_arms; ++a) {
+        const double score = mine.total_rounds[a] / mine.pulls[a] -
+          m_config.bandit_exploration() * std::sqrt(std::log(t) / mine.pulls[a]);
+        if (score < best_score) {
+          best_score = score;
+          arm = a;
+        }
+      }
     }
-    if (!approx_equal(outgoing_odds, 1.0, 0.0001)) {
-      std::cout << "Problem with outgoing odds for side1 " << i << ":" << outgoing_odds << std::endl;
-      std::cout << *this << std::endl;
+
+    fork_workspace(ws_idx, rollout_ws_idx);
+    sample_hidden_state(ws_idx, rollout_ws_idx);
+    mine.total_rounds[arm] += simulate(arm, rollout_ws_idx);
+    ++mine.pulls[arm];
+    ++mine.num_pulls;
+    ++m_bandit_rollouts(ws_idx);
+  };
+
+  // Thread r of a team plays rollouts r, r + team size, ...
+  const int max_rollouts = std::max(m_config.bandit_rollouts(), num_arms);
+  const int stride = team == nullptr ? 1 : team->team_size();
+  const auto pull_share = [&](const int first, BanditArms& mine) {
+    for (int t = first; t < max_rollouts && !budget.expired(); t += stride) {
+      pull(mine);
     }
-    assert(approx_equal(outgoing_odds, 1.0, 0.0001));
+  };
+
+  BanditArms arms;
+  if (team == nullptr) {
+    arms.reset();
+    pull_share(0, arms);
   }
-  for (int j = 0; j < SIZE; ++j) {
-    if (!approx_equal(incoming_odds[j], 1.0, 0.0001)) {
-      std::cout << "Problem with incoming odds for side2 " << j << ":" << incoming_odds[j] << std::endl;
-      std::cout << *this << std::endl;
+  else {
+    // Every thread of the team gets the sum over the team, so they all pick
+    // the same arm
+    Kokkos::parallel_reduce(Kokkos::TeamThreadRange(*team, stride), pull_share, StatsReducer<BanditArms>(arms));
+  }
+  if (rank == 0) {
+    ++m_bandit_decisions(ws_idx);
+  }
+
+  // Ties go to the lower arm, arm 0 being what the heuristic would have done.
+  // Arms that never got a rollout can not win.
+  int best_arm = 0;
+  for (int a = 1; a < num_arms; ++a) {
+    if (arms.pulls[a] > 0 && (arms.pulls[best_arm] == 0 ||
+                              arms.total_rounds[a] / arms.pulls[a] < arms.total_rounds[best_arm] / arms.pulls[best_arm])) {
+      best_arm = a;
     }
-    assert(approx_equal(incoming_odds[j], 1.0, 0.0001));
   }
- #endif
 
-  check_even_spread<SIZE>(my_state);
+  vprint("Bandit picked arm " << best_arm << " of " << num_arms << " after " << arms.num_pulls << " rollouts");
+
+  return best_arm;
+}
 
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+std::pair<int, int> Matchem::get_rollout_truth_query(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  // Ask about the unmatched side1 with the fewest possibilities left. Rows down
+  // to a single possibility are as good as known, so only ask those last.
+  int best_side1_idx = -1;
+  int best_count = SIZE + 2;
   for (int i = 0; i < SIZE; ++i) {
-    const int match = my_state(i);
-    for (int j = 0; j < SIZE; ++j) {
-      assert(get_state(ws_idx, i, j) != (j == match ? NO_MATCH : YES_MATCH));
+    if (!has_match(ws_idx, i)) {
+      const int num_pot_matches = get_num_pot_matches(ws_idx, i);
+      const int count = num_pot_matches == 1 ? SIZE + 1 : num_pot_matches;
+      if (count < best_count) {
+        best_side1_idx = i;
+        best_count = count;
+      }
     }
   }
-#endif
+
+  assert(best_side1_idx != -1);
+  return std::make_pair(best_side1_idx, get_first_pot_match(ws_idx, best_side1_idx));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 KOKKOS_FUNCTION
-std::pair<int, int> Matchem::get_best_truth_query(const int ws_idx, const int round) const
+void Matchem::make_rollout_guess(const int ws_idx)
 ////////////////////////////////////////////////////////////////////////////////
 {
-#ifdef EXTRA_TRACKING
-  if (round == 0) {
-    // we know nothing, so any guess is fine
-    return std::make_pair(0, 0);
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
+
+  Kokkos::Array<int, SIZE> allowed;
+  for (int i = 0; i < SIZE; ++i) {
+    allowed[i] = get_pot_match_mask(ws_idx, i);
+    my_guess(i) = has_match(ws_idx, i) ? get_match(ws_idx, i) : -1;
   }
-  else {
-    auto my_odds = matchem::subview(m_odds_info, ws_idx);
-    int best_side1_idx(-1), best_side2_idx(-1);
-    double best_odds_yet = 0.0;
-    for (int i = 0; i < SIZE; ++i) {
-      for (int j = 0; j < SIZE; ++j) {
-        if (get_state(ws_idx, i, j) == UNKNOWN_MATCH) {
-          const double odds = my_odds(i, j);
-          assert(odds >= 0.0 && odds <= 1.0);
-
-          // For now, just select the match with the best odds of being a correct. We'd
-          // learn the most by selecting the closest to 50/50
-          if (odds > best_odds_yet) {
-            best_side1_idx = i;
-            best_side2_idx = j;
-            best_odds_yet = odds;
+
+  const bool found = complete_placement<SIZE>(allowed.data(), my_guess.data());
+  assert(found);
+  (void)found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+std::pair<int, int> Matchem::get_bandit_truth_query(const int ws_idx, const int round, const DecisionBudget& budget,
+                                                    const MemberType* team)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int max_arms = m_config.bandit_candidates();
+  Kokkos::Array<std::pair<int, int>, MAX_BANDIT_ARMS> arms;
+  int num_arms = 0;
+
+#ifdef EXTRA_TRACKING
+  // Candidates are the unknown pairs with the best odds, best first
+  auto my_odds = matchem::subview(m_odds_info, ws_idx);
+  Kokkos::Array<double, MAX_BANDIT_ARMS> arm_odds;
+  for (int i = 0; i < SIZE; ++i) {
+    for (int j = 0; j < SIZE; ++j) {
+      if (get_state(ws_idx, i, j) == UNKNOWN_MATCH) {
+        const double odds = my_odds(i, j);
+        if (num_arms < max_arms || odds > arm_odds[num_arms - 1]) {
+          int pos = num_arms < max_arms ? num_arms++ : num_arms - 1;
+          for (; pos > 0 && odds > arm_odds[pos - 1]; --pos) {
+            arms[pos]     = arms[pos - 1];
+            arm_odds[pos] = arm_odds[pos - 1];
           }
+          arms[pos]     = std::make_pair(i, j);
+          arm_odds[pos] = odds;
         }
       }
     }
-    return std::make_pair(best_side1_idx, best_side2_idx);
   }
 #else
-  for (int i = 0; i < SIZE; ++i) {
-
+  // Candidates are the first unknown pairs of unmatched side1s
+  for (int i = 0; i < SIZE && num_arms < max_arms; ++i) {
     if (!has_match(ws_idx, i)) {
-      // no match is known yet for this item
-      for (int j = 0; j < SIZE; ++j) {
+      for (int j = 0; j < SIZE && num_arms < max_arms; ++j) {
         if (get_state(ws_idx, i, j) == UNKNOWN_MATCH) {
-          return std::make_pair(i, j);
+          arms[num_arms++] = std::make_pair(i, j);
         }
       }
     }
   }
 #endif
 
-  assert(false); // Unable to select a query?
-  return std::make_pair(-1, -1);
+  assert(num_arms > 0); // Unable to select a query?
+
+  const int best_arm = run_bandit(ws_idx, num_arms, budget, team, [&](const int arm, const int rollout_ws_idx) {
+    const int side1_idx(arms[arm].first), side2_idx(arms[arm].second);
+    observe_truth(rollout_ws_idx, round, side1_idx, side2_idx, m_game_state(rollout_ws_idx, side1_idx) == side2_idx);
+
+    make_guess(rollout_ws_idx, round);
+
+    return finish_rollout_round(rollout_ws_idx, round);
+  });
+
+  return arms[best_arm];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 KOKKOS_FUNCTION
-void Matchem::process_ask_result(
-  const int ws_idx, const int round, const int side1_idx, const int side2_idx, bool was_match)
+void Matchem::make_bandit_guess(const int ws_idx, const int round, const DecisionBudget& budget, const MemberType* team)
 ////////////////////////////////////////////////////////////////////////////////
 {
-  set_state(ws_idx, side1_idx, side2_idx, was_match ? YES_MATCH : NO_MATCH);
-  assert(get_state(ws_idx, side1_idx, side2_idx) == (was_match ? YES_MATCH : NO_MATCH));
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
 
-  if (!was_match) {
-    const int num_pot_matches = get_num_pot_matches(ws_idx, side1_idx);
-    bool did_substitute_action = false;
-    if (num_pot_matches == 1) {
-      const int infer_side2_match = get_first_pot_match(ws_idx, side1_idx);
-      process_ask_result(ws_idx, round, side1_idx, infer_side2_match, true);
-      did_substitute_action = true;
-    }
-    const int num_pot_back_matches = get_num_pot_back_matches(ws_idx, side2_idx);
-    if (num_pot_back_matches == 1) {
-      const int infer_side1_match = get_first_pot_back_match(ws_idx, side2_idx);
-      if (get_state(ws_idx, infer_side1_match, side2_idx) == UNKNOWN_MATCH) {
-        process_ask_result(ws_idx, round, infer_side1_match, side2_idx, true);
-        did_substitute_action = true;
-      }
-    }
-    if (did_substitute_action) {
-      return;
-    }
-  }
+  make_heuristic_guess(ws_idx, round);
+
+  // Arm 0 is the heuristic guess, the others swap the side2s of two side1s
+  const int max_arms = m_config.bandit_candidates();
+  Kokkos::Array<std::pair<int, int>, MAX_BANDIT_ARMS> arms;
+  arms[0] = std::make_pair(-1, -1);
+  int num_arms = 1;
 
 #ifdef EXTRA_TRACKING
+  // No swap can outrank the heuristic guess, not even when it is the only arm
   auto my_odds = matchem::subview(m_odds_info, ws_idx);
-
-  vprint("side1 " << side1_idx << (was_match ? " matched " : " did not match ") << "side2 " << side2_idx);
-
-  if (was_match) {
-    for (int j = 0; j < SIZE; ++j) {
-      if (j == side2_idx) {
-        my_odds(side1_idx, j) = 1.0;
+  Kokkos::Array<double, MAX_BANDIT_ARMS> arm_gain;
+  arm_gain[0] = std::numeric_limits<double>::infinity();
+#endif
+  for (int a = 0; a < SIZE; ++a) {
+    for (int b = a + 1; b < SIZE; ++b) {
+      if (has_match(ws_idx, a) || has_match(ws_idx, b) ||
+          get_state(ws_idx, a, my_guess(b)) != UNKNOWN_MATCH ||
+          get_state(ws_idx, b, my_guess(a)) != UNKNOWN_MATCH) {
+        continue;
       }
-      else {
-        const double before_odds = my_odds(side1_idx, j);
-        if (before_odds > 0.0) {
-          my_odds(side1_idx, j) = 0.0;
-          int num_pot_back_matches = get_num_pot_back_matches(ws_idx, j);
-          if (num_pot_back_matches > 0) {
-            for (int i = 0; i < SIZE; ++i) {
-              if (i != side1_idx && get_state(ws_idx, i, j) == UNKNOWN_MATCH && my_odds(i, side2_idx) == 0.0) {
-                --num_pot_back_matches;
-              }
-            }
-            if (num_pot_back_matches > 0) {
-              for (int i = 0; i < SIZE; ++i) {
-                if (i != side1_idx && get_state(ws_idx, i, j) == UNKNOWN_MATCH && my_odds(i, side2_idx) > 0.0) {
-
-                  my_odds(i, j) += before_odds / num_pot_back_matches;
-                }
-              }
-            }
-          }
+#ifdef EXTRA_TRACKING
+      // Keep the swaps that lose the least odds, best first
+      const double gain = my_odds(a, my_guess(b)) + my_odds(b, my_guess(a)) - my_odds(a, my_guess(a)) - my_odds(b, my_guess(b));
+      if (num_arms < max_arms || gain > arm_gain[num_arms - 1]) {
+        int pos = num_arms < max_arms ? num_arms++ : num_arms - 1;
+        for (; pos > 1 && gain > arm_gain[pos - 1]; --pos) {
+          arms[pos]     = arms[pos - 1];
+          arm_gain[pos] = arm_gain[pos - 1];
         }
+        arms[pos]     = std::make_pair(a, b);
+        arm_gain[pos] = gain;
       }
-    }
-    for (int i = 0; i < SIZE; ++i) {
-      if (i != side1_idx) {
-        my_odds(i, side2_idx) = 0.0;
+#else
+      if (num_arms < max_arms) {
+        arms[num_arms++] = std::make_pair(a, b);
       }
+#endif
     }
   }
-  else {
-    const int num_pot_matches = get_num_pot_matches(ws_idx, side1_idx);
-    const double before_odds = my_odds(side1_idx, side2_idx);
-    const double fwd_delta_per_match = before_odds / num_pot_matches;
-    my_odds(side1_idx, side2_idx) = 0.0;
 
-    Kokkos::Array<double, SIZE> odds_lost; // idx = side1 id
-    for (int i = 0; i < SIZE; ++i) { odds_lost[i] = 0.0; }
+  const int best_arm = run_bandit(ws_idx, num_arms, budget, team, [&](const int arm, const int rollout_ws_idx) {
+    auto rollout_guess = matchem::subview(m_guess_state, rollout_ws_idx);
+    if (arm > 0) {
+      std::swap(rollout_guess(arms[arm].first), rollout_guess(arms[arm].second));
+    }
+
+    return finish_rollout_round(rollout_ws_idx, round);
+  });
+
+  if (best_arm > 0) {
+    std::swap(my_guess(arms[best_arm].first), my_guess(arms[best_arm].second));
+  }
+
+#ifndef NDEBUG
+  check_even_spread<SIZE>(my_guess);
+#endif
+}
 
+#ifdef EXTRA_TRACKING
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::get_board(const int ws_idx, float* odds, uint8_t* cells) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  for (int i = 0; i < SIZE; ++i) {
     for (int j = 0; j < SIZE; ++j) {
-      if (j != side2_idx && get_state(ws_idx, side1_idx, j) == UNKNOWN_MATCH) {
-        my_odds(side1_idx, j) += fwd_delta_per_match;
-        int num_pot_other_back_matches = get_num_pot_back_matches(ws_idx, j) - 1;
-        if (num_pot_other_back_matches > 0) {
-          for (int i = 0; i < SIZE; ++i) {
-            if (i != side1_idx && get_state(ws_idx, i, j) == UNKNOWN_MATCH && get_state(ws_idx, i, side2_idx) == NO_MATCH) {
-              --num_pot_other_back_matches;
-            }
-          }
-          if (num_pot_other_back_matches > 0) {
-            const double bwd_delta_per_match = fwd_delta_per_match / num_pot_other_back_matches;
-            for (int i = 0; i < SIZE; ++i) {
-              if (i != side1_idx && get_state(ws_idx, i, j) == UNKNOWN_MATCH && get_state(ws_idx, i, side2_idx) == UNKNOWN_MATCH) {
-                my_odds(i, j) -= bwd_delta_per_match;
-                odds_lost[i] += bwd_delta_per_match;
-                if (my_odds(i, j) < 0) {
-                  my_odds(i, j) = 0.0; // round-off issues can cause us to go very slightly below zero
-                }
-              }
-            }
-          }
-        }
-      }
+      const MatchState state = get_state(ws_idx, i, j);
+      odds[i*SIZE + j]  = static_cast<float>(m_odds_info(ws_idx, i, j));
+      cells[i*SIZE + j] = state == YES_MATCH ? LinearModel::MATCH_CELL :
+                          state == NO_MATCH  ? LinearModel::NO_MATCH_CELL : LinearModel::OPEN_CELL;
     }
+  }
+}
 
-    for (int i = 0; i < SIZE; ++i) {
-      if (i != side1_idx && get_state(ws_idx, i, side2_idx) == UNKNOWN_MATCH) {
-        my_odds(i, side2_idx) += odds_lost[i];
-      }
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+void Matchem::get_features(const int ws_idx, float* features) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  constexpr int num_cells = SIZE*SIZE;
+  float odds[num_cells];
+  uint8_t cells[num_cells];
+  get_board(ws_idx, odds, cells);
+  LinearModel::get_features(SIZE, odds, cells, features);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+KOKKOS_FUNCTION
+std::pair<int, int> Matchem::get_distilled_truth_query(const int ws_idx) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  constexpr int num_cells = SIZE*SIZE;
+  float features[LinearModel::NUM_FEATURES*num_cells], scores[num_cells];
+  get_features(ws_idx, features);
+  m_model.score(LinearModel::QUERY_HEAD, features, num_cells, scores);
+
+  int best = -1;
+  for (int c = 0; c < num_cells; ++c) {
+    if (get_state(ws_idx, c / SIZE, c % SIZE) == UNKNOWN_MATCH && (best == -1 || scores[c] > scores[best])) {
+      best = c;
     }
   }
-#endif
-  validate_state(ws_idx);
+  assert(best != -1);
+
+  return std::make_pair(best / SIZE, best % SIZE);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 KOKKOS_FUNCTION
-void Matchem::make_guess(const int ws_idx, const int round)
+void Matchem::make_distilled_guess(const int ws_idx) const
 ////////////////////////////////////////////////////////////////////////////////
 {
+  constexpr int num_cells = SIZE*SIZE;
   auto my_guess = matchem::subview(m_guess_state, ws_idx);
-#ifdef EXTRA_TRACKING
-  auto my_odds  = matchem::subview(m_odds_info, ws_idx);
-#endif
 
-  // clear previous guesses
-  for (int i = 0; i < SIZE; ++i) {
-    my_guess(i) = -1;
-  }
+  float features[LinearModel::NUM_FEATURES*num_cells], scores[num_cells];
+  get_features(ws_idx, features);
+  m_model.score(LinearModel::GUESS_HEAD, features, num_cells, scores);
 
-  int16_t been_picked = 0;
+  // Known matches are free, then take the best scoring pair that is still
+  // open until every side1 has one
+  int used_side1 = 0, used_side2 = 0;
   for (int i = 0; i < SIZE; ++i) {
-
+    my_guess(i) = -1;
     if (has_match(ws_idx, i)) {
-      const int match = get_match(ws_idx, i);
-      assert(!is_setb(been_picked, match));
-      my_guess(i) = match;
-      setb(been_picked, match);
+      my_guess(i) = get_match(ws_idx, i);
+      setb(used_side1, i);
+      setb(used_side2, my_guess(i));
     }
-    else {
-      // no match is known yet for this item
-#ifdef EXTRA_TRACKING
-      double best_odds_yet = 0.0;
-      int best_j = -1;
-      for (int j = 0; j < SIZE; ++j) {
-        if (get_state(ws_idx, i, j) == UNKNOWN_MATCH && !is_setb(been_picked, j)) {
-          const double curr_odds = my_odds(i, j);
-          if (curr_odds > best_odds_yet) {
-            best_odds_yet = curr_odds;
-            best_j = j;
-          }
-        }
-      }
-      my_guess(i) = best_j;
-      setb(been_picked, best_j);
-#else
-      // just pick the first possibility (very dumb).
-      for (int j = 0; j < SIZE; ++j) {
-        if (get_state(ws_idx, i, j) == UNKNOWN_MATCH && !is_setb(been_picked, j)) {
-          my_guess(i) = j;
-          setb(been_picked, j);
-          break;
-        }
+  }
+
+  while (popcount(used_side1) < SIZE) {
+    int best = -1;
+    for (int c = 0; c < num_cells; ++c) {
+      if (!is_setb(used_side1, c / SIZE) && !is_setb(used_side2, c % SIZE) &&
+          (best == -1 || scores[c] > scores[best])) {
+        best = c;
       }
-#endif
     }
+    my_guess(best / SIZE) = best % SIZE;
+    setb(used_side1, best / SIZE);
+    setb(used_side2, best % SIZE);
   }
 
 #ifndef NDEBUG
@@ -610,14 +2873,117 @@ void Matchem::make_guess(const int ws_idx, const int round)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-KOKKOS_FUNCTION
-void Matchem::process_guess_result(const int ws_idx, const int round, const int matches)
+int Matchem::run_indv_recorded(const int ws_idx, std::vector<LinearModel::Sample>& samples)
+////////////////////////////////////////////////////////////////////////////////
+{
+  constexpr int num_cells = SIZE*SIZE;
+  auto my_state = matchem::subview(m_game_state, ws_idx);
+  auto my_guess = matchem::subview(m_guess_state, ws_idx);
+  int rounds = 0;
+  int matches = 0;
+
+  auto new_sample = [&](const LinearModel::Head head) -> LinearModel::Sample& {
+    samples.emplace_back();
+    LinearModel::Sample& sample = samples.back();
+    sample.head = head;
+    sample.odds.resize(num_cells);
+    sample.cells.resize(num_cells);
+    get_board(ws_idx, sample.odds.data(), sample.cells.data());
+    return sample;
+  };
+
+  do {
+    assert(rounds < MAX_ROUNDS);
+
+    {
+      // Only unknown pairs are worth asking about, the student only considers those
+      LinearModel::Sample& sample = new_sample(LinearModel::QUERY_HEAD);
+      const auto query = get_best_truth_query(ws_idx, rounds);
+      const int side1_idx(query.first), side2_idx(query.second);
+      if (get_state(ws_idx, side1_idx, side2_idx) == UNKNOWN_MATCH) {
+        sample.labels.push_back(side1_idx*SIZE + side2_idx);
+      }
+      else {
+        samples.pop_back();
+      }
+
+      observe_truth(ws_idx, rounds, side1_idx, side2_idx, my_state(side1_idx) == side2_idx);
+    }
+
+    {
+      // One softmax per side1 that does not have a known match yet
+      LinearModel::Sample& sample = new_sample(LinearModel::GUESS_HEAD);
+      make_guess(ws_idx, rounds);
+      for (int i = 0; i < SIZE; ++i) {
+        if (!has_match(ws_idx, i)) {
+          sample.labels.push_back(i*SIZE + my_guess(i));
+        }
+      }
+      if (sample.labels.empty()) {
+        samples.pop_back();
+      }
+    }
+
+    matches = get_num_matches(ws_idx);
+
+    process_guess_result(ws_idx, rounds, matches);
+
+    ++rounds;
+  } while(matches < SIZE);
+
+  return rounds;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+void Matchem::distill()
 ////////////////////////////////////////////////////////////////////////////////
 {
 #ifdef EXTRA_TRACKING
-  // TODO
+  // Both strategies play the same hidden states, one game at a time, so the
+  // games per second are comparable
+  const int num_games = m_config.num_runs();
+  const unsigned seed = std::rand();
+  const int ws_idx = 0;
+
+  std::vector<LinearModel::Sample> samples;
+  int teacher_rounds = 0;
+  const auto teacher_start = std::chrono::steady_clock::now();
+  for (int game = 0; game < num_games; ++game) {
+    std::srand(seed + game);
+    init_indv(ws_idx);
+    teacher_rounds += run_indv_recorded(ws_idx, samples);
+  }
+  const auto teacher_finish = std::chrono::steady_clock::now();
+
+  m_model.set_size(SIZE);
+  m_model.train(samples, DISTILL_EPOCHS, DISTILL_LEARNING_RATE);
+  m_model.save(m_config.model_file());
+  std::cout << "Trained on " << samples.size() << " decisions, wrote model to " << m_config.model_file() << std::endl;
+
+  MatchemConfig student_config(m_config);
+  student_config.set_strategy(DISTILLED);
+  student_config.set_book_file("");
+  student_config.set_decision_tree_mb(0);
+  Matchem student(student_config);
+
+  int student_rounds = 0;
+  const auto student_start = std::chrono::steady_clock::now();
+  for (int game = 0; game < num_games; ++game) {
+    std::srand(seed + game);
+    student.init_indv(ws_idx);
+    student_rounds += student.run_indv(ws_idx);
+  }
+  const auto student_finish = std::chrono::steady_clock::now();
+
+  auto report = [&](const char* name, const int rounds, const std::chrono::steady_clock::duration& duration) {
+    const double seconds = 1e-6*std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    std::cout << name << ": " << static_cast<double>(rounds) / num_games << " avg rounds per game, "
+              << (seconds > 0.0 ? num_games / seconds : 0.0) << " games per second" << std::endl;
+  };
+  report("Teacher", teacher_rounds, teacher_finish - teacher_start);
+  report("Student", student_rounds, student_finish - student_start);
 #endif
-  validate_state(ws_idx);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
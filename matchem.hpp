@@ -1,11 +1,23 @@
 #ifndef MATCHEM_HPP
 #define MATCHEM_HPP
 
+#include "matchem_book.hpp"
+#include "matchem_budget.hpp"
+#include "matchem_cache.hpp"
 #include "matchem_config.hpp"
 #include "matchem_exception.hpp"
 #include "matchem_kokkos.hpp"
+#include "matchem_model.hpp"
+#include "matchem_perf.hpp"
+#include "matchem_policy.hpp"
+#include "matchem_profile.hpp"
+#include "matchem_rook.hpp"
+#include "matchem_stats.hpp"
+#include "matchem_telemetry.hpp"
+#include "matchem_tree.hpp"
 
 #include <iostream>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -16,8 +28,41 @@ namespace tests {
 struct UnitWrap;
 }
 
+namespace bench {
+struct Benchmarks;
+}
+
+class MatchemTournament;
+class MatchemSweep;
+class MatchemScaling;
+
 // Configure optimizations. Keeping this compile-time for now to keep performance high
 #define EXTRA_TRACKING
+#define INCREMENTAL_GUESS
+
+// Telemetry counters, compiled away without TELEMETRY (cmake -DTELEMETRY=ON)
+#ifdef TELEMETRY
+#define MATCHEM_COUNT(ws_idx, counter, n) m_telemetry(ws_idx).add(Telemetry::counter, n)
+#define MATCHEM_ENTER_INFERENCE(ws_idx) m_telemetry(ws_idx).enter_inference()
+#define MATCHEM_LEAVE_INFERENCE(ws_idx) m_telemetry(ws_idx).leave_inference()
+#else
+#define MATCHEM_COUNT(ws_idx, counter, n) ((void)0)
+#define MATCHEM_ENTER_INFERENCE(ws_idx) ((void)0)
+#define MATCHEM_LEAVE_INFERENCE(ws_idx) ((void)0)
+#endif
+
+// Phase timers, from here to the end of the scope. Compiled away without
+// PHASE_PROFILING (cmake -DPHASE_PROFILING=ON); bandit rollouts and the copies
+// of a game on the other threads of its team are not timed
+#ifdef PHASE_PROFILING
+#define MATCHEM_PHASE_CAT2(a, b) a ## b
+#define MATCHEM_PHASE_CAT(a, b) MATCHEM_PHASE_CAT2(a, b)
+#define MATCHEM_PHASE(ws_idx, phase)                                                                          \
+  const PhaseTimer MATCHEM_PHASE_CAT(phase_timer_, __LINE__)(                                                 \
+    !is_leader_ws(ws_idx) ? nullptr : &m_profile(ws_idx), PhaseProfile::phase, m_sections)
+#else
+#define MATCHEM_PHASE(ws_idx, phase) ((void)0)
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 class Matchem
@@ -32,7 +77,12 @@ class Matchem
   template <typename DataType>
   using view = Kokkos::View<DataType, Kokkos::LayoutRight>;
 
+  using view_1d_int_t = view<int*>;
   using view_2d_int_t = view<int**>;
+  using view_2d_dbl_t = view<double**>;
+  using view_2d_i64_t = view<int64_t**>;
+  using view_1d_u64_t = view<uint64_t*>;
+  using uview_1d_int_t = Unmanaged<view<int*> >;
 #ifdef EXTRA_TRACKING
   using view_3d_int_t = view<int***>;
   using view_3d_dbl_t = view<double***>;
@@ -41,6 +91,30 @@ class Matchem
   static constexpr int SIZE = MatchemConfig::SET_SIZE;
 
   static constexpr int MAX_ROUNDS = 64;
+  static_assert(MAX_ROUNDS < SimStats::NUM_BINS, "SimStats can not hold every possible game");
+
+  // Games exact mode plays between checkpoints
+  static constexpr int EXACT_CHUNK = 1 << 16;
+
+  // Smallest batch of games play_to_target plays
+  static constexpr int MIN_CI_BATCH = 256;
+
+  // Most truth queries or guesses the bandit will compare for a single decision
+  static constexpr int MAX_BANDIT_ARMS = 16;
+
+  // Gradient descent settings for training the distilled strategy
+  static constexpr int DISTILL_EPOCHS = 300;
+  static constexpr double DISTILL_LEARNING_RATE = 1.0;
+
+  // Leaves of the tournament tree over rows used to pick truth queries
+  static constexpr int QUERY_TREE_LEAVES = SIZE <= 1 ? 1 : SIZE <= 2 ? 2 : SIZE <= 4 ? 4 : SIZE <= 8 ? 8 : 16;
+
+  // dist[k] = number of consistent hidden states with exactly k correct pairs
+  using match_dist_t = matchem::match_dist_t<SIZE>;
+
+  using canonical_form_t = CanonicalForm<SIZE>;
+
+  using decision_tree_t = DecisionTree<SIZE>;
 
   enum MatchState {
     UNKNOWN_MATCH,
@@ -67,6 +141,26 @@ class Matchem
    */
   void run();
 
+  /**
+   * build_book - Record every decision the strategy makes in the first
+   *              book_depth rounds of any game and save it as an opening book
+   */
+  void build_book();
+
+  /**
+   * distill - Play games with the configured strategy, train the distilled
+   *           strategy to imitate it, save the model and compare the two
+   */
+  void distill();
+
+  /**
+   * reconfigure - Switch to another config, keeping the workspaces, decision
+   *               cache and tree. The workspaces must have been sized for it
+   *               (bandit needs rollout workspaces), the cache and tree sizes
+   *               must not change.
+   */
+  void reconfigure(const MatchemConfig& config);
+
   //////////////////////////////// QUERIES /////////////////////////////////////
 
   /**
@@ -93,23 +187,164 @@ class Matchem
   ////////////////////////// INTERNAL METHODS //////////////////////////////////
   //////////////////////////////////////////////////////////////////////////////
 
+  // Load what the config's strategy needs and check the config, for the
+  // constructor and reconfigure
+  void configure();
+
   ////////////////////////// GAME PHASES //////////////////////////////////
 
-  // Run an indivual game of matching, returns how many rounds it took to finish
+  // Run an indivual game of matching, returns how many rounds it took to finish.
+  // Adds every round to curves if given. team is the team playing the game,
+  // see play_indv, or null if this thread plays it alone.
   KOKKOS_FUNCTION
-  int run_indv(const int ws_idx);
+  int run_indv(const int ws_idx, RoundCurves* curves = nullptr, const MemberType* team = nullptr);
+
+  // Run an individual game of the heuristic strategy with each round fused
+  // into one pass, see can_fuse. Plays exactly the same game as run_indv.
+  KOKKOS_FUNCTION
+  int run_indv_fused(const int ws_idx, RoundCurves* curves = nullptr);
+
+  // Can run_indv_fused stand in for run_indv?
+  bool can_fuse() const;
+
+  // Run an individual game by walking the decision tree, only asking the
+  // strategy for decisions the tree does not have yet
+  KOKKOS_FUNCTION
+  int run_indv_tree(const int ws_idx);
+
+  // Play the game set up in the workspace the fastest way this strategy
+  // allows: off the decision tree if there is one, else fused if it can be.
+  // With a team, every thread plays its own copy of the first thread's game in
+  // lockstep, so they can share the rollouts of each bandit decision.
+  KOKKOS_FUNCTION
+  int play_indv(const int ws_idx, const bool fused, RoundCurves* curves = nullptr, const MemberType* team = nullptr);
 
   // Initialize an individual game of matching
   KOKKOS_FUNCTION
   void init_indv(const int ws_idx);
 
+  // Initialize the game whose hidden state is permutation number game (exact mode)
+  KOKKOS_FUNCTION
+  void init_indv_exact(const int ws_idx, const int game);
+
+  // Identifies the hidden state of a game, init_indv_exact of the id sets it
+  // up again
+  KOKKOS_FUNCTION
+  int64_t get_game_id(const int ws_idx) const;
+
+  // Forget everything learned, the hidden state is kept
+  KOKKOS_FUNCTION
+  void reset_knowledge(const int ws_idx);
+
+  // Start the random stream of a game from its id, so a game is played the
+  // same whichever thread plays it and whatever was played before
+  KOKKOS_FUNCTION
+  void seed_game(const int ws_idx);
+
+  // How many games run() plays
+  static int get_num_games(const MatchemConfig& config);
+
+  // Play all the games of a run, returns the distribution of their rounds
+  // and times, and the per-round curves if they are tracked
+  RunStats play_games();
+
+  // Same for games first_game to first_game + num_games - 1 of the run only,
+  // which matters for games that are not random (exact mode, replays)
+  RunStats play_games(const int first_game, const int num_games);
+
+  // How games are spread over threads: this many workers, one team each,
+  // taking this many games at a time as they finish the last
+  struct WorkSplit
+  {
+    int workers;
+    int games_per_item;
+  };
+
+  // Hand games 0 to num_games - 1 out by split, play_game(team, ws_idx, game,
+  // stats) plays one of them. Every thread of a team calls it for the same
+  // game, only the first thread's stats are kept.
+  template <typename PlayGame>
+  RunStats play_split(const WorkSplit& split, const int num_games, const PlayGame& play_game);
+
+  // Threads per team, --bandit-threads. Only the bandit has a use for more than one.
+  static int get_team_size(const MatchemConfig& config);
+
+  // Workspaces that hold games, one per thread of each concurrent team. The
+  // rollout workspaces come after them.
+  KOKKOS_FUNCTION
+  int get_num_game_ws() const { return m_tu.get_num_concurrent_teams() * m_policy.team_size(); }
+
+  // The workspace of this thread of the team that got workspace slot slot
+  KOKKOS_FUNCTION
+  int get_team_ws(const MemberType& team, const int slot) const { return slot * team.team_size() + team.team_rank(); }
+
+  // Is this the copy of a game that its team reports, the first thread's?
+  KOKKOS_FUNCTION
+  bool is_leader_ws(const int ws_idx) const { return !is_rollout_ws(ws_idx) && ws_idx % m_policy.team_size() == 0; }
+
+  // The first of the next n games from the shared counter next. The first
+  // thread of the team takes them and every thread gets the answer.
+  KOKKOS_FUNCTION
+  static int take_games(const MemberType& team, int* next, const int n);
+
+  // Time a few splits on probe games and return the fastest. Strategies see
+  // the same random streams and an empty cache and tree afterwards.
+  WorkSplit calibrate();
+
+  // What a calibration holds for: this host and build, and the settings
+  // that change what a game costs
+  std::string calibration_key() const;
+
+  // The split cached for key, false if there is none, and cache one
+  static bool load_calibration(const std::string& filename, const std::string& key, WorkSplit& split);
+  static void save_calibration(const std::string& filename, const std::string& key, const WorkSplit& split);
+
+  // Zero the per-workspace counters
+  void reset_counters();
+
+  // Play every hidden state once (exact mode), in chunks so progress can be
+  // checkpointed and resumed. All hidden states are equally likely, so this
+  // is the weighted traversal of the decision tree with one walk per state:
+  // SIZE! games, which the decision tree makes cheap but not fewer.
+  RunStats play_exhaustive();
+
+  // Record that games before next_game are done and what they added up to,
+  // and read that back. Only the rounds survive a restart.
+  void save_checkpoint(const std::string& filename, const int next_game, const SimStats& stats) const;
+  int load_checkpoint(const std::string& filename, SimStats& stats) const;
+
+  // Play batches of games until the mean is known to within the target CI
+  // or the cap on games is reached
+  RunStats play_to_target();
+
+  // Print the spread of a run's rounds and times, and its chance to fit in
+  // each season
+  void report_stats(const RunStats& stats) const;
+
+  // Play the games once per decision budget and report each
+  void run_budgets();
+
+  // A budget for the next decision of a game. Rollouts are part of some other
+  // decision, so they are not budgeted themselves.
+  KOKKOS_FUNCTION
+  DecisionBudget start_budget(const int ws_idx) const
+  { return DecisionBudget(is_rollout_ws(ws_idx) ? DecisionBudget::UNLIMITED : m_budget_cycles); }
+
+  // Record what a decision's budget was used for
+  KOKKOS_FUNCTION
+  void charge_budget(const int ws_idx, const DecisionBudget& budget);
+
   // Ask for number of correct matches
   KOKKOS_FUNCTION
   int get_num_matches(const int ws_idx) const;
 
   // Ask for truth of an individual match.
   KOKKOS_FUNCTION
-  void ask_truth(const int ws_idx, const int round);
+  void ask_truth(const int ws_idx, const int round, const MemberType* team = nullptr);
+
+  // Take in the answer to a truth query
+  KOKKOS_FUNCTION
+  void observe_truth(const int ws_idx, const int round, const int side1, const int side2, const bool is_match);
 
   ////////////////////////// KNOWN INFO MGMT //////////////////////////////////
 
@@ -145,27 +380,278 @@ class Matchem
   KOKKOS_FUNCTION
   int get_num_pot_back_matches(const int ws_idx, const int side2) const;
 
+  // Get bitmask of potential matches for side1
+  KOKKOS_FUNCTION
+  int get_pot_match_mask(const int ws_idx, const int side1) const;
+
+  // Get the distribution of how many pairs of guess would be correct over all
+  // hidden states consistent with known info
+  KOKKOS_FUNCTION
+  void get_match_count_dist(const int ws_idx, const uview_1d_int_t& guess, match_dist_t& dist) const;
+
+  // Is there any hidden state consistent with known info that matches side1 to side2?
+  KOKKOS_FUNCTION
+  bool fits_some_state(const int ws_idx, const int side1, const int side2) const;
+
+  // Number of pairs whose state is still unknown
+  KOKKOS_FUNCTION
+  int get_num_unknown(const int ws_idx) const;
+
+  // Known-info hash computed from scratch, the incremental one must match it
+  KOKKOS_FUNCTION
+  uint64_t compute_zobrist(const int ws_idx) const;
+
+  // Canonical form of the known info, see matchem_cache.hpp
+  KOKKOS_FUNCTION
+  void canonicalize(const int ws_idx, canonical_form_t& form) const;
+
   // Validate state
   void validate_state(const int ws_idx) const;
 
+  // The known info or odds of side1 changed, so whatever query candidate or
+  // guess pick was derived from them is stale
+  KOKKOS_INLINE_FUNCTION
+  void mark_dirty(const int ws_idx, const int side1) const
+  {
+#ifdef EXTRA_TRACKING
+    setb(m_dirty_rows(ws_idx), side1);
+#endif
+    setb(m_guess_dirty_rows(ws_idx), side1);
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void mark_all_dirty(const int ws_idx) const
+  {
+#ifdef EXTRA_TRACKING
+    m_dirty_rows(ws_idx) = (1 << SIZE) - 1;
+#endif
+    m_guess_dirty_rows(ws_idx) = (1 << SIZE) - 1;
+  }
+
+#ifdef EXTRA_TRACKING
+  // Rescale odds so every side1 and side2 sums to 1 again
+  KOKKOS_FUNCTION
+  void normalize_odds(const int ws_idx);
+
+  // Recompute the best query candidate of each dirty row and replay the
+  // tournament above it
+  KOKKOS_FUNCTION
+  void update_query_tree(const int ws_idx);
+
+  // The unknown pair with the best odds, the first one in row-major order on
+  // ties, (-1, -1) if no unknown pair has any odds. Uses the tournament tree.
+  KOKKOS_FUNCTION
+  std::pair<int, int> get_best_odds_query(const int ws_idx);
+
+  // Same, by scanning every pair. The tree must agree with it, which the
+  // query tests check; games only use the tree.
+  KOKKOS_FUNCTION
+  std::pair<int, int> scan_best_odds_query(const int ws_idx) const;
+#endif
+
   ////////////////////////// EXTENSION POINTS //////////////////////////////////
 
-  // Select most-useful truth query
+  // Select most-useful truth query. Strategies that refine their answer stop
+  // once the budget expires, the bandit splits its rollouts over the team.
   KOKKOS_FUNCTION
-  std::pair<int, int> get_best_truth_query(const int ws_idx, const int round) const;
+  std::pair<int, int> get_best_truth_query(const int ws_idx, const int round,
+                                           const DecisionBudget& budget = DecisionBudget(),
+                                           const MemberType* team = nullptr);
 
   // Process ask result
   KOKKOS_FUNCTION
   void process_ask_result(const int ws_idx, const int round, const int side1_idx, const int side2_idx, bool was_match);
 
-  // Create the best guess you can.
+  // Create the best guess you can within the budget.
+  KOKKOS_FUNCTION
+  void make_guess(const int ws_idx, const int round, const DecisionBudget& budget = DecisionBudget(),
+                  const MemberType* team = nullptr);
+
+  // Count a guess made by a game (not a rollout) for telemetry
   KOKKOS_FUNCTION
-  void make_guess(const int ws_idx, const int round);
+  void count_guess(const int ws_idx);
 
   // Process guess result
   KOKKOS_FUNCTION
   void process_guess_result(const int ws_idx, const int round, const int matches);
 
+#ifdef EXTRA_TRACKING
+  // Note the score of round in m_round_info
+  KOKKOS_FUNCTION
+  void record_round(const int ws_idx, const int round, const int matches);
+
+  // Add how the game stands at the end of round to curves
+  KOKKOS_FUNCTION
+  void add_round_curves(const int ws_idx, const int round, const int matches, RoundCurves& curves) const;
+
+  // Entropy of the hidden state in bits, log2 of how many hidden states fit
+  // the pairs the truth queries ruled out. Ceremony scores do not constrain
+  // the count yet, so it is an upper bound once a guess has been scored.
+  KOKKOS_FUNCTION
+  double get_entropy(const int ws_idx) const;
+
+  // Entropy of each side1's odds in bits, summed over side1s. This treats the
+  // rows as independent, so it overstates the entropy of the hidden state.
+  KOKKOS_FUNCTION
+  double get_marginal_entropy(const int ws_idx) const;
+#endif
+
+  ////////////////////////// BANDIT ////////////////////////////////////////////
+
+  // The bandit strategy compares a few candidate decisions with UCB1, each
+  // pull a rollout from a sampled hidden state; there is no search tree. The
+  // rollouts of a decision are split over the threads of the team playing the
+  // game (root parallelization): each thread runs UCB1 on its share, and the
+  // pulls and rounds of the arms are summed over the team before the best arm
+  // is picked. Each thread plays its rollouts in its own rollout workspace,
+  // which uses a cheap default strategy and does not track odds.
+  KOKKOS_FUNCTION
+  bool is_rollout_ws(const int ws_idx) const { return ws_idx >= get_num_game_ws(); }
+
+  KOKKOS_FUNCTION
+  int get_rollout_ws(const int ws_idx) const { return ws_idx + get_num_game_ws(); }
+
+  // What the rollouts of one bandit decision found out about each arm
+  struct BanditArms
+  {
+    Kokkos::Array<int, MAX_BANDIT_ARMS> pulls;
+    Kokkos::Array<double, MAX_BANDIT_ARMS> total_rounds;
+    int num_pulls;
+
+    KOKKOS_INLINE_FUNCTION
+    void reset()
+    {
+      for (int a = 0; a < MAX_BANDIT_ARMS; ++a) {
+        pulls[a] = 0;
+        total_rounds[a] = 0.0;
+      }
+      num_pulls = 0;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    void merge(const BanditArms& other)
+    {
+      for (int a = 0; a < MAX_BANDIT_ARMS; ++a) {
+        pulls[a] += other.pulls[a];
+        total_rounds[a] += other.total_rounds[a];
+      }
+      num_pulls += other.num_pulls;
+    }
+  };
+
+  // Copy the known info of a game into another workspace
+  KOKKOS_FUNCTION
+  void fork_workspace(const int src_ws_idx, const int dst_ws_idx);
+
+  // Fill the rook workspace with the completion counts for the known info
+  KOKKOS_FUNCTION
+  void prepare_sampling(const int ws_idx);
+
+  // Draw a hidden state uniformly from all that fit known info. Requires prepare_sampling.
+  KOKKOS_FUNCTION
+  void sample_hidden_state(const int ws_idx, const int dst_ws_idx);
+
+  // Play the rest of a game in a rollout workspace, returns the number of rounds played
+  KOKKOS_FUNCTION
+  int rollout(const int rollout_ws_idx, const int first_round);
+
+  // Score the guess in a rollout workspace and, if it was wrong, play the game
+  // out. Returns the number of rounds played counting this one.
+  KOKKOS_FUNCTION
+  int finish_rollout_round(const int rollout_ws_idx, const int round);
+
+  // Try each arm with rollouts, returns the one that needs the fewest rounds.
+  // simulate(arm, rollout_ws_idx) plays one game with that arm and returns rounds.
+  // If the budget expires, the best arm so far is returned. With a team every
+  // thread must call this, and every thread gets the same arm.
+  template <typename Simulate>
+  KOKKOS_FUNCTION
+  int run_bandit(const int ws_idx, const int num_arms, const DecisionBudget& budget, const MemberType* team,
+                 const Simulate& simulate);
+
+  // Default strategy used inside rollouts
+  KOKKOS_FUNCTION
+  std::pair<int, int> get_rollout_truth_query(const int ws_idx) const;
+
+  KOKKOS_FUNCTION
+  void make_rollout_guess(const int ws_idx);
+
+  // Bandit versions of the extension points
+  KOKKOS_FUNCTION
+  std::pair<int, int> get_bandit_truth_query(const int ws_idx, const int round, const DecisionBudget& budget,
+                                             const MemberType* team);
+
+  KOKKOS_FUNCTION
+  void make_bandit_guess(const int ws_idx, const int round, const DecisionBudget& budget, const MemberType* team);
+
+  // The guess the heuristic strategy would make
+  KOKKOS_FUNCTION
+  void make_heuristic_guess(const int ws_idx, const int round);
+
+  // The side2 the heuristic guess gives side1 when the side2s in been_picked
+  // are already taken
+  KOKKOS_FUNCTION
+  int pick_heuristic_side2(const int ws_idx, const int side1, const int been_picked) const;
+
+#ifdef EXTRA_TRACKING
+  ////////////////////////// DISTILLED STRATEGY ////////////////////////////////
+
+  // The board the distilled model sees, cell i*SIZE + j for side1 i and side2 j
+  KOKKOS_FUNCTION
+  void get_board(const int ws_idx, float* odds, uint8_t* cells) const;
+
+  // Features of every pair for the distilled model, laid out as LinearModel
+  // expects
+  KOKKOS_FUNCTION
+  void get_features(const int ws_idx, float* features) const;
+
+  KOKKOS_FUNCTION
+  std::pair<int, int> get_distilled_truth_query(const int ws_idx) const;
+
+  KOKKOS_FUNCTION
+  void make_distilled_guess(const int ws_idx) const;
+
+  // Play a game like run_indv, recording every decision as a training sample
+  int run_indv_recorded(const int ws_idx, std::vector<LinearModel::Sample>& samples);
+#endif
+
+  ////////////////////////// DECISION CACHE ////////////////////////////////////
+
+  enum CachedDecision {
+    CACHED_QUERY,
+    CACHED_GUESS
+  };
+
+  // Look for a decision made earlier for this state or a relabeling of it. A
+  // query is written to decision[0..1], a guess to decision[0..SIZE-1].
+  KOKKOS_FUNCTION
+  bool find_cached_decision(const int ws_idx, const CachedDecision kind, int* decision);
+
+  KOKKOS_FUNCTION
+  void store_cached_decision(const int ws_idx, const CachedDecision kind, const int* decision);
+
+  ////////////////////////// DECISION TREE /////////////////////////////////////
+
+  // Add the round 0 truth query as the root of the tree
+  void seed_tree();
+
+  // Reset a workspace and play the first length observations along a path of
+  // tree nodes into it
+  KOKKOS_FUNCTION
+  void replay_tree_path(const int ws_idx, const int32_t* path, const int* outcomes, const int length);
+
+  ////////////////////////// OPENING BOOK //////////////////////////////////////
+
+  // Identifies the strategy (and tracking level) an opening book was built with
+  uint32_t get_strategy_tag() const;
+
+  // Record the decisions after a path of observations (alternating truth
+  // answers and ceremony scores) and every path that can follow it
+  void extend_book(std::vector<int>& observations);
+
+  // Reset a workspace and play a path of observations into it
+  void replay_observations(const int ws_idx, const std::vector<int>& observations);
+
   //////////////////////////////////////////////////////////////////////////////
   ///////////////////////////// DATA MEMBERS ///////////////////////////////////
   //////////////////////////////////////////////////////////////////////////////
@@ -176,6 +662,16 @@ class Matchem
   TeamPolicy m_policy;
   TeamUtils<> m_tu;
 
+  // Number of workspaces, one per thread of each concurrent team, doubled
+  // when the bandit needs rollout workspaces
+  int m_num_ws;
+
+  // How play_games spreads games over threads
+  WorkSplit m_split;
+
+  // Hardware counters around play_games, null without --perf-counters
+  std::unique_ptr<PerfCounters> m_perf;
+
   // idx0 of all views is the ws_idx
 
   // this is secret, should only be accessed during initialization and truth queries
@@ -192,16 +688,101 @@ class Matchem
 
   // idx1 represents id of side1, idx2 represents id of side2, value represents odds of match
   view_3d_dbl_t m_odds_info;
+
+  // Best query candidate of each side1: idx1 represents id of side1, values
+  // are the side2 (-1 for none) and its odds
+  view_2d_int_t m_row_best;
+  view_2d_dbl_t m_row_best_odds;
+
+  // Tournament tree over side1s, node 1 is the root and node n has children 2n
+  // and 2n+1. Leaves start at QUERY_TREE_LEAVES, values are the winning side1.
+  view_2d_int_t m_query_tree;
+
+  // Bitmask of side1s whose candidate is stale
+  view_1d_int_t m_dirty_rows;
 #endif
   view_2d_int_t m_known_info; // idx1 represents id of side1, value represents bitmask of known info
 
   view_2d_int_t m_guess_state; // idx1 represents id of side1, value represents side2
 
+  // What the heuristic guess picked for each side1 last time and which side2s
+  // earlier side1s had taken by then. A side1 that is not dirty and sees the
+  // same side2s taken picks the same again, see make_heuristic_guess.
+  view_2d_int_t m_guess_pick;
+  view_2d_int_t m_guess_taken;
+  view_1d_int_t m_guess_dirty_rows;
+
+  view_1d_u64_t m_guess_rows_touched; // per-workspace incremental guess statistics
+  view_1d_u64_t m_guess_builds;
+
+  view_2d_i64_t m_rook_ws; // scratch space for match_count_dist
+
+  view_1d_u64_t m_history; // hash of everything observed so far, see matchem_policy.hpp
+
+  view_1d_u64_t m_rng_state; // random stream for strategies that sample
+  uint64_t m_rng_seed;       // streams are this hashed with the game id
+
+  view_1d_u64_t m_zobrist; // hash of known info, kept up to date by set_state
+
+  view_1d_u64_t m_cache_hits;   // per-workspace decision cache statistics
+  view_1d_u64_t m_cache_misses;
+
+  view_1d_u64_t m_tree_lookups;  // per-workspace decision tree statistics
+  view_1d_u64_t m_tree_computes;
+
+  view_1d_u64_t m_bandit_decisions; // per-workspace bandit statistics, decisions on
+  view_1d_u64_t m_bandit_rollouts;  // the first thread of a team, rollouts on each
+
+#ifdef TELEMETRY
+  view<Telemetry*> m_telemetry; // per-workspace work counters
+#endif
+
+#ifdef PHASE_PROFILING
+  view<PhaseProfile*> m_profile; // per-workspace time per phase
+  PhaseSections m_sections;      // the phases for an attached Kokkos tool
+#endif
+
+  view_1d_u64_t m_budget_used;      // per-workspace decision budget statistics,
+  view_1d_u64_t m_budget_decisions; // in read_cycles ticks
+  view_1d_u64_t m_budget_deadlines;
+
+  // Ticks each decision may take, DecisionBudget::UNLIMITED for no limit
+  uint64_t m_budget_cycles;
+
+  // Ids of the games to play instead of random ones, see get_game_id
+  view_1d_int_t m_replay_games;
+
+  // Add the rounds of play_games' games to its curves
+  bool m_track_curves;
+
+  // Decisions for the OPTIMAL strategy, produced offline by MatchemSolver
+  PolicyTable m_policy_table;
+
+  // Weights for the DISTILLED strategy, produced by distill mode
+  LinearModel m_model;
+
+  // Precomputed early decisions, consulted before the strategy
+  OpeningBook m_book;
+
+  // Expensive decisions shared by all teams
+  DecisionCache m_cache;
+
+  // Every decision the (deterministic) strategy has made so far, shared by all teams
+  decision_tree_t m_tree;
+
   //////////////////////////////////////////////////////////////////////////////
   /////////////////////////////// FRIENDS //////////////////////////////////////
   //////////////////////////////////////////////////////////////////////////////
 
   friend struct matchem::tests::UnitWrap;
+
+  // Times the game phases one by one
+  friend struct matchem::bench::Benchmarks;
+
+  // Play games on their own terms, through the game phases
+  friend class MatchemTournament;
+  friend class MatchemSweep;
+  friend class MatchemScaling;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
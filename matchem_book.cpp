@@ -0,0 +1,167 @@
+#include "matchem_book.hpp"
+#include "matchem_exception.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace matchem {
+
+static const char BOOK_MAGIC[8] = {'M', 'T', 'C', 'H', 'B', 'O', 'O', 'K'};
+
+////////////////////////////////////////////////////////////////////////////////
+OpeningBook::OpeningBook() :
+////////////////////////////////////////////////////////////////////////////////
+  m_header(),
+  m_slots(nullptr),
+  m_owned(),
+  m_mapping(nullptr),
+  m_mapping_size(0)
+{}
+
+////////////////////////////////////////////////////////////////////////////////
+OpeningBook::~OpeningBook()
+////////////////////////////////////////////////////////////////////////////////
+{
+  unmap();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void OpeningBook::unmap()
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (m_mapping != nullptr) {
+    munmap(m_mapping, m_mapping_size);
+    m_mapping = nullptr;
+    m_mapping_size = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void OpeningBook::open(const std::string& filename, const int expected_size, const uint32_t expected_strategy_tag)
+////////////////////////////////////////////////////////////////////////////////
+{
+  unmap();
+  m_owned.clear();
+  m_slots = nullptr;
+
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  my_require(fd >= 0, "Could not open opening book: " + filename);
+
+  struct stat info;
+  const bool stat_ok = fstat(fd, &info) == 0;
+  const size_t file_size = stat_ok ? info.st_size : 0;
+  void* mapping = file_size >= sizeof(Header) ? mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+  my_require(mapping != MAP_FAILED, "Could not map opening book: " + filename);
+
+  m_mapping = mapping;
+  m_mapping_size = file_size;
+
+  std::memcpy(&m_header, mapping, sizeof(Header));
+  my_require(std::memcmp(m_header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) == 0,
+             "Not an opening book: " + filename);
+  my_require(static_cast<int>(m_header.set_size) == expected_size,
+             "Opening book " + filename + " is for set size " + obj_to_str(m_header.set_size) +
+             ", expected " + obj_to_str(expected_size));
+  my_require(m_header.strategy_tag == expected_strategy_tag,
+             "Opening book " + filename + " was built for a different strategy or tracking level");
+  my_require(m_header.num_slots > 0 && (m_header.num_slots & (m_header.num_slots - 1)) == 0 &&
+             file_size == sizeof(Header) + m_header.num_slots*sizeof(Entry),
+             "Corrupt opening book: " + filename);
+
+  m_slots = reinterpret_cast<const Entry*>(static_cast<const char*>(mapping) + sizeof(Header));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void OpeningBook::reset(const int set_size, const uint32_t strategy_tag, const int depth)
+////////////////////////////////////////////////////////////////////////////////
+{
+  my_require(set_size <= MAX_SIZE, "Set size too big for an opening book");
+
+  unmap();
+
+  std::memcpy(m_header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+  m_header.set_size     = set_size;
+  m_header.strategy_tag = strategy_tag;
+  m_header.depth        = depth;
+  m_header.unused       = 0;
+  m_header.num_slots    = 1024;
+  m_header.num_entries  = 0;
+
+  m_owned.assign(m_header.num_slots, Entry());
+  m_slots = m_owned.data();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void OpeningBook::save(const std::string& filename) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ofstream out(filename, std::ios::binary);
+  my_require(out.good(), "Could not write opening book: " + filename);
+
+  out.write(reinterpret_cast<const char*>(&m_header), sizeof(Header));
+  out.write(reinterpret_cast<const char*>(m_slots), m_header.num_slots*sizeof(Entry));
+  my_require(out.good(), "Failed writing opening book: " + filename);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+OpeningBook::Entry& OpeningBook::insert(const uint64_t key)
+////////////////////////////////////////////////////////////////////////////////
+{
+  my_require(m_mapping == nullptr, "Cannot add to a mapped opening book");
+
+  // Keep the table at most half full so probes stay short
+  if (2*(m_header.num_entries + 1) > m_header.num_slots) {
+    std::vector<Entry> old_slots(2*m_header.num_slots, Entry());
+    old_slots.swap(m_owned);
+    m_header.num_slots *= 2;
+    m_header.num_entries = 0;
+    m_slots = m_owned.data();
+    for (const Entry& entry : old_slots) {
+      if (entry.key != 0) {
+        insert(entry.key) = entry;
+      }
+    }
+  }
+
+  const uint64_t mask = m_header.num_slots - 1;
+  uint64_t slot = key & mask;
+  while (m_owned[slot].key != 0 && m_owned[slot].key != key) {
+    slot = (slot + 1) & mask;
+  }
+
+  Entry& entry = m_owned[slot];
+  if (entry.key == 0) {
+    entry.key = key;
+    ++m_header.num_entries;
+  }
+  return entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void OpeningBook::add_query(const uint64_t history, const int side1, const int side2)
+////////////////////////////////////////////////////////////////////////////////
+{
+  Entry& entry = insert(make_key(history, QUERY));
+  std::memset(entry.decision, -1, sizeof(entry.decision));
+  entry.decision[0] = side1;
+  entry.decision[1] = side2;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void OpeningBook::add_guess(const uint64_t history, const int* guess)
+////////////////////////////////////////////////////////////////////////////////
+{
+  Entry& entry = insert(make_key(history, GUESS));
+  std::memset(entry.decision, -1, sizeof(entry.decision));
+  for (uint32_t i = 0; i < m_header.set_size; ++i) {
+    entry.decision[i] = guess[i];
+  }
+}
+
+}
@@ -0,0 +1,148 @@
+#ifndef MATCHEM_BOOK_HPP
+#define MATCHEM_BOOK_HPP
+
+#include "matchem_common.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace matchem {
+
+/**
+ * An opening book holds the decisions a strategy makes in the first few rounds
+ * of a game, keyed by observation history (see matchem_policy.hpp). Every game
+ * starts from the same state, so these few situations come up over and over
+ * and are worth computing once, offline.
+ *
+ * On disk the book is a header followed by an open-addressing hash table, so
+ * the simulator can mmap it and look decisions up without parsing anything.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class OpeningBook
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  // Largest set size a book entry has room for
+  static constexpr int MAX_SIZE = 16;
+
+  struct Header
+  {
+    char     magic[8];
+    uint32_t set_size;
+    uint32_t strategy_tag; // which strategy made the decisions
+    uint32_t depth;        // how many rounds the book covers
+    uint32_t unused;
+    uint64_t num_slots;    // always a power of two
+    uint64_t num_entries;
+  };
+
+  struct Entry
+  {
+    uint64_t key; // 0 means empty
+    int8_t   decision[MAX_SIZE];
+  };
+
+  OpeningBook();
+
+  ~OpeningBook();
+
+  /**
+   * open - Map a book written by save. Throws a MatchemException if the file
+   *        cannot be read or was made for a different set size or strategy.
+   */
+  void open(const std::string& filename, const int expected_size, const uint32_t expected_strategy_tag);
+
+  /**
+   * reset - Start an empty in-memory book
+   */
+  void reset(const int set_size, const uint32_t strategy_tag, const int depth);
+
+  /**
+   * save - Write the book to a binary file
+   */
+  void save(const std::string& filename) const;
+
+  void add_query(const uint64_t history, const int side1, const int side2);
+
+  void add_guess(const uint64_t history, const int* guess);
+
+  // Queries. These are safe to call concurrently once the book is built.
+
+  bool find_query(const uint64_t history, std::pair<int, int>& query) const
+  {
+    const Entry* entry = find(make_key(history, QUERY));
+    if (entry == nullptr) {
+      return false;
+    }
+    query = std::make_pair(static_cast<int>(entry->decision[0]), static_cast<int>(entry->decision[1]));
+    return true;
+  }
+
+  bool find_guess(const uint64_t history, int* guess) const
+  {
+    const Entry* entry = find(make_key(history, GUESS));
+    if (entry == nullptr) {
+      return false;
+    }
+    for (uint32_t i = 0; i < m_header.set_size; ++i) {
+      guess[i] = entry->decision[i];
+    }
+    return true;
+  }
+
+  bool empty() const { return m_header.num_entries == 0; }
+
+  size_t num_entries() const { return m_header.num_entries; }
+
+  int depth() const { return m_header.depth; }
+
+ private:
+
+  OpeningBook(const OpeningBook&) = delete;
+  OpeningBook& operator=(const OpeningBook&) = delete;
+
+  enum EntryKind {QUERY = 1, GUESS = 2};
+
+  static uint64_t make_key(const uint64_t history, const EntryKind kind)
+  {
+    const uint64_t key = hash_combine(history, kind);
+    return key == 0 ? 1 : key;
+  }
+
+  const Entry* find(const uint64_t key) const
+  {
+    if (m_slots == nullptr) {
+      return nullptr;
+    }
+    const uint64_t mask = m_header.num_slots - 1;
+    for (uint64_t slot = key & mask; ; slot = (slot + 1) & mask) {
+      if (m_slots[slot].key == key) {
+        return &m_slots[slot];
+      }
+      else if (m_slots[slot].key == 0) {
+        return nullptr;
+      }
+    }
+  }
+
+  Entry& insert(const uint64_t key);
+
+  void unmap();
+
+  Header m_header;
+
+  // Points into m_owned while building, into the mapping once opened
+  const Entry* m_slots;
+  std::vector<Entry> m_owned;
+
+  void*  m_mapping;
+  size_t m_mapping_size;
+};
+
+}
+
+#endif
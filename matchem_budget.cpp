@@ -0,0 +1,24 @@
+#include "matchem_budget.hpp"
+
+namespace matchem {
+
+////////////////////////////////////////////////////////////////////////////////
+double cycles_per_usec()
+////////////////////////////////////////////////////////////////////////////////
+{
+  // Spin for a few milliseconds against the steady clock. Thread-safe since
+  // C++11 static initialization is.
+  static const double result = [] {
+    const auto start_time = std::chrono::steady_clock::now();
+    const uint64_t start_cycles = read_cycles();
+    std::chrono::steady_clock::duration elapsed;
+    do {
+      elapsed = std::chrono::steady_clock::now() - start_time;
+    } while (elapsed < std::chrono::milliseconds(5));
+    const uint64_t cycles = read_cycles() - start_cycles;
+    return cycles / (1e-3 * std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }();
+  return result;
+}
+
+}
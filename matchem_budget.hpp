@@ -0,0 +1,83 @@
+#ifndef MATCHEM_BUDGET_HPP
+#define MATCHEM_BUDGET_HPP
+
+#include "matchem_common.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace matchem {
+
+// A cheap, monotonic tick counter. On x86 this is the time stamp counter,
+// elsewhere it falls back on the steady clock in nanoseconds.
+KOKKOS_INLINE_FUNCTION
+uint64_t read_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// How many read_cycles ticks make a microsecond, measured once
+double cycles_per_usec();
+
+/**
+ * How much time a strategy may spend on one decision. Strategies that refine
+ * a best-so-far answer check expired() between steps and stop once it is
+ * true; strategies that do a fixed amount of work ignore it. A default
+ * constructed budget never expires.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class DecisionBudget
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  static constexpr uint64_t UNLIMITED = 0;
+
+  KOKKOS_INLINE_FUNCTION
+  explicit DecisionBudget(const uint64_t cycles = UNLIMITED) :
+    m_start(cycles == UNLIMITED ? 0 : read_cycles()),
+    m_cycles(cycles),
+    m_hit_deadline(false)
+  {}
+
+  KOKKOS_INLINE_FUNCTION
+  bool limited() const { return m_cycles != UNLIMITED; }
+
+  // Has the deadline passed? Remembers if the answer was ever yes.
+  KOKKOS_INLINE_FUNCTION
+  bool expired() const
+  {
+    if (limited() && read_cycles() - m_start >= m_cycles) {
+      m_hit_deadline = true;
+    }
+    return m_hit_deadline;
+  }
+
+  // Did the strategy stop early because of the deadline?
+  KOKKOS_INLINE_FUNCTION
+  bool hit_deadline() const { return m_hit_deadline; }
+
+  // Ticks spent since the budget was started, 0 for unlimited budgets
+  KOKKOS_INLINE_FUNCTION
+  uint64_t used() const { return limited() ? read_cycles() - m_start : 0; }
+
+ private:
+
+  uint64_t m_start;
+  uint64_t m_cycles;
+  mutable bool m_hit_deadline;
+};
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include "matchem_cache.hpp"
+#include "matchem_exception.hpp"
+
+#include <cstring>
+
+#include <sys/mman.h>
+
+namespace matchem {
+
+static_assert(sizeof(uint64_t)*2 == DecisionCache::MAX_SIZE, "Decision must fill the slot words");
+
+////////////////////////////////////////////////////////////////////////////////
+DecisionCache::DecisionCache() :
+////////////////////////////////////////////////////////////////////////////////
+  m_buckets(nullptr),
+  m_mask(0),
+  m_num_bytes(0),
+  m_huge_pages(false)
+{}
+
+////////////////////////////////////////////////////////////////////////////////
+DecisionCache::~DecisionCache()
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (m_buckets != nullptr) {
+    munmap(m_buckets, m_num_bytes);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void DecisionCache::init(const size_t num_bytes, const bool huge_pages)
+////////////////////////////////////////////////////////////////////////////////
+{
+  my_require(m_buckets == nullptr, "Decision cache is already initialized");
+
+  if (num_bytes < sizeof(Bucket)) {
+    return;
+  }
+
+  // Round down to a power of two number of buckets so probing is a mask
+  uint64_t num_buckets = 1;
+  while (2*num_buckets*sizeof(Bucket) <= num_bytes) {
+    num_buckets *= 2;
+  }
+  m_num_bytes = num_buckets*sizeof(Bucket);
+
+  // Anonymous mappings come back zeroed, which is an empty table, and are
+  // page aligned, which huge pages want
+  void* mem = mmap(nullptr, m_num_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  my_require(mem != MAP_FAILED, "Could not allocate decision cache of " + obj_to_str(m_num_bytes) + " bytes");
+
+#ifdef MADV_HUGEPAGE
+  if (huge_pages) {
+    m_huge_pages = madvise(mem, m_num_bytes, MADV_HUGEPAGE) == 0;
+  }
+#endif
+
+  m_buckets = static_cast<Bucket*>(mem);
+  m_mask = num_buckets - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void DecisionCache::clear()
+////////////////////////////////////////////////////////////////////////////////
+{
+  // All zero is an empty table, same as a fresh mapping
+  if (m_buckets != nullptr) {
+    std::memset(static_cast<void*>(m_buckets), 0, m_num_bytes);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool DecisionCache::find(const uint64_t key, int8_t* decision) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  const Bucket& bucket = m_buckets[key & m_mask];
+  for (const Slot& slot : bucket.slots) {
+    const uint32_t before = slot.seq.load(std::memory_order_acquire);
+    if ((before & 1) != 0 || slot.key.load(std::memory_order_relaxed) != key) {
+      continue;
+    }
+
+    uint64_t words[MAX_SIZE / sizeof(uint64_t)];
+    for (int w = 0; w < MAX_SIZE / static_cast<int>(sizeof(uint64_t)); ++w) {
+      words[w] = slot.decision[w].load(std::memory_order_relaxed);
+    }
+
+    // If a writer got in while we were reading, what we read may be torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != before) {
+      continue;
+    }
+
+    std::memcpy(decision, words, MAX_SIZE);
+    return true;
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void DecisionCache::store(const uint64_t key, const uint32_t priority, const int8_t* decision)
+////////////////////////////////////////////////////////////////////////////////
+{
+  Bucket& bucket = m_buckets[key & m_mask];
+  Slot& keeper = bucket.slots[0];
+
+  // These reads can race with writers, the worst outcome is a poor choice of slot
+  const uint64_t keeper_key = keeper.key.load(std::memory_order_relaxed);
+  if (keeper_key == 0 || keeper_key == key || keeper.priority.load(std::memory_order_relaxed) <= priority) {
+    write_slot(keeper, key, priority, decision);
+  }
+  else {
+    write_slot(bucket.slots[1], key, priority, decision);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool DecisionCache::write_slot(Slot& slot, const uint64_t key, const uint32_t priority, const int8_t* decision)
+////////////////////////////////////////////////////////////////////////////////
+{
+  uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+  if ((seq & 1) != 0 || !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+    return false; // someone else is writing this slot
+  }
+  // Readers that see any of the new data must also see the odd sequence
+  std::atomic_thread_fence(std::memory_order_release);
+
+  uint64_t words[MAX_SIZE / sizeof(uint64_t)];
+  std::memcpy(words, decision, MAX_SIZE);
+
+  slot.key.store(key, std::memory_order_relaxed);
+  slot.priority.store(priority, std::memory_order_relaxed);
+  for (int w = 0; w < MAX_SIZE / static_cast<int>(sizeof(uint64_t)); ++w) {
+    slot.decision[w].store(words[w], std::memory_order_relaxed);
+  }
+
+  slot.seq.store(seq + 2, std::memory_order_release);
+  return true;
+}
+
+}
@@ -0,0 +1,247 @@
+#ifndef MATCHEM_CACHE_HPP
+#define MATCHEM_CACHE_HPP
+
+#include "matchem_common.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace matchem {
+
+/**
+ * Knowledge states that only differ by a relabeling of side1 and side2 call
+ * for the same decision, relabeled the same way. This file has a canonical
+ * form for the known-info board (and optionally the scored guesses), plus a
+ * bounded hash table that lets every thread share decisions keyed by it.
+ */
+
+constexpr uint64_t ZOBRIST_SEED = 0x7a6f62726973740aULL;
+
+// Zobrist key for learning that side1 i does (or does not) match side2 j. The
+// known-info hash of a game is the xor of the keys of everything it knows.
+KOKKOS_INLINE_FUNCTION
+uint64_t zobrist_key(const int side1, const int side2, const bool is_match)
+{
+  return hash_combine(ZOBRIST_SEED, (side1*32 + side2)*2 + (is_match ? 1 : 0));
+}
+
+template <int N>
+struct CanonicalForm
+{
+  uint64_t key;
+  int rows[N];    // rows[p] is the side1 at canonical position p
+  int cols[N];    // cols[q] is the side2 at canonical position q
+  int row_pos[N]; // inverse of rows
+  int col_pos[N]; // inverse of cols
+};
+
+template <int N>
+KOKKOS_FUNCTION
+void sort_by_signature(const uint64_t* sigs, int* order, int* pos)
+{
+  // Insertion sort, ties keep index order. N is tiny.
+  for (int i = 0; i < N; ++i) {
+    order[i] = i;
+  }
+  for (int i = 1; i < N; ++i) {
+    const int item = order[i];
+    int k = i;
+    for (; k > 0 && sigs[order[k-1]] > sigs[item]; --k) {
+      order[k] = order[k-1];
+    }
+    order[k] = item;
+  }
+  for (int p = 0; p < N; ++p) {
+    pos[order[p]] = p;
+  }
+}
+
+/**
+ * canonicalize - Relabel a known-info board into canonical order.
+ *
+ * known_info[i] packs the int16 masks of known matches and known misses of
+ * side1 i, the same layout Matchem uses. If num_rounds > 0, the guess side1 i
+ * made in round r is guesses[i*guess_stride + r] and scores[r] is its score.
+ *
+ * Rows and columns are ordered by a signature refined from their neighbors,
+ * ties broken by label. Equal keys therefore always mean the states are
+ * relabelings of each other, but a few relabelings of the same state may still
+ * get different keys. That only costs cache hits.
+ */
+template <int N>
+KOKKOS_FUNCTION
+void canonicalize(const int* known_info, const int num_rounds, const int* guesses, const int guess_stride,
+                  const int* scores, CanonicalForm<N>& form)
+{
+  static_assert(N <= 16, "Known info masks are int16");
+
+  int row_matches[N], row_misses[N], col_matches[N], col_misses[N];
+  for (int k = 0; k < N; ++k) {
+    col_matches[k] = 0;
+    col_misses[k]  = 0;
+  }
+  for (int i = 0; i < N; ++i) {
+    const int16_t* pieces = reinterpret_cast<const int16_t*>(&known_info[i]);
+    row_matches[i] = static_cast<uint16_t>(pieces[0]);
+    row_misses[i]  = static_cast<uint16_t>(pieces[1]);
+    for (int j = 0; j < N; ++j) {
+      if (is_setb(row_matches[i], j)) { setb(col_matches[j], i); }
+      if (is_setb(row_misses[i], j))  { setb(col_misses[j], i); }
+    }
+  }
+
+  auto guess = [&](const int i, const int r) { return guesses[i*guess_stride + r]; };
+
+  // Initial signatures only look at the row or column itself
+  uint64_t row_sig[N], col_sig[N];
+  for (int k = 0; k < N; ++k) {
+    row_sig[k] = hash_combine(popcount(row_misses[k]), popcount(row_matches[k]));
+    col_sig[k] = hash_combine(popcount(col_misses[k]), popcount(col_matches[k]));
+  }
+  for (int r = 0; r < num_rounds; ++r) {
+    for (int i = 0; i < N; ++i) {
+      const int j = guess(i, r);
+      const int cell = is_setb(row_matches[i], j) ? 2 : (is_setb(row_misses[i], j) ? 1 : 0);
+      const uint64_t feature = hash_combine(hash_combine(r, scores[r]), cell);
+      row_sig[i] = hash_combine(row_sig[i], feature);
+      col_sig[j] = hash_combine(col_sig[j], feature);
+    }
+  }
+
+  // Refine each signature with the multiset of its neighbors' signatures. Sums
+  // of mixed values do not depend on the order the neighbors are visited in.
+  for (int pass = 0; pass < 2; ++pass) {
+    uint64_t new_row_sig[N], new_col_sig[N];
+    for (int k = 0; k < N; ++k) {
+      uint64_t row_acc = 0, col_acc = 0;
+      for (int l = 0; l < N; ++l) {
+        if (is_setb(row_misses[k], l))  { row_acc += hash_combine(col_sig[l], 1); }
+        if (is_setb(row_matches[k], l)) { row_acc += hash_combine(col_sig[l], 2); }
+        if (is_setb(col_misses[k], l))  { col_acc += hash_combine(row_sig[l], 1); }
+        if (is_setb(col_matches[k], l)) { col_acc += hash_combine(row_sig[l], 2); }
+      }
+      for (int r = 0; r < num_rounds; ++r) {
+        row_acc += hash_combine(col_sig[guess(k, r)], 3 + r);
+      }
+      new_row_sig[k] = hash_combine(row_sig[k], row_acc);
+      new_col_sig[k] = hash_combine(col_sig[k], col_acc);
+    }
+    for (int r = 0; r < num_rounds; ++r) {
+      for (int i = 0; i < N; ++i) {
+        new_col_sig[guess(i, r)] = hash_combine(new_col_sig[guess(i, r)], hash_combine(row_sig[i], 3 + r));
+      }
+    }
+    for (int k = 0; k < N; ++k) {
+      row_sig[k] = new_row_sig[k];
+      col_sig[k] = new_col_sig[k];
+    }
+  }
+
+  sort_by_signature<N>(row_sig, form.rows, form.row_pos);
+  sort_by_signature<N>(col_sig, form.cols, form.col_pos);
+
+  // The key hashes the relabeled board itself
+  uint64_t key = hash_combine(ZOBRIST_SEED, N);
+  for (int p = 0; p < N; ++p) {
+    const int i = form.rows[p];
+    int matches = 0, misses = 0;
+    for (int q = 0; q < N; ++q) {
+      const int j = form.cols[q];
+      if (is_setb(row_matches[i], j)) { setb(matches, q); }
+      if (is_setb(row_misses[i], j))  { setb(misses, q); }
+    }
+    key = hash_combine(key, (static_cast<uint64_t>(matches) << 16) | misses);
+  }
+  for (int r = 0; r < num_rounds; ++r) {
+    key = hash_combine(key, 1000 + scores[r]);
+    for (int p = 0; p < N; ++p) {
+      key = hash_combine(key, form.col_pos[guess(form.rows[p], r)]);
+    }
+  }
+  form.key = key;
+}
+
+/**
+ * A fixed-size table of decisions that any number of threads can read and
+ * write at once without locks. Every slot is guarded by a sequence number
+ * (a seqlock): writers make it odd while they work and readers retry nothing,
+ * they simply treat a slot that changed under them as a miss. A writer that
+ * finds a slot busy drops its write; the table is a cache, losing an entry is
+ * fine.
+ *
+ * Buckets hold two slots in one cache line. The first keeps the entry with the
+ * highest priority (callers use how early in the game the state is, since
+ * early states are shared by more games), the second always takes the newest.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class DecisionCache
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  // Largest decision a slot can hold
+  static constexpr int MAX_SIZE = 16;
+
+  DecisionCache();
+
+  ~DecisionCache();
+
+  /**
+   * init - Allocate about num_bytes worth of slots, asking the OS for huge
+   *        pages if requested. A size of zero leaves the cache disabled.
+   */
+  void init(const size_t num_bytes, const bool huge_pages);
+
+  /**
+   * clear - Forget every decision, keeping the memory
+   */
+  void clear();
+
+  bool enabled() const { return m_buckets != nullptr; }
+
+  size_t num_slots() const { return 2*(m_mask + 1); }
+
+  bool has_huge_pages() const { return m_huge_pages; }
+
+  // Keys must not be 0, see make_key
+  static uint64_t make_key(const uint64_t hash, const int kind)
+  {
+    const uint64_t key = hash_combine(hash, kind);
+    return key == 0 ? 1 : key;
+  }
+
+  bool find(const uint64_t key, int8_t* decision) const;
+
+  void store(const uint64_t key, const uint32_t priority, const int8_t* decision);
+
+ private:
+
+  DecisionCache(const DecisionCache&) = delete;
+  DecisionCache& operator=(const DecisionCache&) = delete;
+
+  struct Slot
+  {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> priority;
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> decision[MAX_SIZE / sizeof(uint64_t)];
+  };
+
+  struct alignas(64) Bucket
+  {
+    Slot slots[2];
+  };
+
+  static bool write_slot(Slot& slot, const uint64_t key, const uint32_t priority, const int8_t* decision);
+
+  Bucket* m_buckets;
+  uint64_t m_mask;
+  size_t m_num_bytes;
+  bool m_huge_pages;
+};
+
+}
+
+#endif
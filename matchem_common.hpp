@@ -8,6 +8,8 @@
 #include <vector>
 #include <limits>
 #include <cmath>
+#include <cstdint>
+#include <type_traits>
 
 #include "matchem_kokkos.hpp"
 
@@ -67,6 +69,115 @@ void clearb(T& val, const int bitidx)
   val &= ~(1LL << bitidx);
 }
 
+template <typename T>
+KOKKOS_INLINE_FUNCTION
+int popcount(const T val)
+{
+  return __builtin_popcountll(static_cast<typename std::make_unsigned<T>::type>(val));
+}
+
+// Fold val into a running 64-bit hash (splitmix64 finalizer)
+KOKKOS_INLINE_FUNCTION
+uint64_t hash_combine(const uint64_t seed, const uint64_t val)
+{
+  uint64_t z = seed ^ (val + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Small, fast pseudo-random number generator (splitmix64). Its whole state is
+ * one integer, so every game or thread can cheaply carry its own stream.
+ */
+struct Rng
+{
+  uint64_t state;
+
+  KOKKOS_INLINE_FUNCTION
+  explicit Rng(const uint64_t seed) : state(seed) {}
+
+  KOKKOS_INLINE_FUNCTION
+  uint64_t next()
+  {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform integer in [0, n)
+  template <typename T>
+  KOKKOS_INLINE_FUNCTION
+  T below(const T n)
+  {
+    return static_cast<T>(next() % static_cast<uint64_t>(n));
+  }
+
+  // Uniform double in [0, 1)
+  KOKKOS_INLINE_FUNCTION
+  double uniform()
+  {
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+  }
+};
+
+KOKKOS_INLINE_FUNCTION
+int64_t factorial(const int n)
+{
+  int64_t result = 1;
+  for (int k = 2; k <= n; ++k) {
+    result *= k;
+  }
+  return result;
+}
+
+// The rank'th permutation of 0..N-1 in lexicographic order, rank < N!
+template <int N>
+KOKKOS_FUNCTION
+void unrank_permutation(int64_t rank, int* perm)
+{
+  int unused = (1 << N) - 1;
+  for (int i = 0; i < N; ++i) {
+    const int64_t block = factorial(N - 1 - i);
+    int skip = static_cast<int>(rank / block);
+    rank %= block;
+    for (int j = 0; j < N; ++j) {
+      if (is_setb(unused, j) && skip-- == 0) {
+        perm[i] = j;
+        clearb(unused, j);
+        break;
+      }
+    }
+  }
+}
+
+// Inverse of unrank_permutation
+template <int N>
+KOKKOS_FUNCTION
+int64_t rank_permutation(const int* perm)
+{
+  int64_t rank = 0;
+  int unused = (1 << N) - 1;
+  for (int i = 0; i < N; ++i) {
+    const int smaller = popcount(unused & ((1 << perm[i]) - 1));
+    rank += smaller * factorial(N - 1 - i);
+    clearb(unused, perm[i]);
+  }
+  return rank;
+}
+
+// Tell the compiler the next loop carries no dependencies so it can vectorize it
+#if defined(__INTEL_COMPILER)
+#define MATCHEM_IVDEP _Pragma("ivdep")
+#elif defined(__clang__)
+#define MATCHEM_IVDEP _Pragma("clang loop vectorize(enable)")
+#elif defined(__GNUC__)
+#define MATCHEM_IVDEP _Pragma("GCC ivdep")
+#else
+#define MATCHEM_IVDEP
+#endif
+
 template <int Size, typename ...Parms>
 KOKKOS_FUNCTION
 void check_even_spread(
@@ -1,10 +1,37 @@
 #include "matchem_config.hpp"
 #include "matchem_exception.hpp"
 
+#include <algorithm>
 #include <sstream>
 
 namespace matchem {
 
+////////////////////////////////////////////////////////////////////////////////
+const char* strategy_name(const StrategyType strategy)
+////////////////////////////////////////////////////////////////////////////////
+{
+  switch (strategy) {
+  case HEURISTIC: return "heuristic";
+  case OPTIMAL:   return "optimal";
+  case BANDIT:    return "bandit";
+  case DISTILLED: return "distilled";
+  }
+  return "unknown";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool parse_strategy(const std::string& name, StrategyType& strategy)
+////////////////////////////////////////////////////////////////////////////////
+{
+  for (const StrategyType candidate : {HEURISTIC, OPTIMAL, BANDIT, DISTILLED}) {
+    if (name == strategy_name(candidate)) {
+      strategy = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 MatchemConfig::MatchemConfig(
 ////////////////////////////////////////////////////////////////////////////////
@@ -13,7 +40,36 @@ MatchemConfig::MatchemConfig(
   const bool verbose) :
   m_sim_type(sim_type),
   m_num_runs(num_runs),
-  m_verbose(verbose)
+  m_verbose(verbose),
+  m_strategy(HEURISTIC),
+  m_solve_size(5),
+  m_policy_file(),
+  m_bandit_rollouts(64),
+  m_bandit_candidates(8),
+  m_bandit_exploration(2.0),
+  m_bandit_threads(1),
+  m_book_file(),
+  m_book_depth(3),
+  m_decision_cache_mb(0),
+  m_huge_pages(false),
+  m_decision_tree_mb(0),
+  m_model_file(),
+  m_decision_budgets_us(),
+  m_season_limits(1, 10),
+  m_curves_file(),
+  m_replay_games(),
+  m_telemetry_file(),
+  m_target_ci(0.0),
+  m_max_runs(1000000),
+  m_checkpoint_file(),
+  m_tournament_strategies(),
+  m_tune_candidates(16),
+  m_grid_file(),
+  m_results_file(),
+  m_threads(0),
+  m_games_per_item(0),
+  m_calibration_file(),
+  m_perf_counters()
 {}
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -21,9 +77,105 @@ std::ostream& MatchemConfig::operator<<(std::ostream& out) const
 ////////////////////////////////////////////////////////////////////////////////
 {
   out << "sim type: " << m_sim_type << "\n";
-  out << "num runs: " << m_num_runs << "\n";
+  if (m_target_ci > 0.0) {
+    out << "target CI: +/- " << m_target_ci << " rounds\n";
+    out << "max runs: " << m_max_runs << "\n";
+  }
+  else {
+    out << "num runs: " << m_num_runs << "\n";
+  }
   out << "set size: " << SET_SIZE << "\n";
   out << "verbose: "  << m_verbose << "\n";
+  if (m_sim_type == TOURNAMENT) {
+    out << "tournament strategies:";
+    for (const StrategyType strategy : m_tournament_strategies) {
+      out << " " << strategy;
+    }
+    out << "\n";
+  }
+  else {
+    out << "strategy: " << m_strategy << "\n";
+  }
+  if (m_sim_type == SOLVE) {
+    out << "solve size: " << m_solve_size << "\n";
+  }
+  if (m_strategy == BANDIT || m_sim_type == TUNE || std::count(m_tournament_strategies.begin(), m_tournament_strategies.end(), BANDIT) > 0) {
+    out << "bandit rollouts: " << m_bandit_rollouts << "\n";
+    out << "bandit candidates: " << m_bandit_candidates << "\n";
+    out << "bandit exploration: " << m_bandit_exploration << "\n";
+    out << "bandit threads: " << m_bandit_threads << "\n";
+  }
+  if (m_sim_type == TUNE) {
+    out << "tune candidates: " << m_tune_candidates << "\n";
+  }
+  if (!m_grid_file.empty()) {
+    out << "grid file: " << m_grid_file << "\n";
+  }
+  if (!m_results_file.empty()) {
+    out << "results file: " << m_results_file << "\n";
+  }
+  if (m_threads > 0) {
+    out << "threads: " << m_threads << "\n";
+  }
+  if (m_games_per_item > 0) {
+    out << "games per work item: " << m_games_per_item << "\n";
+  }
+  if (!m_calibration_file.empty()) {
+    out << "calibration file: " << m_calibration_file << "\n";
+  }
+  if (!m_perf_counters.empty()) {
+    out << "perf counters:";
+    for (const std::string& event : m_perf_counters) {
+      out << " " << event;
+    }
+    out << "\n";
+  }
+  if (!m_policy_file.empty()) {
+    out << "policy file: " << m_policy_file << "\n";
+  }
+  if (m_sim_type == BUILD_BOOK) {
+    out << "book depth: " << m_book_depth << "\n";
+  }
+  if (!m_book_file.empty()) {
+    out << "book file: " << m_book_file << "\n";
+  }
+  if (m_decision_cache_mb > 0) {
+    out << "decision cache: " << m_decision_cache_mb << " MB" << (m_huge_pages ? " (huge pages)" : "") << "\n";
+  }
+  if (m_decision_tree_mb > 0) {
+    out << "decision tree: " << m_decision_tree_mb << " MB\n";
+  }
+  if (!m_model_file.empty()) {
+    out << "model file: " << m_model_file << "\n";
+  }
+  if (!m_decision_budgets_us.empty()) {
+    out << "decision budgets (us):";
+    for (const int budget : m_decision_budgets_us) {
+      out << " " << budget;
+    }
+    out << "\n";
+  }
+  out << "season limits:";
+  for (const int limit : m_season_limits) {
+    out << " " << limit;
+  }
+  out << "\n";
+  if (!m_curves_file.empty()) {
+    out << "curves file: " << m_curves_file << "\n";
+  }
+  if (!m_replay_games.empty()) {
+    out << "replay games:";
+    for (const int game : m_replay_games) {
+      out << " " << game;
+    }
+    out << "\n";
+  }
+  if (!m_telemetry_file.empty()) {
+    out << "telemetry file: " << m_telemetry_file << "\n";
+  }
+  if (!m_checkpoint_file.empty()) {
+    out << "checkpoint file: " << m_checkpoint_file << "\n";
+  }
 
   return out;
 }
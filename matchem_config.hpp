@@ -7,7 +7,14 @@
 
 namespace matchem {
 
-enum SimulationType {BASIC};
+enum SimulationType {BASIC, SOLVE, BUILD_BOOK, EXACT, DISTILL, TOURNAMENT, TUNE, SWEEP, SCALING};
+
+enum StrategyType {HEURISTIC, OPTIMAL, BANDIT, DISTILLED};
+
+// The name --strategy takes, and back. parse_strategy returns false for
+// unknown names.
+const char* strategy_name(const StrategyType strategy);
+bool parse_strategy(const std::string& name, StrategyType& strategy);
 
 /**
  * This class encapsulates everything that is configurable in this program.
@@ -26,6 +33,67 @@ class MatchemConfig
   SimulationType sim_type() const { return m_sim_type;}
   int num_runs() const { return m_num_runs; }
   bool verbose() const { return m_verbose; }
+  StrategyType strategy() const { return m_strategy; }
+  int solve_size() const { return m_solve_size; }
+  const std::string& policy_file() const { return m_policy_file; }
+  int bandit_rollouts() const { return m_bandit_rollouts; }
+  int bandit_candidates() const { return m_bandit_candidates; }
+  double bandit_exploration() const { return m_bandit_exploration; }
+  int bandit_threads() const { return m_bandit_threads; }
+  const std::string& book_file() const { return m_book_file; }
+  int book_depth() const { return m_book_depth; }
+  int decision_cache_mb() const { return m_decision_cache_mb; }
+  bool huge_pages() const { return m_huge_pages; }
+  int decision_tree_mb() const { return m_decision_tree_mb; }
+  const std::string& model_file() const { return m_model_file; }
+  const std::vector<int>& decision_budgets_us() const { return m_decision_budgets_us; }
+  const std::vector<int>& season_limits() const { return m_season_limits; }
+  const std::string& curves_file() const { return m_curves_file; }
+  const std::vector<int>& replay_games() const { return m_replay_games; }
+  const std::string& telemetry_file() const { return m_telemetry_file; }
+  double target_ci() const { return m_target_ci; }
+  int max_runs() const { return m_max_runs; }
+  const std::string& checkpoint_file() const { return m_checkpoint_file; }
+  const std::vector<StrategyType>& tournament_strategies() const { return m_tournament_strategies; }
+  int tune_candidates() const { return m_tune_candidates; }
+  const std::string& grid_file() const { return m_grid_file; }
+  const std::string& results_file() const { return m_results_file; }
+  int threads() const { return m_threads; }
+  int games_per_item() const { return m_games_per_item; }
+  const std::string& calibration_file() const { return m_calibration_file; }
+  const std::vector<std::string>& perf_counters() const { return m_perf_counters; }
+
+  // Optional settings, these have reasonable defaults
+  void set_num_runs(const int num_runs) { m_num_runs = num_runs; }
+  void set_strategy(const StrategyType strategy) { m_strategy = strategy; }
+  void set_solve_size(const int solve_size) { m_solve_size = solve_size; }
+  void set_policy_file(const std::string& policy_file) { m_policy_file = policy_file; }
+  void set_bandit_rollouts(const int bandit_rollouts) { m_bandit_rollouts = bandit_rollouts; }
+  void set_bandit_candidates(const int bandit_candidates) { m_bandit_candidates = bandit_candidates; }
+  void set_bandit_exploration(const double bandit_exploration) { m_bandit_exploration = bandit_exploration; }
+  void set_bandit_threads(const int bandit_threads) { m_bandit_threads = bandit_threads; }
+  void set_book_file(const std::string& book_file) { m_book_file = book_file; }
+  void set_book_depth(const int book_depth) { m_book_depth = book_depth; }
+  void set_decision_cache_mb(const int decision_cache_mb) { m_decision_cache_mb = decision_cache_mb; }
+  void set_huge_pages(const bool huge_pages) { m_huge_pages = huge_pages; }
+  void set_decision_tree_mb(const int decision_tree_mb) { m_decision_tree_mb = decision_tree_mb; }
+  void set_model_file(const std::string& model_file) { m_model_file = model_file; }
+  void set_decision_budgets_us(const std::vector<int>& decision_budgets_us) { m_decision_budgets_us = decision_budgets_us; }
+  void set_season_limits(const std::vector<int>& season_limits) { m_season_limits = season_limits; }
+  void set_curves_file(const std::string& curves_file) { m_curves_file = curves_file; }
+  void set_replay_games(const std::vector<int>& replay_games) { m_replay_games = replay_games; }
+  void set_telemetry_file(const std::string& telemetry_file) { m_telemetry_file = telemetry_file; }
+  void set_target_ci(const double target_ci) { m_target_ci = target_ci; }
+  void set_max_runs(const int max_runs) { m_max_runs = max_runs; }
+  void set_checkpoint_file(const std::string& checkpoint_file) { m_checkpoint_file = checkpoint_file; }
+  void set_tournament_strategies(const std::vector<StrategyType>& tournament_strategies) { m_tournament_strategies = tournament_strategies; }
+  void set_tune_candidates(const int tune_candidates) { m_tune_candidates = tune_candidates; }
+  void set_grid_file(const std::string& grid_file) { m_grid_file = grid_file; }
+  void set_results_file(const std::string& results_file) { m_results_file = results_file; }
+  void set_threads(const int threads) { m_threads = threads; }
+  void set_games_per_item(const int games_per_item) { m_games_per_item = games_per_item; }
+  void set_calibration_file(const std::string& calibration_file) { m_calibration_file = calibration_file; }
+  void set_perf_counters(const std::vector<std::string>& perf_counters) { m_perf_counters = perf_counters; }
 
   /**
    * operator<< - produces a nice-looking output that should convey the configuration
@@ -40,6 +108,35 @@ class MatchemConfig
   SimulationType m_sim_type;
   int m_num_runs;
   bool m_verbose;
+  StrategyType m_strategy;
+  int m_solve_size;
+  std::string m_policy_file;
+  int m_bandit_rollouts;
+  int m_bandit_candidates;
+  double m_bandit_exploration;
+  int m_bandit_threads;
+  std::string m_book_file;
+  int m_book_depth;
+  int m_decision_cache_mb;
+  bool m_huge_pages;
+  int m_decision_tree_mb;
+  std::string m_model_file;
+  std::vector<int> m_decision_budgets_us;
+  std::vector<int> m_season_limits;
+  std::string m_curves_file;
+  std::vector<int> m_replay_games;
+  std::string m_telemetry_file;
+  double m_target_ci;
+  int m_max_runs;
+  std::string m_checkpoint_file;
+  std::vector<StrategyType> m_tournament_strategies;
+  int m_tune_candidates;
+  std::string m_grid_file;
+  std::string m_results_file;
+  int m_threads;
+  int m_games_per_item;
+  std::string m_calibration_file;
+  std::vector<std::string> m_perf_counters;
 };
 
 std::ostream& operator<<(std::ostream& out, const MatchemConfig& config);
@@ -1,16 +1,42 @@
 #include "matchem_facade.hpp"
 #include "matchem_config.hpp"
 #include "matchem.hpp"
+#include "matchem_perf.hpp"
+#include "matchem_scaling.hpp"
+#include "matchem_solver.hpp"
+#include "matchem_sweep.hpp"
+#include "matchem_tournament.hpp"
+#include "matchem_tuner.hpp"
 
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
+#include <sstream>
 
 namespace matchem {
 
 const std::string MatchemFacade::HELP =
-  "matchem --mode=(basic|||) \n"
+  "matchem --mode=(basic|solve|build-book|exact|distill|tournament|tune|sweep|scaling) \n"
   "   First step: you must pick your mode. \n"
+  "     basic: simulate many games and report the average number of rounds \n"
+  "     solve: compute the optimal strategy for a small set size \n"
+  "     build-book: record the first rounds of decisions of a strategy \n"
+  "     exact: play every possible hidden state once and report the exact \n"
+  "            expected number of rounds and their distribution. That is \n"
+  "            set size! games, 3628800 for 10 couples; use a decision \n"
+  "            tree so they share decisions, and a checkpoint file. \n"
+  "            --exhaustive is the same as --mode=exact. \n"
+  "     distill: train the distilled strategy to imitate another strategy \n"
+  "              and compare the two \n"
+  "     tournament: play the same games with several strategies and report \n"
+  "                 how they compare game by game \n"
+  "     tune: search the bandit settings for the fewest rounds and report the \n"
+  "           best one and the quality versus cost frontier \n"
+  "     sweep: play every configuration of a grid file in one process and \n"
+  "            report them in one table \n"
+  "     scaling: play the same --num-runs games on 1, 2, 4, ... threads, up \n"
+  "              to --kokkos-threads, and report strong and weak scaling \n"
+  "              and what limits it \n"
   "\n"
   "<config-options> \n"
   "   These options can be used for any of the modes, however the vast majority \n"
@@ -22,11 +48,161 @@ const std::string MatchemFacade::HELP =
   "       a pseudo-random seed.\n"
   "   --num-runs=<number of simulations to run> \n"
   "       How many simulations to run, default is 1000 \n"
+  "   --target-ci=<rounds> \n"
+  "       Instead of a fixed number of runs, play batches of games until the \n"
+  "       95% confidence interval of the average is this tight (+/-) \n"
+  "   --max-runs=<number of simulations> \n"
+  "       Most games --target-ci will play, default is 1000000 \n"
+  "   --checkpoint-file=<filename> \n"
+  "       Exact mode saves its progress here as it goes and, if the file \n"
+  "       exists, resumes from it \n"
+  "   --strategy=(heuristic|optimal|bandit|distilled) \n"
+  "       How to pick truth queries and guesses, default is heuristic. The \n"
+  "       optimal strategy needs a policy file written by solve mode for the \n"
+  "       compiled set size, so it only runs in builds with a set size of \n"
+  "       at most 7. bandit picks between the best few heuristic \n"
+  "       options with a UCB1 bandit whose pulls play out random games. \n"
+  "       distilled scores pairs with a small linear model trained by \n"
+  "       distill mode. In distill mode this is the strategy to imitate. \n"
+  "   --strategies=<strategy>,<strategy>[,<strategy>...] \n"
+  "       Strategies tournament mode compares, 2 to 16 of them, default is \n"
+  "       heuristic,bandit. --target-ci applies to their differences. \n"
+  "   --policy-file=<filename> \n"
+  "       Where solve mode writes the optimal policy and where the optimal \n"
+  "       strategy reads it from \n"
+  "   --solve-size=<set size> \n"
+  "       Set size for solve mode, must be <= 7, default is 5. Sizes above \n"
+  "       5 take a very long time. \n"
+  "   --bandit-rollouts=<number of rollouts> \n"
+  "       How many games the bandit plays out per decision, default is 64 \n"
+  "   --bandit-candidates=<number of options> \n"
+  "       How many options the bandit compares per decision, must be <= 16, \n"
+  "       default is 8 \n"
+  "   --bandit-exploration=<rounds> \n"
+  "       How much the bandit favors options it has tried less, default is 2 \n"
+  "   --bandit-threads=<number of threads> \n"
+  "       How many threads play each game. The rollouts of a decision are \n"
+  "       split between them, so a decision budget fits more of them. Must \n"
+  "       divide the number of Kokkos threads, default is 1. Strategies other \n"
+  "       than bandit gain nothing from it. \n"
+  "   --tune-candidates=<number of settings> \n"
+  "       How many bandit settings tune mode tries, the current one included, \n"
+  "       must be <= 16, default is 16. Each plays --num-runs games in the \n"
+  "       first round of elimination, survivors play twice as many in each \n"
+  "       round after that. \n"
+  "   --grid-file=<filename> \n"
+  "       The configurations sweep mode plays. One line per setting, \n"
+  "       'name = value, value, ...', every combination is played. Names \n"
+  "       are set-size, tracking (full|lean), strategy, num-runs, \n"
+  "       bandit-rollouts and bandit-candidates; others come from the command \n"
+  "       line. Set sizes and tracking this build was not compiled for \n"
+  "       are listed but not played. \n"
+  "   --results-file=<filename> \n"
+  "       Also write the sweep table to this file as CSV \n"
+  "   --threads=<number of threads> \n"
+  "       Play games on at most this many of the threads Kokkos started \n"
+  "       with (--kokkos-threads), default is all of them \n"
+  "   --games-per-item=<number of games> \n"
+  "       How many games a thread takes at a time, default is 1 \n"
+  "   --calibration-file=<filename> \n"
+  "       Unless --threads or --games-per-item is given, pick both by timing \n"
+  "       a few of each on short probe games, and keep the pick in this file \n"
+  "       for later runs on the same host with the same settings. For basic, \n"
+  "       exact and sweep mode. \n"
+  "   --perf-counters[=<event>[,<event>...]] \n"
+  "       Count hardware events around the games with Linux perf_event_open \n"
+  "       and report them per game and per round, for each thread and in \n"
+  "       total. Events are cycles, instructions, cache-references, \n"
+  "       cache-misses, branches, branch-misses, l1d-misses, llc-misses, \n"
+  "       task-clock (ns, also without hardware counters) and raw:<hex code> \n"
+  "       for CPU specific ones (vector instructions), at most 8. Default is \n"
+  "       cycles,instructions,cache-misses,branch-misses. \n"
+  "       Events that can not be counted are left out. \n"
+  "   --book-file=<filename> \n"
+  "       Where build-book mode writes the opening book and where basic mode \n"
+  "       reads it from. The book must be built with the same strategy. \n"
+  "   --book-depth=<number of rounds> \n"
+  "       How many rounds build-book mode covers, default is 3 \n"
+  "   --decision-cache=<megabytes> \n"
+  "       Share bandit decisions between games through a cache of this size. \n"
+  "       Situations that only differ by relabeling share entries. Default \n"
+  "       is 0, no cache. \n"
+  "   --huge-pages \n"
+  "       Ask the OS to back the decision cache with huge pages \n"
+  "   --decision-tree=<megabytes> \n"
+  "       Build the decision tree of a deterministic strategy as games are \n"
+  "       played, so games that see the same answers reuse its decisions \n"
+  "       instead of recomputing them. Makes exact mode practical. Default \n"
+  "       is 0, no tree. \n"
+  "   --model-file=<filename> \n"
+  "       Where distill mode writes the trained model and where the \n"
+  "       distilled strategy reads it from \n"
+  "   --decision-budget=<microseconds>[,<microseconds>...] \n"
+  "       Stop the bandit strategy, the only one that refines its answer, \n"
+  "       once a decision has taken this long, 0 means no limit. With \n"
+  "       several budgets the same games are played once per budget and \n"
+  "       each is compared game by game to the first. Default is no limit. \n"
+  "   --season-limit=<rounds>[,<rounds>...] \n"
+  "       Also report the chance a game is won within this many rounds, \n"
+  "       default is 10, the number of ceremonies in a real season \n"
+  "   --curves-file=<filename> \n"
+  "       Write a CSV with one line per round: how many games got that far \n"
+  "       and, averaged over those, the correct matches in the ceremony, \n"
+  "       the known matches, the entropy (bits) of the hidden state and the \n"
+  "       marginal entropy (bits) of the odds, summed over side1s. The \n"
+  "       entropy counts the hidden states that fit the truth queries, \n"
+  "       ceremony scores do not narrow it yet. \n"
+  "   --replay=<game>[,<game>...] \n"
+  "       Play these games instead of random ones. A game is the id of its \n"
+  "       hidden state, as listed with the slowest games of a run. \n"
+  "   --telemetry-file=<filename> \n"
+  "       Also write the telemetry counters printed after a run (builds \n"
+  "       configured with -DTELEMETRY=ON only) to this file as JSON \n"
   "\n"
   "\n"
   "EXAMPLES: \n"
   "  Run test1 \n"
-  "  % ./matchem --mode=basic \n";
+  "  % ./matchem --mode=basic \n"
+  "  Find the optimal strategy for 5 couples and save it \n"
+  "  % ./matchem --mode=solve --solve-size=5 --policy-file=opt5.txt \n"
+  "  Try bandit with a bigger rollout budget \n"
+  "  % ./matchem --mode=basic --strategy=bandit --bandit-rollouts=256 \n"
+  "  Precompute the opening of bandit once with a big budget, then reuse it \n"
+  "  % ./matchem --mode=build-book --strategy=bandit --bandit-rollouts=4096 --book-file=bandit.book \n"
+  "  % ./matchem --mode=basic --strategy=bandit --book-file=bandit.book \n"
+  "  Exact expected rounds of the heuristic strategy \n"
+  "  % ./matchem --mode=exact --decision-tree=512 \n"
+  "  Same, in a way that can be interrupted and picked up again \n"
+  "  % ./matchem --exhaustive --decision-tree=512 --checkpoint-file=exact.ckpt \n"
+  "  Distill bandit into a cheap model, then use it \n"
+  "  % ./matchem --mode=distill --strategy=bandit --num-runs=200 --model-file=bandit.model \n"
+  "  % ./matchem --mode=basic --strategy=distilled --model-file=bandit.model \n"
+  "  Compare bandit at several time limits per decision \n"
+  "  % ./matchem --mode=basic --strategy=bandit --decision-budget=100,1000,0 \n"
+  "  Chance of winning within a 10 or a 12 episode season \n"
+  "  % ./matchem --mode=basic --season-limit=10,12 \n"
+  "  See where bandit pulls ahead of the heuristic \n"
+  "  % ./matchem --mode=basic --curves-file=heuristic.csv \n"
+  "  % ./matchem --mode=basic --strategy=bandit --curves-file=bandit.csv \n"
+  "  Watch one of the slowest games of a run again \n"
+  "  % ./matchem --mode=basic --replay=1234567 --verbose \n"
+  "  Average rounds to within +/- 0.05 \n"
+  "  % ./matchem --mode=basic --target-ci=0.05 \n"
+  "  Tell bandit and the heuristic apart to within +/- 0.05 rounds \n"
+  "  % ./matchem --mode=tournament --strategies=heuristic,bandit --target-ci=0.05 \n"
+  "  Find good bandit settings \n"
+  "  % ./matchem --mode=tune --num-runs=100 \n"
+  "  Play a grid of configurations and keep the table \n"
+  "  % ./matchem --mode=sweep --grid-file=grid.txt --results-file=sweep.csv \n"
+  "  Find where a 64 core box stops scaling \n"
+  "  % ./matchem --mode=scaling --num-runs=64000 --kokkos-threads=64 \n"
+  "  Let the first run find the fastest thread count for this box, later \n"
+  "  runs reuse it \n"
+  "  % ./matchem --mode=basic --num-runs=100000 --calibration-file=.matchem_calibration \n"
+  "  Instructions per cycle and cache misses per game of the heuristic \n"
+  "  % ./matchem --mode=basic --perf-counters=cycles,instructions,l1d-misses,llc-misses \n"
+  "  Save the work counters of a run to compare against another build \n"
+  "  % ./matchem --mode=basic --telemetry-file=heuristic.json \n";
 
 ////////////////////////////////////////////////////////////////////////////////
 const MatchemFacade& MatchemFacade::instance()
@@ -45,6 +221,35 @@ void MatchemFacade::play(int argc, char** argv) const
   auto           rand_seed = std::time(0);
   int            num_runs  = 1000;
   bool           verbose   = false;
+  StrategyType   strategy  = HEURISTIC;
+  int            solve_size = 5;
+  std::string    policy_file;
+  int            bandit_rollouts = 64;
+  int            bandit_candidates = 8;
+  double         bandit_exploration = 2.0;
+  int            bandit_threads = 1;
+  std::string    book_file;
+  int            book_depth = 3;
+  int            decision_cache_mb = 0;
+  bool           huge_pages = false;
+  int            decision_tree_mb = 0;
+  std::string    model_file;
+  std::vector<int> decision_budgets_us;
+  std::vector<int> season_limits(1, 10);
+  std::string    curves_file;
+  std::vector<int> replay_games;
+  std::string    telemetry_file;
+  double         target_ci = 0.0;
+  int            max_runs = 1000000;
+  std::string    checkpoint_file;
+  std::vector<StrategyType> tournament_strategies = {HEURISTIC, BANDIT};
+  int            tune_candidates = 16;
+  std::string    grid_file;
+  std::string    results_file;
+  int            threads = 0;
+  int            games_per_item = 0;
+  std::string    calibration_file;
+  std::vector<std::string> perf_counters;
 
   //do the options parsing:
   if (argc == 1) {
@@ -76,20 +281,176 @@ void MatchemFacade::play(int argc, char** argv) const
       if (arg == "basic") {
         sim_type = BASIC;
       }
+      else if (arg == "solve") {
+        sim_type = SOLVE;
+      }
+      else if (arg == "build-book") {
+        sim_type = BUILD_BOOK;
+      }
+      else if (arg == "exact") {
+        sim_type = EXACT;
+      }
+      else if (arg == "distill") {
+        sim_type = DISTILL;
+      }
+      else if (arg == "tournament") {
+        sim_type = TOURNAMENT;
+      }
+      else if (arg == "tune") {
+        sim_type = TUNE;
+      }
+      else if (arg == "sweep") {
+        sim_type = SWEEP;
+      }
+      else if (arg == "scaling") {
+        sim_type = SCALING;
+      }
       else {
         std::cerr << "Unknown sim mode: " << arg << std::endl;
         return;
       }
     }
+    else if (opt == "--exhaustive") {
+      sim_type = EXACT;
+    }
+    else if (opt == "--checkpoint-file") {
+      checkpoint_file = arg;
+    }
     else if (opt == "--srand") {
       rand_seed = std::atoi(arg.c_str());
     }
     else if (opt == "--num-runs") {
       num_runs = std::atoi(arg.c_str());
     }
+    else if (opt == "--target-ci") {
+      target_ci = std::atof(arg.c_str());
+    }
+    else if (opt == "--max-runs") {
+      max_runs = std::atoi(arg.c_str());
+    }
     else if (opt == "--verbose") {
       verbose = true;
     }
+    else if (opt == "--strategy") {
+      if (!parse_strategy(arg, strategy)) {
+        std::cerr << "Unknown strategy: " << arg << std::endl;
+        return;
+      }
+    }
+    else if (opt == "--strategies") {
+      tournament_strategies.clear();
+      std::istringstream names(arg);
+      std::string name;
+      while (std::getline(names, name, ',')) {
+        StrategyType tournament_strategy;
+        if (!parse_strategy(name, tournament_strategy)) {
+          std::cerr << "Unknown strategy: " << name << std::endl;
+          return;
+        }
+        tournament_strategies.push_back(tournament_strategy);
+      }
+    }
+    else if (opt == "--policy-file") {
+      policy_file = arg;
+    }
+    else if (opt == "--solve-size") {
+      solve_size = std::atoi(arg.c_str());
+    }
+    else if (opt == "--bandit-rollouts") {
+      bandit_rollouts = std::atoi(arg.c_str());
+    }
+    else if (opt == "--bandit-candidates") {
+      bandit_candidates = std::atoi(arg.c_str());
+    }
+    else if (opt == "--bandit-exploration") {
+      bandit_exploration = std::atof(arg.c_str());
+    }
+    else if (opt == "--bandit-threads") {
+      bandit_threads = std::atoi(arg.c_str());
+    }
+    else if (opt == "--tune-candidates") {
+      tune_candidates = std::atoi(arg.c_str());
+    }
+    else if (opt == "--grid-file") {
+      grid_file = arg;
+    }
+    else if (opt == "--results-file") {
+      results_file = arg;
+    }
+    else if (opt == "--threads") {
+      threads = std::atoi(arg.c_str());
+    }
+    else if (opt == "--games-per-item") {
+      games_per_item = std::atoi(arg.c_str());
+    }
+    else if (opt == "--calibration-file") {
+      calibration_file = arg;
+    }
+    else if (opt == "--perf-counters") {
+      perf_counters.clear();
+      std::istringstream events(arg.empty() ? "default" : arg);
+      std::string event;
+      while (std::getline(events, event, ',')) {
+        PerfCounters::Event perf_event;
+        if (event == "default") {
+          const std::vector<std::string> defaults = PerfCounters::default_events();
+          perf_counters.insert(perf_counters.end(), defaults.begin(), defaults.end());
+        }
+        else if (PerfCounters::find_event(event, perf_event)) {
+          perf_counters.push_back(event);
+        }
+        else {
+          std::cerr << "Unknown perf counter: " << event << std::endl;
+          return;
+        }
+      }
+    }
+    else if (opt == "--book-file") {
+      book_file = arg;
+    }
+    else if (opt == "--book-depth") {
+      book_depth = std::atoi(arg.c_str());
+    }
+    else if (opt == "--decision-cache") {
+      decision_cache_mb = std::atoi(arg.c_str());
+    }
+    else if (opt == "--huge-pages") {
+      huge_pages = true;
+    }
+    else if (opt == "--decision-tree") {
+      decision_tree_mb = std::atoi(arg.c_str());
+    }
+    else if (opt == "--model-file") {
+      model_file = arg;
+    }
+    else if (opt == "--decision-budget") {
+      std::istringstream budgets(arg);
+      std::string budget;
+      while (std::getline(budgets, budget, ',')) {
+        decision_budgets_us.push_back(std::atoi(budget.c_str()));
+      }
+    }
+    else if (opt == "--curves-file") {
+      curves_file = arg;
+    }
+    else if (opt == "--telemetry-file") {
+      telemetry_file = arg;
+    }
+    else if (opt == "--replay") {
+      std::istringstream games(arg);
+      std::string game;
+      while (std::getline(games, game, ',')) {
+        replay_games.push_back(std::atoi(game.c_str()));
+      }
+    }
+    else if (opt == "--season-limit") {
+      season_limits.clear();
+      std::istringstream limits(arg);
+      std::string limit;
+      while (std::getline(limits, limit, ',')) {
+        season_limits.push_back(std::atoi(limit.c_str()));
+      }
+    }
     else {
       std::cerr << "Unknown option: " << opt << std::endl;
       return;
@@ -99,13 +460,72 @@ void MatchemFacade::play(int argc, char** argv) const
   srand(rand_seed);
 
   MatchemConfig config(sim_type, num_runs, verbose);
+  config.set_strategy(strategy);
+  config.set_solve_size(solve_size);
+  config.set_policy_file(policy_file);
+  config.set_bandit_rollouts(bandit_rollouts);
+  config.set_bandit_candidates(bandit_candidates);
+  config.set_bandit_exploration(bandit_exploration);
+  config.set_bandit_threads(bandit_threads);
+  config.set_book_file(book_file);
+  config.set_book_depth(book_depth);
+  config.set_decision_cache_mb(decision_cache_mb);
+  config.set_huge_pages(huge_pages);
+  config.set_decision_tree_mb(decision_tree_mb);
+  config.set_model_file(model_file);
+  config.set_decision_budgets_us(decision_budgets_us);
+  config.set_season_limits(season_limits);
+  config.set_curves_file(curves_file);
+  config.set_replay_games(replay_games);
+  config.set_telemetry_file(telemetry_file);
+  config.set_target_ci(target_ci);
+  config.set_max_runs(max_runs);
+  config.set_checkpoint_file(checkpoint_file);
+  config.set_tournament_strategies(tournament_strategies);
+  config.set_tune_candidates(tune_candidates);
+  config.set_grid_file(grid_file);
+  config.set_results_file(results_file);
+  config.set_threads(threads);
+  config.set_games_per_item(games_per_item);
+  config.set_calibration_file(calibration_file);
+  config.set_perf_counters(perf_counters);
 
   std::cout << "Running simulation with config: " << std::endl;
   std::cout << config << std::endl;
   std::cout << "With random seed: " << rand_seed << std::endl;
 
-  Matchem matchem(config);
-  matchem.run();
+  if (sim_type == SOLVE) {
+    MatchemSolver solver(config);
+    solver.run();
+  }
+  else if (sim_type == BUILD_BOOK) {
+    Matchem matchem(config);
+    matchem.build_book();
+  }
+  else if (sim_type == DISTILL) {
+    Matchem matchem(config);
+    matchem.distill();
+  }
+  else if (sim_type == TOURNAMENT) {
+    MatchemTournament tournament(config);
+    tournament.run();
+  }
+  else if (sim_type == TUNE) {
+    MatchemTuner tuner(config);
+    tuner.run();
+  }
+  else if (sim_type == SWEEP) {
+    MatchemSweep sweep(config);
+    sweep.run();
+  }
+  else if (sim_type == SCALING) {
+    MatchemScaling scaling(config);
+    scaling.run();
+  }
+  else {
+    Matchem matchem(config);
+    matchem.run();
+  }
 }
 
 }
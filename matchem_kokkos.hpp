@@ -16,9 +16,9 @@ struct ExeSpaceUtils
 {
   using TeamPolicy = Kokkos::TeamPolicy<ExeSpace>;
 
-  static TeamPolicy get_default_team_policy (int ni)
+  static TeamPolicy get_default_team_policy (int ni, int team_size = 1)
   {
-    return TeamPolicy(ni, 1); // one thread per-team for now
+    return TeamPolicy(ni, team_size); // one thread per-team unless asked
   }
 };
 
@@ -0,0 +1,169 @@
+#include "matchem_model.hpp"
+#include "matchem_exception.hpp"
+
+#include <fstream>
+
+namespace matchem {
+
+////////////////////////////////////////////////////////////////////////////////
+LinearModel::LinearModel() :
+////////////////////////////////////////////////////////////////////////////////
+  m_size(0)
+{
+  // Start from "pick the most likely pair", feature 0 is the odds
+  for (int h = 0; h < NUM_HEADS; ++h) {
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      m_weights[h][f] = f == 0 ? 1.0f : 0.0f;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LinearModel::load(const std::string& filename, const int expected_size)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ifstream in(filename);
+  my_require(in.good(), "Could not open model file: " + filename);
+
+  std::string tag, features_tag;
+  int size = 0, num_features = 0;
+  in >> tag >> size >> features_tag >> num_features;
+  my_require(tag == "size" && size == expected_size,
+             "Model file " + filename + " is for set size " + obj_to_str(size) +
+             ", expected " + obj_to_str(expected_size));
+  my_require(features_tag == "features" && num_features == NUM_FEATURES,
+             "Model file " + filename + " has " + obj_to_str(num_features) + " features, expected " +
+             obj_to_str(static_cast<int>(NUM_FEATURES)));
+
+  m_size = size;
+  for (const char* head : {"query", "guess"}) {
+    in >> tag;
+    my_require(tag == head, "Bad entry '" + tag + "' in model file: " + filename);
+    float* weights = m_weights[tag == "query" ? QUERY_HEAD : GUESS_HEAD];
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      in >> weights[f];
+    }
+    my_require(!in.fail(), "Truncated model file: " + filename);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LinearModel::save(const std::string& filename) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ofstream out(filename);
+  my_require(out.good(), "Could not write model file: " + filename);
+
+  out.precision(9);
+  out << "size " << m_size << " features " << NUM_FEATURES << "\n";
+  for (int h = 0; h < NUM_HEADS; ++h) {
+    out << (h == QUERY_HEAD ? "query" : "guess");
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      out << " " << m_weights[h][f];
+    }
+    out << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LinearModel::train(const std::vector<Sample>& samples, const int num_epochs, const double learning_rate)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int num_cells = m_size*m_size;
+  std::vector<float> features(NUM_FEATURES*num_cells);
+  auto feature = [&](const int f, const int c) { return features[f*num_cells + c]; };
+
+  // The softmax groups of a sample, see Sample
+  std::vector<int> cells;
+  auto get_group = [&](const Sample& sample, const int g) {
+    cells.clear();
+    if (sample.head == QUERY_HEAD) {
+      for (int c = 0; c < num_cells; ++c) {
+        if (sample.cells[c] == OPEN_CELL) {
+          cells.push_back(c);
+        }
+      }
+    }
+    else {
+      const int i = sample.labels[g] / m_size;
+      for (int j = 0; j < m_size; ++j) {
+        cells.push_back(i*m_size + j);
+      }
+    }
+  };
+
+  for (const Sample& sample : samples) {
+    my_require(static_cast<int>(sample.odds.size()) == num_cells && static_cast<int>(sample.cells.size()) == num_cells,
+               "Sample is not for set size " + obj_to_str(m_size));
+  }
+
+  for (int h = 0; h < NUM_HEADS; ++h) {
+    int num_groups = 0;
+    for (const Sample& sample : samples) {
+      if (sample.head == h) {
+        num_groups += sample.labels.size();
+      }
+    }
+    if (num_groups == 0) {
+      continue;
+    }
+
+    double weights[NUM_FEATURES];
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      weights[f] = m_weights[h][f];
+    }
+
+    std::vector<double> probs;
+    for (int epoch = 0; epoch < num_epochs; ++epoch) {
+      // The loss is convex, full-batch steps are slow but can not go astray
+      double grad[NUM_FEATURES] = {0};
+      for (const Sample& sample : samples) {
+        if (sample.head != h) {
+          continue;
+        }
+        get_features(m_size, sample.odds.data(), sample.cells.data(), features.data());
+
+        for (size_t g = 0; g < sample.labels.size(); ++g) {
+          get_group(sample, g);
+          probs.resize(cells.size());
+
+          double max_logit = -std::numeric_limits<double>::infinity();
+          for (size_t k = 0; k < cells.size(); ++k) {
+            double logit = 0.0;
+            for (int f = 0; f < NUM_FEATURES; ++f) {
+              logit += weights[f] * feature(f, cells[k]);
+            }
+            probs[k] = logit;
+            max_logit = std::max(max_logit, logit);
+          }
+          double total = 0.0;
+          for (double& p : probs) {
+            p = std::exp(p - max_logit);
+            total += p;
+          }
+
+          // d(-log p_label)/dw = E_p[x] - x_label
+          for (size_t k = 0; k < cells.size(); ++k) {
+            const double p = probs[k] / total;
+            for (int f = 0; f < NUM_FEATURES; ++f) {
+              grad[f] += p * feature(f, cells[k]);
+            }
+          }
+          for (int f = 0; f < NUM_FEATURES; ++f) {
+            grad[f] -= feature(f, sample.labels[g]);
+          }
+        }
+      }
+
+      for (int f = 0; f < NUM_FEATURES; ++f) {
+        weights[f] -= learning_rate * grad[f] / num_groups;
+      }
+    }
+
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      m_weights[h][f] = static_cast<float>(weights[f]);
+    }
+  }
+}
+
+}
@@ -0,0 +1,154 @@
+#ifndef MATCHEM_MODEL_HPP
+#define MATCHEM_MODEL_HPP
+
+#include "matchem_common.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace matchem {
+
+/**
+ * A linear scoring model distilled from an expensive strategy. Every pair
+ * (side1, side2) gets a small feature vector; the model scores it with one
+ * dot product per head, one head for truth queries and one for guesses.
+ *
+ * Features are stored feature-major (all cells of feature 0, then all cells
+ * of feature 1, ...) so scoring a whole board is NUM_FEATURES passes of a
+ * multiply-add over contiguous cells, which the compiler vectorizes. They are
+ * all computed from the board: the odds of every cell and what is known of
+ * it.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class LinearModel
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  enum Head {
+    QUERY_HEAD,
+    GUESS_HEAD,
+    NUM_HEADS
+  };
+
+  static constexpr int NUM_FEATURES = 7;
+
+  // Biggest board get_features takes
+  static constexpr int MAX_SIZE = 16;
+
+  // What is known of a cell
+  enum Cell : uint8_t {
+    OPEN_CELL,
+    MATCH_CELL,
+    NO_MATCH_CELL
+  };
+
+  // One decision of the teacher: the board it saw and its picks. Features are
+  // computed from the board when training, so a sample is a few hundred bytes
+  // instead of NUM_FEATURES floats per cell.
+  struct Sample
+  {
+    Head head;
+    std::vector<float> odds;    // odds[i*size + j] of side1 i and side2 j
+    std::vector<uint8_t> cells; // a Cell per cell
+    // The teacher's pick in each softmax group. A query is one group over the
+    // open cells, a guess is one group per side1 without a known match, over
+    // its row, in side1 order.
+    std::vector<int> labels;
+  };
+
+  LinearModel();
+
+  /**
+   * load - Read a model written by save. Throws a MatchemException if the file
+   *        cannot be read or is not for a set of the expected size.
+   */
+  void load(const std::string& filename, const int expected_size);
+
+  /**
+   * save - Write the model to a text file
+   */
+  void save(const std::string& filename) const;
+
+  void set_size(const int size) { m_size = size; }
+
+  /**
+   * train - Fit both heads to the teacher's choices by minimizing softmax
+   *         cross entropy with plain gradient descent
+   */
+  void train(const std::vector<Sample>& samples, const int num_epochs, const double learning_rate);
+
+  /**
+   * get_features - features[f*size*size + c] = feature f of cell c of a size
+   *                x size board:
+   *                0: odds, 1: odds squared, 2: odds over the best of its row,
+   *                3: odds over the best of its column, 4: known match,
+   *                5: known miss, 6: 1 over the pairs its row can still have
+   */
+  KOKKOS_INLINE_FUNCTION
+  static void get_features(const int size, const float* odds, const uint8_t* cells, float* features)
+  {
+    assert(size <= MAX_SIZE);
+    const int num_cells = size*size;
+    float row_max[MAX_SIZE], col_max[MAX_SIZE];
+    int row_pot[MAX_SIZE];
+    for (int k = 0; k < size; ++k) {
+      row_max[k] = 0.0f;
+      col_max[k] = 0.0f;
+      row_pot[k] = 0;
+    }
+    for (int c = 0; c < num_cells; ++c) {
+      const int i = c / size, j = c % size;
+      row_max[i] = odds[c] > row_max[i] ? odds[c] : row_max[i];
+      col_max[j] = odds[c] > col_max[j] ? odds[c] : col_max[j];
+      row_pot[i] += cells[c] != NO_MATCH_CELL ? 1 : 0;
+    }
+
+    for (int c = 0; c < num_cells; ++c) {
+      const int i = c / size, j = c % size;
+      features[0*num_cells + c] = odds[c];
+      features[1*num_cells + c] = odds[c]*odds[c];
+      features[2*num_cells + c] = row_max[i] > 0.0f ? odds[c] / row_max[i] : 0.0f;
+      features[3*num_cells + c] = col_max[j] > 0.0f ? odds[c] / col_max[j] : 0.0f;
+      features[4*num_cells + c] = cells[c] == MATCH_CELL ? 1.0f : 0.0f;
+      features[5*num_cells + c] = cells[c] == NO_MATCH_CELL ? 1.0f : 0.0f;
+      features[6*num_cells + c] = 1.0f / row_pot[i];
+    }
+  }
+
+  /**
+   * score - scores[c] = the head's weights dotted with the features of cell c
+   */
+  KOKKOS_INLINE_FUNCTION
+  void score(const Head head, const float* features, const int num_cells, float* scores) const
+  {
+    const float* weights = m_weights[head];
+    MATCHEM_IVDEP
+    for (int c = 0; c < num_cells; ++c) {
+      scores[c] = 0.0f;
+    }
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      const float w = weights[f];
+      const float* feature = features + f*num_cells;
+      MATCHEM_IVDEP
+      for (int c = 0; c < num_cells; ++c) {
+        scores[c] += w * feature[c];
+      }
+    }
+  }
+
+  const float* weights(const Head head) const { return m_weights[head]; }
+
+  int size() const { return m_size; }
+
+ private:
+
+  int m_size;
+  float m_weights[NUM_HEADS][NUM_FEATURES];
+};
+
+}
+
+#endif
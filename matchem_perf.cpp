@@ -0,0 +1,370 @@
+#include "matchem_perf.hpp"
+#include "matchem_exception.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace matchem {
+
+constexpr int PerfCounters::MAX_EVENTS;
+
+namespace {
+
+// perf_event_attr types and configs, these are the Linux ABI
+constexpr uint32_t TYPE_HARDWARE = 0;
+constexpr uint32_t TYPE_SOFTWARE = 1;
+constexpr uint32_t TYPE_HW_CACHE = 3;
+constexpr uint32_t TYPE_RAW      = 4;
+
+constexpr uint64_t HW_CACHE_L1D = 0;
+constexpr uint64_t HW_CACHE_LL  = 2;
+
+// Read misses of a cache
+constexpr uint64_t cache_read_misses(const uint64_t cache)
+{
+  return cache | (0 << 8) | (1 << 16);
+}
+
+const PerfCounters::Event EVENTS[] = {
+  {"cycles",           TYPE_HARDWARE, 0},
+  {"instructions",     TYPE_HARDWARE, 1},
+  {"cache-references", TYPE_HARDWARE, 2},
+  {"cache-misses",     TYPE_HARDWARE, 3},
+  {"branches",         TYPE_HARDWARE, 4},
+  {"branch-misses",    TYPE_HARDWARE, 5},
+  {"l1d-misses",       TYPE_HW_CACHE, cache_read_misses(HW_CACHE_L1D)},
+  {"llc-misses",       TYPE_HW_CACHE, cache_read_misses(HW_CACHE_LL)},
+  {"task-clock",       TYPE_SOFTWARE, 1} // ns, counted by the kernel without a PMU
+};
+
+const std::string RAW_PREFIX = "raw:";
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool PerfCounters::find_event(const std::string& name, Event& event)
+////////////////////////////////////////////////////////////////////////////////
+{
+  for (const Event& known : EVENTS) {
+    if (known.name == name) {
+      event = known;
+      return true;
+    }
+  }
+
+  if (name.compare(0, RAW_PREFIX.size(), RAW_PREFIX) == 0) {
+    std::string code = name.substr(RAW_PREFIX.size());
+    if (code.compare(0, 2, "0x") == 0) {
+      code = code.substr(2);
+    }
+    if (code.empty() || code.size() > 16 || code.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+      return false;
+    }
+    event = Event{name, TYPE_RAW, std::stoull(code, nullptr, 16)};
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> PerfCounters::default_events()
+////////////////////////////////////////////////////////////////////////////////
+{
+  return {"cycles", "instructions", "cache-misses", "branch-misses"};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+PerfCounters::PerfCounters(const std::vector<std::string>& events, const int num_threads) :
+////////////////////////////////////////////////////////////////////////////////
+  m_events(),
+  m_threads(num_threads)
+{
+  my_require(!events.empty() && events.size() <= MAX_EVENTS,
+             "Can count 1 to " + obj_to_str(MAX_EVENTS) + " perf counters");
+  for (const std::string& name : events) {
+    Event event;
+    my_require(find_event(name, event), "Unknown perf counter: " + name);
+    my_require(find(name) == -1, "Perf counter listed twice: " + name);
+    m_events.push_back(event);
+  }
+
+  for (Thread& thread : m_threads) {
+    std::fill(thread.fds, thread.fds + MAX_EVENTS, -1);
+  }
+  reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+PerfCounters::~PerfCounters()
+////////////////////////////////////////////////////////////////////////////////
+{
+#ifdef __linux__
+  for (Thread& thread : m_threads) {
+    for (int e = 0; e < MAX_EVENTS; ++e) {
+      if (thread.fds[e] != -1) {
+        close(thread.fds[e]);
+      }
+    }
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int PerfCounters::find(const std::string& name) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  for (int e = 0; e < num_events(); ++e) {
+    if (m_events[e].name == name) {
+      return e;
+    }
+  }
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PerfCounters::reset()
+////////////////////////////////////////////////////////////////////////////////
+{
+  for (Thread& thread : m_threads) {
+    std::fill(thread.counts, thread.counts + MAX_EVENTS, 0);
+    std::fill(thread.counted, thread.counted + MAX_EVENTS, false);
+    thread.multiplexed = false;
+    thread.error = 0;
+    thread.games = 0;
+    thread.rounds = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PerfCounters::start(const int thread)
+////////////////////////////////////////////////////////////////////////////////
+{
+  Thread& my = m_threads[thread];
+
+#ifdef __linux__
+  // The first counter that opens leads the group, the rest follow it
+  int leader = -1;
+  for (int e = 0; e < num_events(); ++e) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = m_events[e].type;
+    attr.config = m_events[e].config;
+    attr.disabled = leader == -1 ? 1 : 0;
+    attr.exclude_kernel = 1; // what the games do, and allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    const int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+    if (fd == -1) {
+      if (my.error == 0) {
+        my.error = errno;
+      }
+      continue;
+    }
+    my.fds[e] = fd;
+    if (leader == -1) {
+      leader = fd;
+    }
+  }
+
+  if (leader != -1) {
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#else
+  my.error = ENOSYS;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PerfCounters::stop(const int thread, const int64_t games, const int64_t rounds)
+////////////////////////////////////////////////////////////////////////////////
+{
+  Thread& my = m_threads[thread];
+  my.games += games;
+  my.rounds += rounds;
+
+#ifdef __linux__
+  const int* leader = std::find_if(my.fds, my.fds + num_events(), [](const int fd) { return fd != -1; });
+  if (leader == my.fds + num_events()) {
+    return;
+  }
+  ioctl(*leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  // PERF_FORMAT_GROUP: the number of counters, the times, then the counts in
+  // the order the counters were opened
+  struct {
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[MAX_EVENTS];
+  } data;
+  if (read(*leader, &data, sizeof(data)) > 0 && data.time_running > 0) {
+    const double scale = static_cast<double>(data.time_enabled) / data.time_running;
+    my.multiplexed |= data.time_running < data.time_enabled;
+    uint64_t v = 0;
+    for (int e = 0; e < num_events() && v < data.nr; ++e) {
+      if (my.fds[e] != -1) {
+        my.counts[e] += static_cast<uint64_t>(data.values[v++] * scale);
+        my.counted[e] = true;
+      }
+    }
+  }
+
+  for (int e = 0; e < num_events(); ++e) {
+    if (my.fds[e] != -1) {
+      close(my.fds[e]);
+      my.fds[e] = -1;
+    }
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool PerfCounters::available() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  for (const Thread& thread : m_threads) {
+    if (std::count(thread.counted, thread.counted + num_events(), true) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t PerfCounters::count(const int event, const int thread) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (thread != -1) {
+    return m_threads[thread].counts[event];
+  }
+  uint64_t total = 0;
+  for (const Thread& my : m_threads) {
+    total += my.counts[event];
+  }
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int64_t PerfCounters::games(const int thread) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (thread != -1) {
+    return m_threads[thread].games;
+  }
+  int64_t total = 0;
+  for (const Thread& my : m_threads) {
+    total += my.games;
+  }
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int64_t PerfCounters::rounds(const int thread) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (thread != -1) {
+    return m_threads[thread].rounds;
+  }
+  int64_t total = 0;
+  for (const Thread& my : m_threads) {
+    total += my.rounds;
+  }
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PerfCounters::report(std::ostream& out) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  int error = 0;
+  bool multiplexed = false;
+  std::vector<bool> counted(num_events(), false);
+  for (const Thread& my : m_threads) {
+    error = error == 0 ? my.error : error;
+    multiplexed |= my.multiplexed;
+    for (int e = 0; e < num_events(); ++e) {
+      counted[e] = counted[e] || my.counted[e];
+    }
+  }
+
+  if (!available()) {
+    out << "Perf counters unavailable: " << std::strerror(error);
+    if (error == EACCES || error == EPERM) {
+      out << ", see /proc/sys/kernel/perf_event_paranoid";
+    }
+    out << "\n";
+    return;
+  }
+
+  const int cycles = find("cycles"), instructions = find("instructions");
+  const bool ipc = cycles != -1 && instructions != -1 && counted[cycles] && counted[instructions];
+
+  out << "Perf counters per game" << (multiplexed ? " (scaled, the counters did not run all the time)" : "")
+      << ":\n";
+  out << std::setw(8) << "thread" << std::setw(10) << "games";
+  for (const Event& event : m_events) {
+    out << std::setw(18) << event.name;
+  }
+  out << (ipc ? "       ipc" : "") << "\n";
+
+  const auto print_row = [&](const std::string& label, const int thread) {
+    const int64_t n = games(thread);
+    out << std::setw(8) << label << std::setw(10) << n;
+    for (int e = 0; e < num_events(); ++e) {
+      const bool here = thread == -1 ? counted[e] : m_threads[thread].counted[e];
+      out << std::setw(18);
+      if (here && n > 0) {
+        out << static_cast<double>(count(e, thread)) / n;
+      }
+      else {
+        out << "n/a";
+      }
+    }
+    if (ipc) {
+      const uint64_t ticks = count(cycles, thread);
+      out << std::setw(10) << (ticks > 0 ? static_cast<double>(count(instructions, thread)) / ticks : 0.0);
+    }
+    out << "\n";
+  };
+  for (int thread = 0; thread < static_cast<int>(m_threads.size()); ++thread) {
+    if (games(thread) > 0) {
+      print_row(obj_to_str(thread), thread);
+    }
+  }
+  print_row("total", -1);
+
+  const int64_t total_rounds = rounds();
+  out << "Perf counters per round:";
+  for (int e = 0; e < num_events(); ++e) {
+    out << " " << m_events[e].name << " ";
+    if (counted[e] && total_rounds > 0) {
+      out << static_cast<double>(count(e)) / total_rounds;
+    }
+    else {
+      out << "n/a";
+    }
+  }
+  out << "\n";
+
+  for (int e = 0; e < num_events(); ++e) {
+    if (!counted[e]) {
+      out << "Could not count " << m_events[e].name << (error != 0 ? ": " : "")
+          << (error != 0 ? std::strerror(error) : "") << "\n";
+    }
+  }
+}
+
+}
@@ -0,0 +1,122 @@
+#ifndef MATCHEM_PERF_HPP
+#define MATCHEM_PERF_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace matchem {
+
+/**
+ * Hardware performance counters around the games, read with Linux
+ * perf_event_open. Every worker of a kernel opens its own group of counters
+ * on its thread when it starts, so the counters of a group are enabled and
+ * read together, and closes it when it is done; the counts are added up per
+ * workspace, which is a thread on host backends.
+ *
+ * Counters the kernel or the CPU do not offer, or that do not fit in the
+ * group next to the ones before them, are left out. When none can be opened
+ * (no Linux, perf_event_paranoid, a container without perf) the games are
+ * played anyway and the report says why there are no counts. A group that
+ * had to share the counter registers with other users of perf did not run
+ * all the time; its counts are scaled up to the whole time, which the report
+ * points out.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class PerfCounters
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  static constexpr int MAX_EVENTS = 8;
+
+  struct Event
+  {
+    std::string name;
+    uint32_t type;   // perf_event_attr type and config
+    uint64_t config;
+  };
+
+  /**
+   * find_event - Look up an event by name: cycles, instructions,
+   * cache-references, cache-misses, branches, branch-misses, l1d-misses,
+   * llc-misses, task-clock (ns on the cpu, for machines without hardware
+   * counters) or raw:<hex code> for a CPU specific event (vector
+   * instructions, e.g. FP_ARITH_INST_RETIRED on Intel). Returns false if the
+   * name is unknown.
+   */
+  static bool find_event(const std::string& name, Event& event);
+
+  // Events of --perf-counters without a list
+  static std::vector<std::string> default_events();
+
+  PerfCounters(const std::vector<std::string>& events, const int num_threads);
+  ~PerfCounters();
+
+  /**
+   * start - Open and enable the counters on the calling thread
+   */
+  void start(const int thread);
+
+  /**
+   * stop - Read and close what start opened, credit the games and rounds
+   * played in between
+   */
+  void stop(const int thread, const int64_t games, const int64_t rounds);
+
+  void reset();
+
+  // Whether any counter was ever counted
+  bool available() const;
+
+  int num_events() const { return static_cast<int>(m_events.size()); }
+
+  // Count of an event on a thread, or over all threads with -1
+  uint64_t count(const int event, const int thread = -1) const;
+
+  int64_t games(const int thread = -1) const;
+  int64_t rounds(const int thread = -1) const;
+
+  // Per thread and total counts per game, totals per round and the ipc
+  void report(std::ostream& out) const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// FORBIDDEN METHODS /////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// INTERNAL METHODS //////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  int find(const std::string& name) const;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// DATA MEMBERS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  // Touched by its own thread only
+  struct Thread
+  {
+    int fds[MAX_EVENTS];       // open counters, -1 if not open
+    uint64_t counts[MAX_EVENTS];
+    bool counted[MAX_EVENTS];  // whether this event was ever read here
+    bool multiplexed;          // whether any count was scaled
+    int error;                 // errno of the first counter that did not open
+    int64_t games;
+    int64_t rounds;
+  };
+
+  std::vector<Event> m_events;
+  std::vector<Thread> m_threads;
+};
+
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include "matchem_policy.hpp"
+#include "matchem_exception.hpp"
+
+#include <fstream>
+
+namespace matchem {
+
+////////////////////////////////////////////////////////////////////////////////
+void PolicyTable::load(const std::string& filename, const int expected_size)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ifstream in(filename);
+  my_require(in.good(), "Could not open policy file: " + filename);
+
+  std::string tag;
+  int size = 0;
+  in >> tag >> size;
+  my_require(tag == "size" && size == expected_size,
+             "Policy file " + filename + " is for set size " + obj_to_str(size) +
+             ", expected " + obj_to_str(expected_size));
+
+  m_size = size;
+  m_queries.clear();
+  m_guesses.clear();
+
+  while (in >> tag) {
+    uint64_t history;
+    in >> std::hex >> history >> std::dec;
+    if (tag == "q") {
+      int side1, side2;
+      in >> side1 >> side2;
+      add_query(history, side1, side2);
+    }
+    else if (tag == "g") {
+      std::vector<int> guess(size);
+      for (int i = 0; i < size; ++i) {
+        in >> guess[i];
+      }
+      add_guess(history, guess);
+    }
+    else {
+      my_require(false, "Bad entry '" + tag + "' in policy file: " + filename);
+    }
+    my_require(!in.fail(), "Truncated policy file: " + filename);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PolicyTable::save(const std::string& filename) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ofstream out(filename);
+  my_require(out.good(), "Could not write policy file: " + filename);
+
+  out << "size " << m_size << "\n";
+  for (const auto& item : m_queries) {
+    out << "q " << std::hex << item.first << std::dec << " " << item.second.first << " " << item.second.second << "\n";
+  }
+  for (const auto& item : m_guesses) {
+    out << "g " << std::hex << item.first << std::dec;
+    for (const int side2 : item.second) {
+      out << " " << side2;
+    }
+    out << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool PolicyTable::find_query(const uint64_t history, std::pair<int, int>& query) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto itr = m_queries.find(history);
+  if (itr == m_queries.end()) {
+    return false;
+  }
+  query = itr->second;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool PolicyTable::find_guess(const uint64_t history, int* guess) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto itr = m_guesses.find(history);
+  if (itr == m_guesses.end()) {
+    return false;
+  }
+  for (int i = 0; i < m_size; ++i) {
+    guess[i] = itr->second[i];
+  }
+  return true;
+}
+
+}
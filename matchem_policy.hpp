@@ -0,0 +1,87 @@
+#ifndef MATCHEM_POLICY_HPP
+#define MATCHEM_POLICY_HPP
+
+#include "matchem_common.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace matchem {
+
+/**
+ * For a deterministic strategy, every decision is a function of what has been
+ * observed so far: the truth booth answers and the ceremony scores. We fold
+ * that observation history into a 64-bit hash so decisions can be tabulated.
+ */
+
+constexpr uint64_t HISTORY_ROOT = 0x6d617463680a0000ULL;
+
+KOKKOS_INLINE_FUNCTION
+uint64_t history_after_ask(const uint64_t history, const bool was_match)
+{
+  return hash_combine(history, was_match ? 1 : 0);
+}
+
+KOKKOS_INLINE_FUNCTION
+uint64_t history_after_guess(const uint64_t history, const int matches)
+{
+  return hash_combine(history, 2 + matches);
+}
+
+/**
+ * A table of decisions keyed by observation history. This is how an
+ * offline solver hands its policy to the simulator.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class PolicyTable
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  PolicyTable() : m_size(0) {}
+
+  /**
+   * load - Read a table written by save. Throws a MatchemException if the file
+   *        cannot be read or is not for a set of the expected size.
+   */
+  void load(const std::string& filename, const int expected_size);
+
+  /**
+   * save - Write the table to a text file
+   */
+  void save(const std::string& filename) const;
+
+  void set_size(const int size) { m_size = size; }
+
+  void add_query(const uint64_t history, const int side1, const int side2)
+  { m_queries[history] = std::make_pair(side1, side2); }
+
+  void add_guess(const uint64_t history, const std::vector<int>& guess)
+  { m_guesses[history] = guess; }
+
+  // Queries. These are safe to call concurrently once the table is built.
+
+  bool find_query(const uint64_t history, std::pair<int, int>& query) const;
+
+  bool find_guess(const uint64_t history, int* guess) const;
+
+  int size() const { return m_size; }
+
+  bool empty() const { return m_queries.empty() && m_guesses.empty(); }
+
+  size_t num_entries() const { return m_queries.size() + m_guesses.size(); }
+
+ private:
+
+  int m_size;
+  std::unordered_map<uint64_t, std::pair<int, int> > m_queries;
+  std::unordered_map<uint64_t, std::vector<int> > m_guesses;
+};
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "matchem_profile.hpp"
+
+#include <iomanip>
+#include <string>
+
+namespace matchem {
+
+constexpr uint32_t PhaseTimer::NO_SECTION;
+
+////////////////////////////////////////////////////////////////////////////////
+const char* PhaseProfile::name(const Phase phase)
+////////////////////////////////////////////////////////////////////////////////
+{
+  switch (phase) {
+  case INIT:          return "init";
+  case TRUTH_QUERY:   return "truth_query";
+  case PROCESS_ASK:   return "process_ask";
+  case MAKE_GUESS:    return "make_guess";
+  case COUNT_MATCHES: return "count_matches";
+  case PROCESS_GUESS: return "process_guess";
+  case NUM_PHASES:    break;
+  }
+  return "unknown";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PhaseProfile::print(std::ostream& out) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  uint64_t total = 0;
+  for (int p = 0; p < NUM_PHASES; ++p) {
+    total += cycles[p];
+  }
+  const double ns_per_tick = 1e3 / cycles_per_usec();
+
+  out << std::setw(16) << "phase" << std::setw(14) << "calls" << std::setw(12) << "total ms" << std::setw(12)
+      << "ns/call" << std::setw(10) << "share" << "\n";
+  for (int p = 0; p < NUM_PHASES; ++p) {
+    out << std::setw(16) << name(static_cast<Phase>(p)) << std::setw(14) << calls[p] << std::setw(12)
+        << 1e-6 * ns_per_tick * cycles[p] << std::setw(12)
+        << (calls[p] > 0 ? ns_per_tick * cycles[p] / calls[p] : 0.0) << std::setw(9)
+        << (total > 0 ? 100.0 * cycles[p] / total : 0.0) << "%\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+PhaseSections::PhaseSections() :
+////////////////////////////////////////////////////////////////////////////////
+  m_enabled(Kokkos::Profiling::profileLibraryLoaded()),
+  m_master(std::this_thread::get_id()),
+  m_ids()
+{
+  if (m_enabled) {
+    for (int p = 0; p < PhaseProfile::NUM_PHASES; ++p) {
+      const PhaseProfile::Phase phase = static_cast<PhaseProfile::Phase>(p);
+      Kokkos::Profiling::createProfileSection(std::string("matchem::") + PhaseProfile::name(phase), &m_ids[p]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+PhaseSections::~PhaseSections()
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (m_enabled) {
+    for (int p = 0; p < PhaseProfile::NUM_PHASES; ++p) {
+      Kokkos::Profiling::destroyProfileSection(m_ids[p]);
+    }
+  }
+}
+
+}
@@ -0,0 +1,161 @@
+#ifndef MATCHEM_PROFILE_HPP
+#define MATCHEM_PROFILE_HPP
+
+#include "matchem_budget.hpp"
+#include "matchem_common.hpp"
+#include "matchem_kokkos.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+namespace matchem {
+
+/**
+ * Where the time of games goes, phase by phase. Each workspace has its own,
+ * like Telemetry, and they are summed with merge once the games are done.
+ * Only the phases of real games are timed; bandit rollouts count towards the
+ * decision they are part of. Matchem only times phases in builds configured
+ * with -DPHASE_PROFILING=ON, see matchem.hpp.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct PhaseProfile
+////////////////////////////////////////////////////////////////////////////////
+{
+  enum Phase {
+    INIT,          // init_indv, init_indv_exact
+    TRUTH_QUERY,   // get_best_truth_query
+    PROCESS_ASK,   // process_ask_result with everything it infers
+    MAKE_GUESS,    // make_guess, with get_num_matches in the fused round
+    COUNT_MATCHES, // get_num_matches
+    PROCESS_GUESS, // process_guess_result
+    NUM_PHASES
+  };
+
+  static const char* name(const Phase phase);
+
+  uint64_t cycles[NUM_PHASES]; // read_cycles ticks
+  uint64_t calls[NUM_PHASES];
+
+  KOKKOS_INLINE_FUNCTION
+  PhaseProfile() { reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    for (int p = 0; p < NUM_PHASES; ++p) {
+      cycles[p] = 0;
+      calls[p] = 0;
+    }
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void add(const Phase phase, const uint64_t n)
+  {
+    cycles[phase] += n;
+    ++calls[phase];
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void merge(const PhaseProfile& other)
+  {
+    for (int p = 0; p < NUM_PHASES; ++p) {
+      cycles[p] += other.cycles[p];
+      calls[p] += other.calls[p];
+    }
+  }
+
+  // One line per phase: calls, total time, time per call and share
+  void print(std::ostream& out) const;
+};
+
+/**
+ * A Kokkos Tools section per phase, so an attached tool sees the phases too.
+ * Without a tool there are none and nothing is called. The sections are
+ * registered when Matchem is constructed, before any games are played, and
+ * only the thread that registered them, the master thread of the host
+ * backends, opens them: tools do not expect concurrent starts and stops of a
+ * section, so the tool sees the phases of the games on that thread.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class PhaseSections
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  PhaseSections();
+  ~PhaseSections();
+
+  bool enabled() const { return m_enabled; }
+
+  // Whether the calling thread is the one that opens sections
+  bool opens_here() const { return m_enabled && std::this_thread::get_id() == m_master; }
+
+  uint32_t id(const PhaseProfile::Phase phase) const { return m_ids[phase]; }
+
+ private:
+
+  PhaseSections(const PhaseSections&) = delete;
+  PhaseSections& operator=(const PhaseSections&) = delete;
+
+  bool m_enabled;
+  std::thread::id m_master;
+  uint32_t m_ids[PhaseProfile::NUM_PHASES];
+};
+
+/**
+ * Times one phase from construction to destruction into a profile, and
+ * brackets it with the phase's section when a tool is attached and this is
+ * the master thread. Does nothing without a profile.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class PhaseTimer
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  KOKKOS_INLINE_FUNCTION
+  PhaseTimer(PhaseProfile* profile, const PhaseProfile::Phase phase, const PhaseSections& sections) :
+    m_profile(profile),
+    m_phase(phase),
+    m_section(profile != nullptr && sections.opens_here() ? sections.id(phase) : NO_SECTION),
+    m_start(0)
+  {
+    if (m_section != NO_SECTION) {
+      Kokkos::Profiling::startSection(m_section);
+    }
+    if (m_profile != nullptr) {
+      m_start = read_cycles();
+    }
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  ~PhaseTimer()
+  {
+    if (m_profile != nullptr) {
+      m_profile->add(m_phase, read_cycles() - m_start);
+    }
+    if (m_section != NO_SECTION) {
+      Kokkos::Profiling::stopSection(m_section);
+    }
+  }
+
+ private:
+
+  static constexpr uint32_t NO_SECTION = 0xffffffff;
+
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+  PhaseProfile* m_profile;
+  PhaseProfile::Phase m_phase;
+  uint32_t m_section;
+  uint64_t m_start;
+};
+
+}
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef MATCHEM_ROOK_HPP
+#define MATCHEM_ROOK_HPP
+
+#include "matchem_common.hpp"
+#include "matchem_kokkos.hpp"
+
+#include <cstdint>
+
+/**
+ * Kernels that work on the "candidate board": an N x N board where row i has
+ * a bitmask of the side2 ids that side1 i could still be matched to. Every
+ * hidden state consistent with what we know is a placement of N non-attacking
+ * rooks on the allowed cells of this board.
+ *
+ * Rather than enumerating those placements, we sweep the board one row at a
+ * time keeping, for every subset of used columns, the rook polynomial of the
+ * placements so far with x marking the rooks that land on the candidate guess.
+ * The coefficients of the final polynomial are the match-count distribution.
+ * This is O(2^N * N^2) work instead of O(N!).
+ */
+
+namespace matchem {
+
+template <int N>
+using match_dist_t = Kokkos::Array<int64_t, N+1>;
+
+// Number of int64_t entries of scratch space needed by match_count_dist
+template <int N>
+KOKKOS_INLINE_FUNCTION
+constexpr int match_count_dist_ws_size()
+{
+  return (1 << N) * (N+1);
+}
+
+/**
+ * match_count_dist - For a board of allowed cells (allowed[i] is the mask of
+ * possible side2 ids for side1 i) and a candidate guess (guess[i] is the side2
+ * guessed for side1 i, -1 for none), compute dist[k], the number of hidden
+ * states that fit the board and have exactly k pairs in common with the guess.
+ *
+ * ws must point to match_count_dist_ws_size<N>() entries.
+ */
+template <int N>
+KOKKOS_FUNCTION
+void match_count_dist(const int* allowed, const int* guess, int64_t* ws, match_dist_t<N>& dist)
+{
+  static_assert(N > 0 && N < 31, "Bad board size");
+
+  constexpr int num_masks = 1 << N;
+  constexpr int stride    = N + 1;
+
+  for (int m = 0; m < num_masks*stride; ++m) {
+    ws[m] = 0;
+  }
+  ws[0] = 1;
+
+  // Masks are visited in increasing order, so every mask is complete before we
+  // extend it; adding a column always produces a bigger mask.
+  for (int mask = 0; mask < num_masks - 1; ++mask) {
+    const int64_t* curr = ws + mask*stride;
+
+    int64_t any = 0;
+    MATCHEM_IVDEP
+    for (int k = 0; k < stride; ++k) {
+      any |= curr[k];
+    }
+    if (any == 0) {
+      continue;
+    }
+
+    const int row = popcount(mask);
+    const int open = allowed[row] & ~mask;
+    for (int j = 0; j < N; ++j) {
+      if (is_setb(open, j)) {
+        int64_t* next = ws + (mask | (1 << j))*stride;
+        if (j == guess[row]) {
+          MATCHEM_IVDEP
+          for (int k = 0; k < N; ++k) {
+            next[k+1] += curr[k];
+          }
+        }
+        else {
+          MATCHEM_IVDEP
+          for (int k = 0; k < stride; ++k) {
+            next[k] += curr[k];
+          }
+        }
+      }
+    }
+  }
+
+  const int64_t* full = ws + (num_masks - 1)*stride;
+  for (int k = 0; k < stride; ++k) {
+    dist[k] = full[k];
+  }
+}
+
+/**
+ * count_completions - ws[mask] is the number of ways to finish a placement
+ * whose first popcount(mask) rows use exactly the columns in mask. ws must
+ * point to at least 2^N entries. ws[0] is the number of hidden states that fit
+ * the board.
+ */
+template <int N>
+KOKKOS_FUNCTION
+void count_completions(const int* allowed, int64_t* ws)
+{
+  constexpr int num_masks = 1 << N;
+
+  ws[num_masks - 1] = 1;
+  for (int mask = num_masks - 2; mask >= 0; --mask) {
+    const int open = allowed[popcount(mask)] & ~mask;
+    int64_t total = 0;
+    for (int j = 0; j < N; ++j) {
+      if (is_setb(open, j)) {
+        total += ws[mask | (1 << j)];
+      }
+    }
+    ws[mask] = total;
+  }
+}
+
+/**
+ * sample_placement - Draw a placement uniformly from all that fit the board,
+ * using the counts from count_completions. placement[i] is the column of row i.
+ */
+template <int N, typename RngT>
+KOKKOS_FUNCTION
+void sample_placement(const int* allowed, const int64_t* ws, RngT& rng, int* placement)
+{
+  assert(ws[0] > 0);
+
+  int mask = 0;
+  for (int i = 0; i < N; ++i) {
+    const int open = allowed[i] & ~mask;
+    int64_t pick = rng.below(ws[mask]);
+    for (int j = 0; j < N; ++j) {
+      if (is_setb(open, j)) {
+        const int64_t ways = ws[mask | (1 << j)];
+        if (pick < ways) {
+          placement[i] = j;
+          mask |= (1 << j);
+          break;
+        }
+        pick -= ways;
+      }
+    }
+  }
+}
+
+template <int N>
+KOKKOS_FUNCTION
+bool find_augmenting_path(const int* allowed, const int row, int& visited, int* placement, int* owner)
+{
+  for (int j = 0; j < N; ++j) {
+    if (is_setb(allowed[row], j) && !is_setb(visited, j)) {
+      setb(visited, j);
+      if (owner[j] == -1 || find_augmenting_path<N>(allowed, owner[j], visited, placement, owner)) {
+        placement[row] = j;
+        owner[j] = row;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * complete_placement - Extend a partial placement (-1 for rows without a
+ * column) to a full one using augmenting paths. Rows that already have a
+ * column keep one, though it may change. Returns false if the board has no
+ * full placement.
+ */
+template <int N>
+KOKKOS_FUNCTION
+bool complete_placement(const int* allowed, int* placement)
+{
+  int owner[N];
+  for (int j = 0; j < N; ++j) {
+    owner[j] = -1;
+  }
+  for (int i = 0; i < N; ++i) {
+    if (placement[i] != -1) {
+      assert(owner[placement[i]] == -1);
+      owner[placement[i]] = i;
+    }
+  }
+
+  for (int i = 0; i < N; ++i) {
+    if (placement[i] == -1) {
+      int visited = 0;
+      if (!find_augmenting_path<N>(allowed, i, visited, placement, owner)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <int N>
+void match_count_dist_brute_impl(const int* allowed, const int* guess, const int row, const int used,
+                                 const int matches, match_dist_t<N>& dist)
+{
+  if (row == N) {
+    ++dist[matches];
+    return;
+  }
+
+  const int open = allowed[row] & ~used;
+  for (int j = 0; j < N; ++j) {
+    if (is_setb(open, j)) {
+      match_count_dist_brute_impl<N>(allowed, guess, row + 1, used | (1 << j),
+                                     matches + (j == guess[row] ? 1 : 0), dist);
+    }
+  }
+}
+
+/**
+ * match_count_dist_brute - Reference implementation of match_count_dist that
+ * enumerates every placement. Only intended for testing and benchmarking.
+ */
+template <int N>
+void match_count_dist_brute(const int* allowed, const int* guess, match_dist_t<N>& dist)
+{
+  for (int k = 0; k <= N; ++k) {
+    dist[k] = 0;
+  }
+  match_count_dist_brute_impl<N>(allowed, guess, 0, 0, 0, dist);
+}
+
+}
+
+#endif
@@ -0,0 +1,222 @@
+#include "matchem_scaling.hpp"
+#include "matchem_exception.hpp"
+#include "matchem_kokkos.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+
+namespace matchem {
+
+constexpr int ScalingStats::MAX_WORKERS;
+
+namespace {
+
+// Below this efficiency a width no longer scales, below this factor the
+// factor is a cause
+constexpr double MIN_EFFICIENCY = 0.8;
+constexpr double MIN_FACTOR = 0.9;
+
+uint64_t total_busy_ns(const MatchemScaling::Point& point)
+{
+  uint64_t total = 0;
+  for (int w = 0; w < point.threads; ++w) {
+    total += point.stats.busy_ns[w];
+  }
+  return total;
+}
+
+uint64_t max_busy_ns(const MatchemScaling::Point& point)
+{
+  uint64_t busiest = 0;
+  for (int w = 0; w < point.threads; ++w) {
+    busiest = std::max(busiest, point.stats.busy_ns[w]);
+  }
+  return busiest;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemScaling::MatchemScaling(const MatchemConfig& config) :
+////////////////////////////////////////////////////////////////////////////////
+  m_config(config),
+  m_seed(std::rand()),
+  m_matchem(new Matchem(config))
+{
+  my_require(m_config.target_ci() <= 0.0 && m_config.replay_games().empty() && m_config.decision_budgets_us().empty() &&
+             m_config.curves_file().empty(), "Scaling runs play a fixed set of games and time nothing else");
+  my_require(m_config.num_runs() >= max_threads(), "Scaling needs at least one game per thread");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int MatchemScaling::max_threads() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  return std::min(m_matchem->m_tu.get_num_concurrent_teams(), static_cast<int>(ScalingStats::MAX_WORKERS));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<int> MatchemScaling::thread_counts(const int max_threads)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::vector<int> result;
+  for (int threads = 1; threads < max_threads; threads *= 2) {
+    result.push_back(threads);
+  }
+  result.push_back(max_threads);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemScaling::run()
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const int num_games = m_config.num_runs();
+  const int games_per_thread = num_games / max_threads();
+
+  std::vector<Point> strong, weak;
+  for (const int threads : thread_counts(max_threads())) {
+    strong.push_back(measure(threads, num_games));
+    weak.push_back(measure(threads, games_per_thread * threads));
+  }
+
+  report("Strong scaling, " + obj_to_str(num_games) + " games", strong);
+  report("Weak scaling, " + obj_to_str(games_per_thread) + " games per thread", weak);
+  diagnose(strong);
+
+  const auto finish = std::chrono::steady_clock::now();
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+  std::cout << "Scaling took " << 1e-6*duration.count() << " seconds" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemScaling::Point MatchemScaling::measure(const int threads, const int num_games)
+////////////////////////////////////////////////////////////////////////////////
+{
+  my_require(threads >= 1 && threads <= max_threads(), "Can not scale to " + obj_to_str(threads) + " threads");
+
+  const int64_t num_states = factorial(Matchem::SIZE);
+  const uint64_t seed = m_seed;
+  const double ns_per_tick = 1e3 / cycles_per_usec();
+  Matchem* matchem = m_matchem.get();
+  const bool fused = matchem->can_fuse();
+  int next_game = 0;
+  int* next = &next_game;
+
+  // One team per worker, the league is as wide as the threads we want busy
+  const auto policy = ExeSpaceUtils<>::get_default_team_policy(threads, matchem->m_policy.team_size());
+  Point point{threads, num_games, 0.0, ScalingStats()};
+  const auto start = std::chrono::steady_clock::now();
+  Kokkos::parallel_reduce("MatchemScaling::measure", policy, KOKKOS_LAMBDA(const Matchem::MemberType& team, ScalingStats& local) {
+    const int worker = team.league_rank();
+    const int slot = matchem->m_tu.get_workspace_idx(team);
+    const int ws_idx = matchem->get_team_ws(team, slot);
+
+    // The other threads of the team play copies of the same games, which
+    // must not be counted again
+    ScalingStats copies;
+    ScalingStats& mine = team.team_rank() == 0 ? local : copies;
+
+    for (int game = Matchem::take_games(team, next, 1); game < num_games; game = Matchem::take_games(team, next, 1)) {
+      Rng rng(hash_combine(seed, game));
+      const int hidden = static_cast<int>(rng.below(num_states));
+
+      const uint64_t game_start = read_cycles();
+      matchem->init_indv_exact(ws_idx, hidden);
+      const int rounds = matchem->play_indv(ws_idx, fused, nullptr, &team);
+      mine.busy_ns[worker] += static_cast<uint64_t>((read_cycles() - game_start) * ns_per_tick);
+      ++mine.games[worker];
+      mine.rounds.add(rounds);
+    }
+
+    matchem->m_tu.release_workspace_idx(team, slot);
+  }, StatsReducer<ScalingStats>(point.stats));
+  const auto finish = std::chrono::steady_clock::now();
+  point.seconds = 1e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count();
+
+  return point;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemScaling::Factors MatchemScaling::factors(const Point& base, const Point& point)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const double base_per_game = static_cast<double>(total_busy_ns(base)) / base.games;
+  const double per_game = static_cast<double>(total_busy_ns(point)) / point.games;
+  const double base_sched = 1e-9 * max_busy_ns(base) / base.seconds;
+  const double sched = 1e-9 * max_busy_ns(point) / point.seconds;
+
+  Factors result;
+  result.efficiency = (point.games / point.seconds) / (point.threads * base.games / base.seconds);
+  result.per_game = base_per_game / per_game;
+  result.balance = static_cast<double>(total_busy_ns(point)) / (point.threads * max_busy_ns(point));
+  result.sched = sched / base_sched;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemScaling::report(const std::string& title, const std::vector<Point>& points) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::cout << title << ":" << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(9) << "games" << std::setw(11) << "seconds" << std::setw(12)
+            << "games/s" << std::setw(9) << "speedup" << std::setw(12) << "efficiency" << std::setw(10) << "per-game"
+            << std::setw(9) << "balance" << std::setw(8) << "sched" << std::endl;
+  for (const Point& point : points) {
+    const Factors f = factors(points[0], point);
+    std::cout << std::setw(8) << point.threads << std::setw(9) << point.games << std::setw(11) << point.seconds
+              << std::setw(12) << point.games / point.seconds << std::setw(9) << f.efficiency * point.threads
+              << std::setw(12) << f.efficiency << std::setw(10) << f.per_game << std::setw(9) << f.balance
+              << std::setw(8) << f.sched << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemScaling::diagnose(const std::vector<Point>& points) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto stop = std::find_if(points.begin(), points.end(), [&](const Point& point) {
+    return factors(points[0], point).efficiency < MIN_EFFICIENCY;
+  });
+  if (stop == points.end()) {
+    std::cout << "Scales to " << points.back().threads << " threads with efficiency at least " << MIN_EFFICIENCY
+              << std::endl;
+    return;
+  }
+
+  const Point& point = *stop;
+  const Factors f = factors(points[0], point);
+  std::cout << "Stops scaling at " << point.threads << " threads, efficiency " << f.efficiency << std::endl;
+
+  const bool contention = f.per_game < MIN_FACTOR;
+  const bool imbalance = f.balance < MIN_FACTOR;
+  const bool overhead = f.sched < MIN_FACTOR;
+  if (contention) {
+    std::cout << "  Suspect memory bandwidth or shared caches: a game takes " << 100.0 * (1.0 / f.per_game - 1.0)
+              << "% longer than on 1 thread (or SMT siblings, more threads than cores, lower turbo clocks)" << std::endl;
+  }
+  if (imbalance) {
+    int64_t fewest = point.stats.games[0], most = point.stats.games[0];
+    for (int w = 1; w < point.threads; ++w) {
+      fewest = std::min(fewest, point.stats.games[w]);
+      most = std::max(most, point.stats.games[w]);
+    }
+    std::cout << "  Suspect imbalance: workers sit idle " << 100.0 * (1.0 - f.balance)
+              << "% of the time waiting for the busiest; games take " << point.stats.rounds.min << " to "
+              << point.stats.rounds.max << " rounds and workers played " << fewest << " to " << most
+              << " games, more games per thread would even them out" << std::endl;
+  }
+  if (overhead) {
+    std::cout << "  Suspect scheduling: the busiest worker is in games " << 100.0 * (1.0 - f.sched)
+              << "% less of the wall time than on 1 thread" << std::endl;
+  }
+  if (!contention && !imbalance && !overhead) {
+    std::cout << "  No single cause, the losses are spread over all three factors" << std::endl;
+  }
+}
+
+}
@@ -0,0 +1,157 @@
+#ifndef MATCHEM_SCALING_HPP
+#define MATCHEM_SCALING_HPP
+
+#include "matchem.hpp"
+#include "matchem_config.hpp"
+#include "matchem_stats.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace matchem {
+
+/**
+ * Rounds of the games a scaling run played, and how many games and how much
+ * time in them each worker had
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct ScalingStats
+////////////////////////////////////////////////////////////////////////////////
+{
+  static constexpr int MAX_WORKERS = 256;
+
+  SimStats rounds;
+  uint64_t busy_ns[MAX_WORKERS];
+  int64_t games[MAX_WORKERS];
+
+  KOKKOS_INLINE_FUNCTION
+  ScalingStats() { reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    rounds.reset();
+    for (int w = 0; w < MAX_WORKERS; ++w) {
+      busy_ns[w] = 0;
+      games[w] = 0;
+    }
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void merge(const ScalingStats& other)
+  {
+    rounds.merge(other.rounds);
+    for (int w = 0; w < MAX_WORKERS; ++w) {
+      busy_ns[w] += other.busy_ns[w];
+      games[w] += other.games[w];
+    }
+  }
+};
+
+/**
+ * Measures how game throughput scales with threads. The same games (hidden
+ * states drawn from the game index, as in tournaments) are played by 1, 2,
+ * 4, ... workers, each worker one team of one thread taking the next game as
+ * it finishes one, the way Matchem::run hands them out. Kokkos fixes its
+ * thread pool when it starts, so fewer threads means fewer workers on it;
+ * the widest run uses every thread Kokkos has (--kokkos-threads).
+ *
+ * Strong scaling plays the same --num-runs games at every width, weak scaling
+ * gives every worker the same share of them. Efficiency, throughput over the
+ * width times the 1 thread throughput, splits into three factors that
+ * multiply back to it, each pointing at a cause:
+ *
+ *   per-game: how much longer a game takes than on its own, which is
+ *             contention for memory bandwidth and shared caches
+ *   balance:  time in games over width times the busiest worker, which is
+ *             workers idling at the end while the last long games finish
+ *   sched:    busiest worker over wall time, against the same at 1 thread,
+ *             which is launch and scheduling overhead
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class MatchemScaling
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  // One run at one width
+  struct Point
+  {
+    int threads;
+    int games;
+    double seconds;
+    ScalingStats stats;
+  };
+
+  // Efficiency of a point against the 1 thread point, and its factors
+  struct Factors
+  {
+    double efficiency;
+    double per_game;
+    double balance;
+    double sched;
+  };
+
+  MatchemScaling(const MatchemConfig& config);
+
+  /**
+   * run - Play the strong and weak scaling runs and report them
+   */
+  void run();
+
+  /**
+   * measure - Play games 0 to num_games - 1 with this many workers
+   */
+  Point measure(const int threads, const int num_games);
+
+  // 1, 2, 4, ... and max_threads
+  static std::vector<int> thread_counts(const int max_threads);
+
+  static Factors factors(const Point& base, const Point& point);
+
+  int max_threads() const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// FORBIDDEN METHODS /////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemScaling(const MatchemScaling&) = delete;
+  MatchemScaling& operator=(const MatchemScaling&) = delete;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// INTERNAL METHODS //////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  void report(const std::string& title, const std::vector<Point>& points) const;
+
+  // Name the biggest loss of the first point that stops scaling
+  void diagnose(const std::vector<Point>& points) const;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// DATA MEMBERS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemConfig m_config;
+
+  // Hidden states are a function of this and the game index only
+  uint64_t m_seed;
+
+  std::unique_ptr<Matchem> m_matchem;
+
+  //////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////// FRIENDS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  friend struct matchem::tests::UnitWrap;
+};
+
+}
+
+#endif
@@ -0,0 +1,606 @@
+#include "matchem_solver.hpp"
+#include "matchem_exception.hpp"
+#include "matchem_kokkos.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <numeric>
+
+namespace matchem {
+
+constexpr int MatchemSolver::MAX_SIZE;
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+// Lower bound on V(S) for |S| == c. One round can finish at most two hidden
+// states, one per truth booth answer; everything else needs another round.
+double round_lower_bound(const int c)
+{
+  return c <= 1 ? 1.0 : 2.0 - 2.0/c;
+}
+
+// Lower bound on W(T) for |T| == c. Only the guess itself finishes this round.
+double guess_lower_bound(const int c)
+{
+  return c <= 1 ? 0.0 : static_cast<double>(c - 1)/c;
+}
+
+inline bool test_bit(const std::vector<uint64_t>& bits, const int idx)
+{
+  return is_setb(bits[idx / 64], idx % 64);
+}
+
+inline void set_bit(std::vector<uint64_t>& bits, const int idx)
+{
+  setb(bits[idx / 64], idx % 64);
+}
+
+// Call f(idx) for every set bit
+template <typename Func>
+inline void for_each_bit(const std::vector<uint64_t>& bits, const Func& f)
+{
+  for (size_t w = 0; w < bits.size(); ++w) {
+    uint64_t word = bits[w];
+    while (word != 0) {
+      const int b = __builtin_ctzll(word);
+      f(static_cast<int>(w*64 + b));
+      word &= word - 1;
+    }
+  }
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t MatchemSolver::BitsetHash::operator()(const bitset_t& bits) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  uint64_t result = bits.size();
+  for (const uint64_t word : bits) {
+    result = hash_combine(result, word);
+  }
+  return static_cast<size_t>(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MatchemSolver::ConcurrentMemo::find(const bitset_t& key, Entry& entry) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  const Shard& shard = m_shards[BitsetHash()(key) % NUM_SHARDS];
+  std::lock_guard<std::mutex> guard(shard.lock);
+  const auto itr = shard.table.find(key);
+  if (itr == shard.table.end()) {
+    return false;
+  }
+  entry = itr->second;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSolver::ConcurrentMemo::insert(const bitset_t& key, const Entry& entry)
+////////////////////////////////////////////////////////////////////////////////
+{
+  Shard& shard = m_shards[BitsetHash()(key) % NUM_SHARDS];
+  std::lock_guard<std::mutex> guard(shard.lock);
+  auto itr = shard.table.find(key);
+  if (itr == shard.table.end()) {
+    shard.table.emplace(key, entry);
+  }
+  else if (!itr->second.exact && (entry.exact || entry.value > itr->second.value)) {
+    // Never replace an exact value with a bound, or a bound with a weaker one
+    itr->second = entry;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t MatchemSolver::ConcurrentMemo::size() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  size_t result = 0;
+  for (int s = 0; s < NUM_SHARDS; ++s) {
+    std::lock_guard<std::mutex> guard(m_shards[s].lock);
+    result += m_shards[s].table.size();
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemSolver::MatchemSolver(const MatchemConfig& config) :
+////////////////////////////////////////////////////////////////////////////////
+  m_config(config),
+  m_n(config.solve_size()),
+  m_num_perms(0),
+  m_num_words(0)
+{
+  my_require(m_n > 0 && m_n <= MAX_SIZE,
+             "Solver only supports set sizes from 1 to " + obj_to_str(MAX_SIZE));
+
+  std::vector<int> p(m_n);
+  std::iota(p.begin(), p.end(), 0);
+  do {
+    for (int i = 0; i < m_n; ++i) {
+      m_perms.push_back(static_cast<int8_t>(p[i]));
+    }
+  } while (std::next_permutation(p.begin(), p.end()));
+
+  m_num_perms = m_perms.size() / m_n;
+  m_num_words = (m_num_perms + 63) / 64;
+
+  m_scores.resize(m_num_perms*m_num_perms);
+  for (int g = 0; g < m_num_perms; ++g) {
+    for (int idx = 0; idx < m_num_perms; ++idx) {
+      int matches = 0;
+      for (int i = 0; i < m_n; ++i) {
+        if (perm(g)[i] == perm(idx)[i]) {
+          ++matches;
+        }
+      }
+      m_scores[g*m_num_perms + idx] = static_cast<uint8_t>(matches);
+    }
+  }
+
+  m_queries.assign(m_n*m_n, bitset_t(m_num_words, 0));
+  for (int idx = 0; idx < m_num_perms; ++idx) {
+    for (int i = 0; i < m_n; ++i) {
+      set_bit(m_queries[i*m_n + perm(idx)[i]], idx);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSolver::run()
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  std::cout << "Solving set size " << m_n << " (" << m_num_perms << " hidden states)" << std::endl;
+
+  const double value = solve();
+
+  std::cout << value << " optimal avg rounds per game" << std::endl;
+  std::cout << num_memoized() << " symmetry-reduced states memoized" << std::endl;
+
+  const auto finish = std::chrono::steady_clock::now();
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+  const double report_time = 1e-6*duration.count();
+  std::cout << "Solve took " << report_time << " seconds" << std::endl;
+
+  if (!m_config.policy_file().empty()) {
+    PolicyTable policy;
+    export_policy(policy);
+    policy.save(m_config.policy_file());
+    std::cout << "Wrote " << policy.num_entries() << " decisions to " << m_config.policy_file() << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double MatchemSolver::solve()
+////////////////////////////////////////////////////////////////////////////////
+{
+  bitset_t all(m_num_words, 0);
+  for (int idx = 0; idx < m_num_perms; ++idx) {
+    set_bit(all, idx);
+  }
+
+  return value_round(all, INF, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSolver::export_policy(PolicyTable& policy)
+////////////////////////////////////////////////////////////////////////////////
+{
+  bitset_t all(m_num_words, 0);
+  for (int idx = 0; idx < m_num_perms; ++idx) {
+    set_bit(all, idx);
+  }
+
+  policy.set_size(m_n);
+  export_round(all, HISTORY_ROOT, policy);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t MatchemSolver::num_memoized() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  return m_round_memo.size() + m_guess_memo.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double MatchemSolver::value_round(const bitset_t& S, const double bound, const bool parallel)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int num_s = count(S);
+  assert(num_s > 0);
+  if (num_s == 1) {
+    return 1.0;
+  }
+
+  bitset_t canon;
+  Relabel relabel;
+  canonicalize(S, canon, relabel);
+
+  Entry entry;
+  if (m_round_memo.find(canon, entry) && (entry.exact || entry.value >= bound)) {
+    return entry.value;
+  }
+
+  double best = INF;
+  int best_query = -1;
+  bool tried_uninformative = false;
+  bitset_t yes(m_num_words), no(m_num_words);
+  for (int q = 0; q < m_n*m_n; ++q) {
+    for (int w = 0; w < m_num_words; ++w) {
+      yes[w] = canon[w] &  m_queries[q][w];
+      no[w]  = canon[w] & ~m_queries[q][w];
+    }
+    const int num_yes = count(yes), num_no = num_s - num_yes;
+
+    // Every query with a known answer is equivalent
+    if (num_yes == 0 || num_no == 0) {
+      if (tried_uninformative) {
+        continue;
+      }
+      tried_uninformative = true;
+    }
+
+    const double limit = std::min(best, bound - 1.0);
+    const double no_lb = num_no*guess_lower_bound(num_no) / num_s;
+    if (num_yes*guess_lower_bound(num_yes) / num_s + no_lb >= limit) {
+      continue;
+    }
+
+    double value = 0.0;
+    if (num_yes > 0) {
+      value += num_yes*value_guess(yes, (limit - no_lb)*num_s / num_yes, parallel) / num_s;
+      if (value + no_lb >= limit) {
+        continue;
+      }
+    }
+    if (num_no > 0) {
+      value += num_no*value_guess(no, (limit - value)*num_s / num_no, parallel) / num_s;
+    }
+
+    if (value < best) {
+      best = value;
+      best_query = q;
+    }
+  }
+
+  const double result = 1.0 + best;
+  if (result < bound) {
+    m_round_memo.insert(canon, Entry{result, best_query, true});
+    return result;
+  }
+  else {
+    m_round_memo.insert(canon, Entry{bound, -1, false});
+    return bound;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double MatchemSolver::value_guess(const bitset_t& T, const double bound, const bool parallel)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int num_t = count(T);
+  assert(num_t > 0);
+  if (num_t == 1) {
+    return 0.0;
+  }
+
+  bitset_t canon;
+  Relabel relabel;
+  canonicalize(T, canon, relabel);
+
+  Entry entry;
+  if (m_guess_memo.find(canon, entry) && (entry.exact || entry.value >= bound)) {
+    return entry.value;
+  }
+
+  // Consistent guesses first, they tend to be best and tighten the bound early
+  std::vector<int> order;
+  order.reserve(m_num_perms);
+  for_each_bit(canon, [&](const int idx) { order.push_back(idx); });
+  for (int idx = 0; idx < m_num_perms; ++idx) {
+    if (!test_bit(canon, idx)) {
+      order.push_back(idx);
+    }
+  }
+
+  double best = INF;
+  int best_guess = -1;
+  if (parallel) {
+    // Guesses have wildly different costs, so schedule them dynamically. Idle
+    // threads pick up the next guess and share the best value found so far.
+    std::vector<double> values(order.size(), INF);
+    std::atomic<double> shared_best(INF);
+
+    double* values_ptr = values.data();
+    std::atomic<double>* shared_best_ptr = &shared_best;
+    const int* order_ptr = order.data();
+    const int num_order = order.size();
+    Kokkos::parallel_for(
+      "MatchemSolver::value_guess",
+      Kokkos::RangePolicy<Kokkos::DefaultHostExecutionSpace, Kokkos::Schedule<Kokkos::Dynamic> >(0, num_order),
+      KOKKOS_LAMBDA(const int k) {
+        const double limit = std::min(shared_best_ptr->load(), bound);
+        const double value = eval_guess(canon, num_t, order_ptr[k], limit);
+        // At or over its limit, eval_guess may have pruned and only found a
+        // lower bound. Another guess is at least as good then, so this one
+        // must not be picked, not even on a tie.
+        if (value >= limit) {
+          return;
+        }
+        values_ptr[k] = value;
+
+        double curr = shared_best_ptr->load();
+        while (value < curr && !shared_best_ptr->compare_exchange_weak(curr, value)) {}
+    });
+
+    for (int k = 0; k < num_order; ++k) {
+      if (values[k] < best) {
+        best = values[k];
+        best_guess = order[k];
+      }
+    }
+  }
+  else {
+    for (const int guess : order) {
+      const double value = eval_guess(canon, num_t, guess, std::min(best, bound));
+      if (value < best) {
+        best = value;
+        best_guess = guess;
+      }
+    }
+  }
+
+  if (best < bound) {
+    m_guess_memo.insert(canon, Entry{best, best_guess, true});
+    return best;
+  }
+  else {
+    m_guess_memo.insert(canon, Entry{bound, -1, false});
+    return bound;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double MatchemSolver::eval_guess(const bitset_t& T, const int num_t, const int guess, const double limit)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::vector<bitset_t> classes(m_n + 1, bitset_t(m_num_words, 0));
+  std::vector<int> counts(m_n + 1, 0);
+  for_each_bit(T, [&](const int idx) {
+    const int s = score(guess, idx);
+    set_bit(classes[s], idx);
+    ++counts[s];
+  });
+
+  // A guess that tells us nothing can never be part of an optimal strategy
+  for (int s = 0; s < m_n; ++s) {
+    if (counts[s] == num_t) {
+      return INF;
+    }
+  }
+
+  double rest_lb = 0.0;
+  for (int s = 0; s < m_n; ++s) {
+    rest_lb += counts[s]*round_lower_bound(counts[s]) / num_t;
+  }
+  if (rest_lb >= limit) {
+    return rest_lb;
+  }
+
+  double value = 0.0;
+  for (int s = 0; s < m_n; ++s) {
+    if (counts[s] > 0) {
+      rest_lb -= counts[s]*round_lower_bound(counts[s]) / num_t;
+      const double child_bound = (limit - value - rest_lb)*num_t / counts[s];
+      value += counts[s]*value_round(classes[s], child_bound, false) / num_t;
+      if (value + rest_lb >= limit) {
+        return value + rest_lb;
+      }
+    }
+  }
+
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSolver::canonicalize(const bitset_t& S, bitset_t& canon, Relabel& relabel) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  // We order rows and columns by invariants of the set (how many of its hidden
+  // states use each cell), refined once by the classes of the other side. Ties
+  // are broken by the original label, so equivalent states do not always meet,
+  // but a state is only ever identified with a true relabeling of itself.
+  const int n = m_n;
+  std::vector<int> counts(n*n, 0);
+  for_each_bit(S, [&](const int idx) {
+    for (int i = 0; i < n; ++i) {
+      ++counts[i*n + perm(idx)[i]];
+    }
+  });
+
+  using sig_t = std::vector<int>;
+  auto classify = [](const std::vector<sig_t>& sigs) {
+    std::vector<sig_t> distinct(sigs);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    std::vector<int> result(sigs.size());
+    for (size_t k = 0; k < sigs.size(); ++k) {
+      result[k] = std::lower_bound(distinct.begin(), distinct.end(), sigs[k]) - distinct.begin();
+    }
+    return result;
+  };
+
+  std::vector<sig_t> row_sigs(n, sig_t(n)), col_sigs(n, sig_t(n));
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      row_sigs[i][j] = counts[i*n + j];
+      col_sigs[j][i] = counts[i*n + j];
+    }
+  }
+  for (int k = 0; k < n; ++k) {
+    std::sort(row_sigs[k].begin(), row_sigs[k].end());
+    std::sort(col_sigs[k].begin(), col_sigs[k].end());
+  }
+  const std::vector<int> row_class = classify(row_sigs), col_class = classify(col_sigs);
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      row_sigs[i][j] = counts[i*n + j]*(n + 1) + col_class[j];
+      col_sigs[j][i] = counts[i*n + j]*(n + 1) + row_class[i];
+    }
+  }
+  for (int k = 0; k < n; ++k) {
+    std::sort(row_sigs[k].begin(), row_sigs[k].end());
+    std::sort(col_sigs[k].begin(), col_sigs[k].end());
+  }
+
+  std::vector<int> rows(n), cols(n);
+  std::iota(rows.begin(), rows.end(), 0);
+  std::iota(cols.begin(), cols.end(), 0);
+  std::stable_sort(rows.begin(), rows.end(), [&](const int a, const int b) { return row_sigs[a] < row_sigs[b]; });
+  std::stable_sort(cols.begin(), cols.end(), [&](const int a, const int b) { return col_sigs[a] < col_sigs[b]; });
+
+  relabel.row.resize(n);
+  relabel.col.resize(n);
+  for (int k = 0; k < n; ++k) {
+    relabel.row[rows[k]] = k;
+    relabel.col[cols[k]] = k;
+  }
+
+  canon.assign(m_num_words, 0);
+  std::vector<int> relabeled(n);
+  for_each_bit(S, [&](const int idx) {
+    for (int i = 0; i < n; ++i) {
+      relabeled[relabel.row[i]] = relabel.col[perm(idx)[i]];
+    }
+    set_bit(canon, rank_perm(relabeled.data()));
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSolver::export_round(const bitset_t& S, const uint64_t history, PolicyTable& policy)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int n = m_n;
+  int side1 = 0, side2 = 0;
+
+  if (count(S) == 1) {
+    // Nothing left to learn, any query will do
+    for_each_bit(S, [&](const int idx) { side2 = perm(idx)[0]; });
+  }
+  else {
+    bitset_t canon;
+    Relabel relabel;
+    canonicalize(S, canon, relabel);
+
+    Entry entry;
+    if (!m_round_memo.find(canon, entry) || !entry.exact) {
+      value_round(S, INF, false);
+      m_round_memo.find(canon, entry);
+    }
+    assert(entry.exact);
+
+    // Map the canonical query back to our labels
+    for (int k = 0; k < n; ++k) {
+      if (relabel.row[k] == entry.decision / n) { side1 = k; }
+      if (relabel.col[k] == entry.decision % n) { side2 = k; }
+    }
+  }
+
+  policy.add_query(history, side1, side2);
+
+  bitset_t T(m_num_words);
+  for (const bool answer : {false, true}) {
+    for (int w = 0; w < m_num_words; ++w) {
+      T[w] = S[w] & (answer ? m_queries[side1*n + side2][w] : ~m_queries[side1*n + side2][w]);
+    }
+    if (count(T) > 0) {
+      export_guess(T, history_after_ask(history, answer), policy);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSolver::export_guess(const bitset_t& T, const uint64_t history, PolicyTable& policy)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int n = m_n;
+  std::vector<int> guess(n);
+
+  if (count(T) == 1) {
+    for_each_bit(T, [&](const int idx) { guess.assign(perm(idx), perm(idx) + n); });
+    policy.add_guess(history, guess);
+    return;
+  }
+
+  bitset_t canon;
+  Relabel relabel;
+  canonicalize(T, canon, relabel);
+
+  Entry entry;
+  if (!m_guess_memo.find(canon, entry) || !entry.exact) {
+    value_guess(T, INF, false);
+    m_guess_memo.find(canon, entry);
+  }
+  assert(entry.exact);
+
+  // Map the canonical guess back to our labels
+  std::vector<int> col_inv(n);
+  for (int j = 0; j < n; ++j) {
+    col_inv[relabel.col[j]] = j;
+  }
+  for (int i = 0; i < n; ++i) {
+    guess[i] = col_inv[perm(entry.decision)[relabel.row[i]]];
+  }
+  policy.add_guess(history, guess);
+
+  const int guess_idx = rank_perm(guess.data());
+  for (int s = 0; s < n; ++s) {
+    bitset_t U(m_num_words, 0);
+    for_each_bit(T, [&](const int idx) {
+      if (score(guess_idx, idx) == s) {
+        set_bit(U, idx);
+      }
+    });
+    if (count(U) > 0) {
+      export_round(U, history_after_guess(history, s), policy);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int MatchemSolver::rank_perm(const int* p) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  // Lehmer code, which matches the lexicographic order of m_perms
+  int result = 0;
+  for (int i = 0; i < m_n; ++i) {
+    int smaller = 0;
+    for (int k = i + 1; k < m_n; ++k) {
+      if (p[k] < p[i]) {
+        ++smaller;
+      }
+    }
+    result = result*(m_n - i) + smaller;
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int MatchemSolver::count(const bitset_t& bits) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  int result = 0;
+  for (const uint64_t word : bits) {
+    result += popcount(word);
+  }
+  return result;
+}
+
+}
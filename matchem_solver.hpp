@@ -0,0 +1,172 @@
+#ifndef MATCHEM_SOLVER_HPP
+#define MATCHEM_SOLVER_HPP
+
+#include "matchem_config.hpp"
+#include "matchem_policy.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace matchem {
+
+/**
+ * Computes the optimal strategy, the one with the minimum expected number of
+ * rounds, for small set sizes by exhaustive expectimax search.
+ *
+ * The search state is the set of hidden states (permutations) that are still
+ * consistent with every truth booth answer and ceremony score seen so far,
+ * stored as a bitset over all n! permutations. Each round the strategy picks
+ * a truth query, sees the answer, then picks a guess and sees its score:
+ *
+ *   V(S) = 1 + min_query  sum_answer P(answer) W(S_answer)
+ *   W(T) =     min_guess  sum_score<n P(score) V(T_score)
+ *
+ * States are reduced by symmetry (relabeling side1 and side2) before they are
+ * memoized, and branch-and-bound on simple lower bounds prunes most of the
+ * guess space. Set size 5 solves in about a second; every step up in size
+ * costs orders of magnitude more.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class MatchemSolver
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  static constexpr int MAX_SIZE = 7;
+
+  MatchemSolver(const MatchemConfig& config);
+
+  /**
+   * run - Solve the game, report the optimal value and save the optimal
+   *       policy if the config has a policy file.
+   */
+  void run();
+
+  /**
+   * solve - Returns the optimal expected number of rounds
+   */
+  double solve();
+
+  /**
+   * export_policy - Walk the optimal strategy, tabulating its decisions by
+   *                 observation history. Must be called after solve.
+   */
+  void export_policy(PolicyTable& policy);
+
+  int size() const { return m_n; }
+
+  size_t num_memoized() const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// FORBIDDEN METHODS /////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemSolver(const MatchemSolver&) = delete;
+  MatchemSolver& operator=(const MatchemSolver&) = delete;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// INTERNAL TYPES ////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  using bitset_t = std::vector<uint64_t>;
+
+  struct BitsetHash
+  {
+    size_t operator()(const bitset_t& bits) const;
+  };
+
+  // A memoized result. If !exact, value is only a lower bound.
+  struct Entry
+  {
+    double value;
+    int    decision; // query idx (side1*n + side2) for V, guess perm idx for W
+    bool   exact;
+  };
+
+  /**
+   * A hash table of Entry, sharded by key hash so that threads searching
+   * different parts of the tree rarely contend on the same lock.
+   */
+  class ConcurrentMemo
+  {
+   public:
+    bool find(const bitset_t& key, Entry& entry) const;
+    void insert(const bitset_t& key, const Entry& entry);
+    size_t size() const;
+
+   private:
+    static constexpr int NUM_SHARDS = 64;
+
+    struct Shard
+    {
+      mutable std::mutex lock;
+      std::unordered_map<bitset_t, Entry, BitsetHash> table;
+    };
+
+    Shard m_shards[NUM_SHARDS];
+  };
+
+  // A relabeling of side1 (rows) and side2 (columns)
+  struct Relabel
+  {
+    std::vector<int> row; // row[i] is the new label of side1 i
+    std::vector<int> col; // col[j] is the new label of side2 j
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// INTERNAL METHODS //////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  // Expected rounds from the start of a round with consistent set S. If the
+  // result would be >= bound, returns some value >= bound instead.
+  double value_round(const bitset_t& S, const double bound, const bool parallel);
+
+  // Expected rounds remaining after this round's guess, for consistent set T
+  double value_guess(const bitset_t& T, const double bound, const bool parallel);
+
+  // Evaluate a single guess against canonical set T, bailing out at limit
+  double eval_guess(const bitset_t& T, const int num_t, const int guess, const double limit);
+
+  // Relabel S into a canonical representative of its symmetry class
+  void canonicalize(const bitset_t& S, bitset_t& canon, Relabel& relabel) const;
+
+  void export_round(const bitset_t& S, const uint64_t history, PolicyTable& policy);
+
+  void export_guess(const bitset_t& T, const uint64_t history, PolicyTable& policy);
+
+  int rank_perm(const int* perm) const;
+
+  const int8_t* perm(const int idx) const { return &m_perms[idx*m_n]; }
+
+  int score(const int guess, const int idx) const { return m_scores[guess*m_num_perms + idx]; }
+
+  int count(const bitset_t& bits) const;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ///////////////////////////// DATA MEMBERS ///////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemConfig m_config;
+
+  int m_n;
+  int m_num_perms;
+  int m_num_words;
+
+  std::vector<int8_t>  m_perms;   // all n! perms in lexicographic order, n entries each
+  std::vector<uint8_t> m_scores;  // num matches between every pair of perms
+  std::vector<bitset_t> m_queries; // idx side1*n + side2, perms where side1 -> side2
+
+  ConcurrentMemo m_round_memo;
+  ConcurrentMemo m_guess_memo;
+};
+
+}
+
+#endif
@@ -0,0 +1,189 @@
+#include "matchem_stats.hpp"
+#include "matchem_exception.hpp"
+
+#include <fstream>
+
+namespace matchem {
+
+////////////////////////////////////////////////////////////////////////////////
+double SimStats::mean() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double SimStats::variance() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (count < 2) {
+    return 0.0;
+  }
+  // sum*sum can overflow for big runs, go through the mean instead
+  const double avg = mean();
+  return std::max(0.0, (static_cast<double>(sum_sq) - count * avg * avg) / (count - 1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double SimStats::stddev() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  return std::sqrt(variance());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double SimStats::ci95() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  return count > 0 ? 1.96 * stddev() / std::sqrt(static_cast<double>(count)) : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int SimStats::percentile(const double p) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  assert(p > 0.0 && p <= 1.0);
+  const double needed = std::ceil(p * count);
+  int64_t seen = 0;
+  for (int r = 0; r < NUM_BINS; ++r) {
+    seen += histogram[r];
+    if (seen > 0 && seen >= needed) {
+      return r;
+    }
+  }
+  return max;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double SimStats::prob_within(const int limit) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  int64_t within = 0;
+  for (int r = 0; r <= std::min(limit, NUM_BINS - 1); ++r) {
+    within += histogram[r];
+  }
+  return count > 0 ? static_cast<double>(within) / count : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SimStats::save(std::ostream& out) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  out << count << " " << sum << " " << sum_sq << " " << min << " " << max << "\n";
+  for (int r = 0; r < NUM_BINS; ++r) {
+    out << histogram[r] << (r + 1 < NUM_BINS ? " " : "\n");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SimStats::load(std::istream& in)
+////////////////////////////////////////////////////////////////////////////////
+{
+  in >> count >> sum >> sum_sq >> min >> max;
+  for (int r = 0; r < NUM_BINS; ++r) {
+    in >> histogram[r];
+  }
+  my_require(!in.fail(), "Truncated stats");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::ostream& operator<<(std::ostream& out, const SimStats& stats)
+////////////////////////////////////////////////////////////////////////////////
+{
+  out << "games: " << stats.count << ", rounds: mean " << stats.mean() << " +/- " << stats.ci95()
+      << " (95% CI), stddev " << stats.stddev() << ", min " << stats.min << ", max " << stats.max << "\n";
+  out << "percentiles: p50 " << stats.percentile(0.5) << ", p90 " << stats.percentile(0.9)
+      << ", p99 " << stats.percentile(0.99);
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double PairedStats::mean() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double PairedStats::stddev() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (count < 2) {
+    return 0.0;
+  }
+  const double avg = mean();
+  return std::sqrt(std::max(0.0, (static_cast<double>(sum_sq) - count * avg * avg) / (count - 1)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double PairedStats::ci95() const
+////////////////////////////////////////////////////////////////////////////////
+{
+  return count > 0 ? 1.96 * stddev() / std::sqrt(static_cast<double>(count)) : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t LatencyStats::bucket_end(const int b)
+////////////////////////////////////////////////////////////////////////////////
+{
+  if (b < 4) {
+    return b + 1;
+  }
+  const int shift = b / 4 - 1;
+  const uint64_t end = static_cast<uint64_t>(5 + b % 4) << shift;
+  // The very last bucket runs to the end of uint64_t
+  return b + 1 < NUM_BUCKETS ? end : std::numeric_limits<uint64_t>::max();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t LatencyStats::percentile_ns(const double p) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  assert(p > 0.0 && p <= 1.0);
+  const double needed = std::ceil(p * count);
+  int64_t seen = 0;
+  for (int b = 0; b < NUM_BUCKETS; ++b) {
+    seen += buckets[b];
+    if (seen > 0 && seen >= needed) {
+      return bucket_end(b);
+    }
+  }
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::ostream& operator<<(std::ostream& out, const LatencyStats& stats)
+////////////////////////////////////////////////////////////////////////////////
+{
+  out << "game latency (us): mean " << (stats.count > 0 ? 1e-3 * stats.total_ns / stats.count : 0.0)
+      << ", p50 < " << 1e-3 * stats.percentile_ns(0.5) << ", p99 < " << 1e-3 * stats.percentile_ns(0.99)
+      << ", max " << (stats.num_slowest > 0 ? 1e-3 * stats.slowest_ns[0] : 0.0) << "\n";
+  out << "slowest games (us, game):";
+  for (int k = 0; k < stats.num_slowest; ++k) {
+    out << " " << 1e-3 * stats.slowest_ns[k] << " " << stats.slowest_game[k] << (k + 1 < stats.num_slowest ? "," : "");
+  }
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void RoundCurves::write_csv(std::ostream& out) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  out << "round,games,matches,known,entropy,marginal_entropy\n";
+  for (int r = 0; r < NUM_ROUNDS && games[r] > 0; ++r) {
+    out << r << "," << games[r] << "," << static_cast<double>(matches[r]) / games[r] << ","
+        << static_cast<double>(known[r]) / games[r] << "," << entropy[r] / games[r] << ","
+        << marginal_entropy[r] / games[r] << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void RoundCurves::write_csv(const std::string& filename) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ofstream out(filename);
+  my_require(out.good(), "Could not write curves file: " + filename);
+  write_csv(out);
+}
+
+}
@@ -0,0 +1,409 @@
+#ifndef MATCHEM_STATS_HPP
+#define MATCHEM_STATS_HPP
+
+#include "matchem_common.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace matchem {
+
+/**
+ * Everything we want to know about the number of rounds a batch of games
+ * took: a histogram plus the running sums needed for the moments. Adding a
+ * game and merging two batches are both cheap, so every thread can keep its
+ * own copy and only merge at the end.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct SimStats
+////////////////////////////////////////////////////////////////////////////////
+{
+  // Games never take this many rounds. A game can take Matchem::MAX_ROUNDS,
+  // so that must be below.
+  static constexpr int NUM_BINS = 65;
+
+  int64_t histogram[NUM_BINS];
+  int64_t count;
+  int64_t sum;
+  int64_t sum_sq;
+  int min;
+  int max;
+
+  KOKKOS_INLINE_FUNCTION
+  SimStats() { reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    for (int r = 0; r < NUM_BINS; ++r) {
+      histogram[r] = 0;
+    }
+    count  = 0;
+    sum    = 0;
+    sum_sq = 0;
+    min    = NUM_BINS;
+    max    = -1;
+  }
+
+  // Record one game
+  KOKKOS_INLINE_FUNCTION
+  void add(const int rounds)
+  {
+    assert(rounds >= 0 && rounds < NUM_BINS);
+    ++histogram[rounds];
+    ++count;
+    sum    += rounds;
+    sum_sq += rounds * rounds;
+    min = rounds < min ? rounds : min;
+    max = rounds > max ? rounds : max;
+  }
+
+  // Fold in the games of another batch
+  KOKKOS_INLINE_FUNCTION
+  void merge(const SimStats& other)
+  {
+    for (int r = 0; r < NUM_BINS; ++r) {
+      histogram[r] += other.histogram[r];
+    }
+    count  += other.count;
+    sum    += other.sum;
+    sum_sq += other.sum_sq;
+    min = other.min < min ? other.min : min;
+    max = other.max > max ? other.max : max;
+  }
+
+  double mean() const;
+
+  // Sample variance and standard deviation, 0 for fewer than two games
+  double variance() const;
+  double stddev() const;
+
+  // Half width of the 95% confidence interval of the mean
+  double ci95() const;
+
+  // Smallest number of rounds that at least fraction p of the games needed
+  // no more than (nearest rank), p in (0, 1]
+  int percentile(const double p) const;
+
+  // Fraction of games that took no more than limit rounds
+  double prob_within(const int limit) const;
+
+  // Plain text round trip, for checkpoints
+  void save(std::ostream& out) const;
+  void load(std::istream& in);
+};
+
+std::ostream& operator<<(std::ostream& out, const SimStats& stats);
+
+/**
+ * Differences in rounds between two strategies that played the same games,
+ * first minus second. Pairing cancels out how hard a game is for both, so
+ * the more the strategies agree on that, the fewer games it takes to tell
+ * them apart.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct PairedStats
+////////////////////////////////////////////////////////////////////////////////
+{
+  int64_t count;
+  int64_t sum;
+  int64_t sum_sq;
+  int64_t wins;   // games the first strategy finished in fewer rounds
+  int64_t losses; // games the second strategy finished in fewer rounds
+
+  KOKKOS_INLINE_FUNCTION
+  PairedStats() { reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    count  = 0;
+    sum    = 0;
+    sum_sq = 0;
+    wins   = 0;
+    losses = 0;
+  }
+
+  // Record one game played by both
+  KOKKOS_INLINE_FUNCTION
+  void add(const int first_rounds, const int second_rounds)
+  {
+    const int diff = first_rounds - second_rounds;
+    ++count;
+    sum    += diff;
+    sum_sq += diff * diff;
+    wins   += diff < 0 ? 1 : 0;
+    losses += diff > 0 ? 1 : 0;
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void merge(const PairedStats& other)
+  {
+    count  += other.count;
+    sum    += other.sum;
+    sum_sq += other.sum_sq;
+    wins   += other.wins;
+    losses += other.losses;
+  }
+
+  // Mean difference in rounds, negative when the first strategy is faster
+  double mean() const;
+
+  double stddev() const;
+
+  // Half width of the 95% confidence interval of the mean difference
+  double ci95() const;
+};
+
+/**
+ * How games progress round by round: for every round, how many games got
+ * that far and, summed over those games, the correct matches in that
+ * round's ceremony, the pairs known to be matches after it, the entropy
+ * (bits) of the hidden state after it and the marginal entropy (bits) of the
+ * odds after it. The entropy only counts what the truth queries ruled out,
+ * see Matchem::get_entropy; the marginal entropy is the entropy of each
+ * side1's odds, summed over side1s.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct RoundCurves
+////////////////////////////////////////////////////////////////////////////////
+{
+  static constexpr int NUM_ROUNDS = SimStats::NUM_BINS;
+
+  int64_t games[NUM_ROUNDS];
+  int64_t matches[NUM_ROUNDS];
+  int64_t known[NUM_ROUNDS];
+  double entropy[NUM_ROUNDS];
+  double marginal_entropy[NUM_ROUNDS];
+
+  KOKKOS_INLINE_FUNCTION
+  RoundCurves() { reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    for (int r = 0; r < NUM_ROUNDS; ++r) {
+      games[r]   = 0;
+      matches[r] = 0;
+      known[r]   = 0;
+      entropy[r] = 0.0;
+      marginal_entropy[r] = 0.0;
+    }
+  }
+
+  // Record one round of one game
+  KOKKOS_INLINE_FUNCTION
+  void add(const int round, const int round_matches, const int round_known, const double round_entropy,
+           const double round_marginal_entropy)
+  {
+    assert(round >= 0 && round < NUM_ROUNDS);
+    ++games[round];
+    matches[round] += round_matches;
+    known[round]   += round_known;
+    entropy[round] += round_entropy;
+    marginal_entropy[round] += round_marginal_entropy;
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void merge(const RoundCurves& other)
+  {
+    for (int r = 0; r < NUM_ROUNDS; ++r) {
+      games[r]   += other.games[r];
+      matches[r] += other.matches[r];
+      known[r]   += other.known[r];
+      entropy[r] += other.entropy[r];
+      marginal_entropy[r] += other.marginal_entropy[r];
+    }
+  }
+
+  // One line per round that any game reached, with the averages over the
+  // games that reached it
+  void write_csv(std::ostream& out) const;
+  void write_csv(const std::string& filename) const;
+};
+
+/**
+ * How long games took, in nanoseconds. The histogram splits every power of
+ * two into four buckets, so it covers everything from nanoseconds to minutes
+ * in a couple hundred bins and no bucket is more than 25% wide. The slowest
+ * few games are kept, by id, so they can be replayed.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct LatencyStats
+////////////////////////////////////////////////////////////////////////////////
+{
+  static constexpr int NUM_BUCKETS = 4*63;
+
+  static constexpr int NUM_SLOWEST = 8;
+
+  int64_t buckets[NUM_BUCKETS];
+  int64_t count;
+  uint64_t total_ns;
+
+  // Slowest games first
+  uint64_t slowest_ns[NUM_SLOWEST];
+  int64_t slowest_game[NUM_SLOWEST];
+  int num_slowest;
+
+  KOKKOS_INLINE_FUNCTION
+  LatencyStats() { reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    for (int b = 0; b < NUM_BUCKETS; ++b) {
+      buckets[b] = 0;
+    }
+    count       = 0;
+    total_ns    = 0;
+    num_slowest = 0;
+  }
+
+  // Buckets 0-3 hold 0-3 ns, after that the bucket is the position of the
+  // leading bit and the two bits below it
+  KOKKOS_INLINE_FUNCTION
+  static int bucket(const uint64_t ns)
+  {
+    if (ns < 4) {
+      return static_cast<int>(ns);
+    }
+    const int top = 63 - __builtin_clzll(ns);
+    return 4*(top - 1) + static_cast<int>((ns >> (top - 2)) & 3);
+  }
+
+  // First ns past bucket b
+  static uint64_t bucket_end(const int b);
+
+  // Would a game this slow make the list of slowest games? Lets callers
+  // skip working out the id of games that would not.
+  KOKKOS_INLINE_FUNCTION
+  bool is_slow(const uint64_t ns) const
+  {
+    return num_slowest < NUM_SLOWEST || ns > slowest_ns[NUM_SLOWEST - 1];
+  }
+
+  // Record one game, game is only looked at if is_slow(ns)
+  KOKKOS_INLINE_FUNCTION
+  void add(const uint64_t ns, const int64_t game)
+  {
+    ++buckets[bucket(ns)];
+    ++count;
+    total_ns += ns;
+    if (is_slow(ns)) {
+      keep_slow(ns, game);
+    }
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void merge(const LatencyStats& other)
+  {
+    for (int b = 0; b < NUM_BUCKETS; ++b) {
+      buckets[b] += other.buckets[b];
+    }
+    count    += other.count;
+    total_ns += other.total_ns;
+    for (int k = 0; k < other.num_slowest && is_slow(other.slowest_ns[k]); ++k) {
+      keep_slow(other.slowest_ns[k], other.slowest_game[k]);
+    }
+  }
+
+  // End of the bucket holding the p'th fraction of games, p in (0, 1]
+  uint64_t percentile_ns(const double p) const;
+
+ private:
+
+  // Insertion into the short sorted list, dropping the fastest if it is full
+  KOKKOS_INLINE_FUNCTION
+  void keep_slow(const uint64_t ns, const int64_t game)
+  {
+    int k = num_slowest < NUM_SLOWEST ? num_slowest++ : NUM_SLOWEST - 1;
+    for (; k > 0 && slowest_ns[k-1] < ns; --k) {
+      slowest_ns[k]   = slowest_ns[k-1];
+      slowest_game[k] = slowest_game[k-1];
+    }
+    slowest_ns[k]   = ns;
+    slowest_game[k] = game;
+  }
+};
+
+std::ostream& operator<<(std::ostream& out, const LatencyStats& stats);
+
+/**
+ * Everything play_games collects in its single pass over the games
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct RunStats
+////////////////////////////////////////////////////////////////////////////////
+{
+  SimStats rounds;
+  RoundCurves curves;
+  LatencyStats latency;
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    rounds.reset();
+    curves.reset();
+    latency.reset();
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void merge(const RunStats& other)
+  {
+    rounds.merge(other.rounds);
+    curves.merge(other.curves);
+    latency.merge(other.latency);
+  }
+};
+
+/**
+ * Kokkos reducer for any of the stats above (anything with reset and merge),
+ * lets a parallel_reduce collect them in one pass. Each thread adds to its own
+ * copy, they are joined once at the end, so the games themselves never touch
+ * shared memory.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename Stats>
+class StatsReducer
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  using reducer = StatsReducer;
+  using value_type = Stats;
+  using result_view_type = Kokkos::View<value_type, Kokkos::HostSpace, Kokkos::MemoryUnmanaged>;
+
+  KOKKOS_INLINE_FUNCTION
+  StatsReducer(value_type& value) : m_value(&value) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void join(value_type& dest, const value_type& src) const { dest.merge(src); }
+
+  KOKKOS_INLINE_FUNCTION
+  void init(value_type& value) const { value.reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  value_type& reference() const { return *m_value; }
+
+  KOKKOS_INLINE_FUNCTION
+  result_view_type view() const { return result_view_type(m_value); }
+
+  KOKKOS_INLINE_FUNCTION
+  bool references_scalar() const { return true; }
+
+ private:
+
+  value_type* m_value;
+};
+
+}
+
+#endif
@@ -0,0 +1,266 @@
+#include "matchem_sweep.hpp"
+#include "matchem.hpp"
+#include "matchem_exception.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+namespace matchem {
+
+namespace {
+
+#ifdef EXTRA_TRACKING
+constexpr bool FULL_TRACKING = true;
+#else
+constexpr bool FULL_TRACKING = false;
+#endif
+
+const char* tracking_name(const bool full_tracking)
+{
+  return full_tracking ? "full" : "lean";
+}
+
+std::string trim(const std::string& str)
+{
+  const size_t first = str.find_first_not_of(" \t\r");
+  const size_t last  = str.find_last_not_of(" \t\r");
+  return first == std::string::npos ? std::string() : str.substr(first, last - first + 1);
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemSweep::MatchemSweep(const MatchemConfig& config) :
+////////////////////////////////////////////////////////////////////////////////
+  m_config(config),
+  m_rows(),
+  m_results()
+{
+  my_require(!m_config.grid_file().empty(), "Sweep mode requires a grid file");
+  my_require(m_config.target_ci() <= 0.0 && m_config.replay_games().empty() && m_config.decision_budgets_us().empty(),
+             "Sweeps play a fixed number of random games per row");
+  m_rows = read_grid(m_config.grid_file(), m_config);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<MatchemSweep::Row> MatchemSweep::read_grid(const std::string& filename, const MatchemConfig& config)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ifstream in(filename);
+  my_require(in.good(), "Could not open grid file: " + filename);
+
+  std::vector<int> set_sizes(1, MatchemConfig::SET_SIZE);
+  std::vector<bool> trackings(1, FULL_TRACKING);
+  std::vector<StrategyType> strategies(1, config.strategy());
+  std::vector<int> num_runs(1, config.num_runs());
+  std::vector<int> bandit_rollouts(1, config.bandit_rollouts());
+  std::vector<int> bandit_candidates(1, config.bandit_candidates());
+
+  std::string line;
+  while (std::getline(in, line)) {
+    line = trim(line.substr(0, line.find('#')));
+    if (line.empty()) {
+      continue;
+    }
+    my_require(line.find('=') != std::string::npos, "Bad line in grid file " + filename + ": " + line);
+    const std::string name = trim(line.substr(0, line.find('=')));
+
+    std::vector<std::string> values;
+    std::istringstream items(line.substr(line.find('=') + 1));
+    std::string item;
+    while (std::getline(items, item, ',')) {
+      values.push_back(trim(item));
+    }
+    my_require(!values.empty(), "No values for " + name + " in grid file: " + filename);
+
+    std::vector<int> ints;
+    if (name != "tracking" && name != "strategy") {
+      for (const std::string& value : values) {
+        my_require(std::atoi(value.c_str()) > 0, "Bad value '" + value + "' for " + name + " in grid file: " + filename);
+        ints.push_back(std::atoi(value.c_str()));
+      }
+    }
+
+    if (name == "set-size") {
+      set_sizes = ints;
+    }
+    else if (name == "num-runs") {
+      num_runs = ints;
+    }
+    else if (name == "bandit-rollouts") {
+      bandit_rollouts = ints;
+    }
+    else if (name == "bandit-candidates") {
+      bandit_candidates = ints;
+    }
+    else if (name == "tracking") {
+      trackings.clear();
+      for (const std::string& value : values) {
+        my_require(value == "full" || value == "lean", "Bad tracking '" + value + "' in grid file: " + filename);
+        trackings.push_back(value == "full");
+      }
+    }
+    else if (name == "strategy") {
+      strategies.clear();
+      for (const std::string& value : values) {
+        StrategyType strategy;
+        my_require(parse_strategy(value, strategy), "Unknown strategy '" + value + "' in grid file: " + filename);
+        strategies.push_back(strategy);
+      }
+    }
+    else {
+      my_require(false, "Unknown setting '" + name + "' in grid file: " + filename);
+    }
+  }
+
+  std::vector<Row> rows;
+  for (const int set_size : set_sizes) {
+    for (const bool full_tracking : trackings) {
+      for (const StrategyType strategy : strategies) {
+        for (const int runs : num_runs) {
+          // Other strategies do not look at the bandit settings
+          const size_t num_rollouts   = strategy == BANDIT ? bandit_rollouts.size() : 1;
+          const size_t num_candidates = strategy == BANDIT ? bandit_candidates.size() : 1;
+          for (size_t r = 0; r < num_rollouts; ++r) {
+            for (size_t c = 0; c < num_candidates; ++c) {
+              rows.push_back(Row{set_size, full_tracking, strategy, runs, bandit_rollouts[r], bandit_candidates[c]});
+            }
+          }
+        }
+      }
+    }
+  }
+  return rows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool MatchemSweep::playable(const Row& row)
+////////////////////////////////////////////////////////////////////////////////
+{
+  return row.set_size == MatchemConfig::SET_SIZE && row.full_tracking == FULL_TRACKING;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemConfig MatchemSweep::make_config(const Row& row) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  MatchemConfig config(m_config);
+  config.set_num_runs(row.num_runs);
+  config.set_strategy(row.strategy);
+  config.set_bandit_rollouts(row.bandit_rollouts);
+  config.set_bandit_candidates(row.bandit_candidates);
+  return config;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSweep::run()
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  play();
+
+  std::cout << std::setw(6) << "size" << std::setw(10) << "tracking" << std::setw(11) << "strategy" << std::setw(10)
+            << "runs" << std::setw(10) << "rollouts" << std::setw(7) << "cands" << std::setw(12) << "avg rounds"
+            << std::setw(11) << "+/- (95%)" << std::setw(6) << "p90" << std::setw(12) << "games/s" << std::endl;
+  for (const Result& result : m_results) {
+    const Row& row = result.row;
+    std::cout << std::setw(6) << row.set_size << std::setw(10) << tracking_name(row.full_tracking) << std::setw(11)
+              << strategy_name(row.strategy) << std::setw(10) << row.num_runs << std::setw(10)
+              << (row.strategy == BANDIT ? obj_to_str(row.bandit_rollouts) : std::string("-")) << std::setw(7)
+              << (row.strategy == BANDIT ? obj_to_str(row.bandit_candidates) : std::string("-"));
+    if (result.played) {
+      std::cout << std::setw(12) << result.rounds.mean() << std::setw(11) << result.rounds.ci95() << std::setw(6)
+                << result.rounds.percentile(0.9) << std::setw(12)
+                << (result.seconds > 0.0 ? result.rounds.count / result.seconds : 0.0) << std::endl;
+    }
+    else {
+      std::cout << "  needs a build with this set size and tracking" << std::endl;
+    }
+  }
+
+  if (!m_config.results_file().empty()) {
+    write_csv(m_config.results_file(), m_results);
+    std::cout << "Wrote sweep results to " << m_config.results_file() << std::endl;
+  }
+
+  const auto finish = std::chrono::steady_clock::now();
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+  std::cout << "Sweep took " << 1e-6*duration.count() << " seconds" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSweep::play()
+////////////////////////////////////////////////////////////////////////////////
+{
+  m_results.clear();
+
+  // Size the one Matchem for the biggest row: the most games (which sets how
+  // many teams run at once) and rollout workspaces if any row runs bandit
+  std::unique_ptr<Matchem> matchem;
+  const Row* pool_row = nullptr;
+  int max_runs = 0;
+  for (const Row& row : m_rows) {
+    if (playable(row)) {
+      if (pool_row == nullptr || (row.strategy == BANDIT && pool_row->strategy != BANDIT)) {
+        pool_row = &row;
+      }
+      max_runs = std::max(max_runs, row.num_runs);
+    }
+  }
+  if (pool_row != nullptr) {
+    MatchemConfig pool_config = make_config(*pool_row);
+    pool_config.set_num_runs(max_runs);
+    matchem.reset(new Matchem(pool_config));
+  }
+
+  for (const Row& row : m_rows) {
+    Result result{row, false, SimStats(), 0.0};
+    if (playable(row)) {
+      matchem->reconfigure(make_config(row));
+      const auto start = std::chrono::steady_clock::now();
+      result.rounds = matchem->play_games().rounds;
+      const auto finish = std::chrono::steady_clock::now();
+      result.seconds = 1e-6*std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+      result.played = true;
+    }
+    m_results.push_back(result);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSweep::write_csv(std::ostream& out, const std::vector<Result>& results)
+////////////////////////////////////////////////////////////////////////////////
+{
+  out << "set_size,tracking,strategy,num_runs,bandit_rollouts,bandit_candidates,played,avg_rounds,ci95,stddev,p50,p90,"
+         "seconds,games_per_sec\n";
+  for (const Result& result : results) {
+    const Row& row = result.row;
+    out << row.set_size << "," << tracking_name(row.full_tracking) << "," << strategy_name(row.strategy) << ","
+        << row.num_runs << "," << row.bandit_rollouts << "," << row.bandit_candidates << "," << result.played;
+    if (result.played) {
+      out << "," << result.rounds.mean() << "," << result.rounds.ci95() << "," << result.rounds.stddev() << ","
+          << result.rounds.percentile(0.5) << "," << result.rounds.percentile(0.9) << "," << result.seconds << ","
+          << (result.seconds > 0.0 ? result.rounds.count / result.seconds : 0.0) << "\n";
+    }
+    else {
+      out << ",,,,,,,\n";
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemSweep::write_csv(const std::string& filename, const std::vector<Result>& results)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ofstream out(filename);
+  my_require(out.good(), "Could not write results file: " + filename);
+  write_csv(out, results);
+}
+
+}
@@ -0,0 +1,121 @@
+#ifndef MATCHEM_SWEEP_HPP
+#define MATCHEM_SWEEP_HPP
+
+#include "matchem_config.hpp"
+#include "matchem_stats.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace matchem {
+
+namespace tests {
+struct UnitWrap;
+}
+
+/**
+ * Runs a whole grid of configurations in one process. The grid file has one
+ * line per setting, a name and the values to try:
+ *
+ *   # comment
+ *   strategy = heuristic, bandit
+ *   num-runs = 1000, 10000
+ *   bandit-rollouts = 16, 64
+ *
+ * Settings are set-size, tracking (full or lean, with or without
+ * EXTRA_TRACKING), strategy, num-runs, bandit-rollouts and bandit-candidates;
+ * the ones left out keep the value from the command line. Every combination
+ * is a row, the bandit settings only multiply bandit rows. Set size and tracking
+ * are compiled in, so rows that ask for another build are listed but not
+ * played.
+ *
+ * All rows share one Matchem, built for the biggest of them and reconfigured
+ * from row to row, so its workspaces are allocated once.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class MatchemSweep
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  struct Row
+  {
+    int set_size;
+    bool full_tracking;
+    StrategyType strategy;
+    int num_runs;
+    int bandit_rollouts;
+    int bandit_candidates;
+  };
+
+  struct Result
+  {
+    Row row;
+    bool played;
+    SimStats rounds;
+    double seconds;
+  };
+
+  MatchemSweep(const MatchemConfig& config);
+
+  /**
+   * run - Play every row this build can and report them all
+   */
+  void run();
+
+  /**
+   * read_grid - The rows of a grid file, defaults from config
+   */
+  static std::vector<Row> read_grid(const std::string& filename, const MatchemConfig& config);
+
+  // Can this build play the row?
+  static bool playable(const Row& row);
+
+  /**
+   * write_csv - One line per row, played or not
+   */
+  static void write_csv(std::ostream& out, const std::vector<Result>& results);
+  static void write_csv(const std::string& filename, const std::vector<Result>& results);
+
+  const std::vector<Result>& results() const { return m_results; }
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// FORBIDDEN METHODS /////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemSweep(const MatchemSweep&) = delete;
+  MatchemSweep& operator=(const MatchemSweep&) = delete;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// INTERNAL METHODS //////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  // The config of a row, the command line config for everything else
+  MatchemConfig make_config(const Row& row) const;
+
+  void play();
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// DATA MEMBERS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemConfig m_config;
+
+  std::vector<Row> m_rows;
+
+  std::vector<Result> m_results;
+
+  //////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////// FRIENDS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  friend struct matchem::tests::UnitWrap;
+};
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include "matchem_telemetry.hpp"
+#include "matchem_exception.hpp"
+
+#include <fstream>
+#include <iomanip>
+
+namespace matchem {
+
+////////////////////////////////////////////////////////////////////////////////
+const char* Telemetry::name(const Counter counter)
+////////////////////////////////////////////////////////////////////////////////
+{
+  switch (counter) {
+  case GAMES:              return "games";
+  case TRUTH_QUERIES:      return "truth_queries";
+  case FACTS_INFERRED:     return "facts_inferred";
+  case MAX_INFER_DEPTH:    return "max_infer_depth";
+  case SET_STATE_CALLS:    return "set_state_calls";
+  case ODDS_CELLS:         return "odds_cells";
+  case GUESS_ROWS:         return "guess_rows";
+  case GUESSES:            return "guesses";
+  case DETERMINED_GUESSES: return "determined_guesses";
+  case NUM_COUNTERS:       break;
+  }
+  return "unknown";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Telemetry::print(std::ostream& out) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  const uint64_t num_games = counters[GAMES];
+  out << std::setw(20) << "counter" << std::setw(14) << "total" << std::setw(12) << "per game" << "\n";
+  for (int c = 0; c < NUM_COUNTERS; ++c) {
+    const Counter counter = static_cast<Counter>(c);
+    // A maximum is not a sum, per game makes no sense for it
+    out << std::setw(20) << name(counter) << std::setw(14) << counters[c] << std::setw(12);
+    if (counter == MAX_INFER_DEPTH || num_games == 0) {
+      out << "-";
+    }
+    else {
+      out << static_cast<double>(counters[c]) / num_games;
+    }
+    out << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Telemetry::write_json(std::ostream& out) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  out << "{";
+  for (int c = 0; c < NUM_COUNTERS; ++c) {
+    out << (c == 0 ? "\n" : ",\n") << "  \"" << name(static_cast<Counter>(c)) << "\": " << counters[c];
+  }
+  out << "\n}\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Telemetry::write_json(const std::string& filename) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ofstream out(filename);
+  my_require(out.good(), "Could not write telemetry file: " + filename);
+  write_json(out);
+}
+
+}
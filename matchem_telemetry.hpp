@@ -0,0 +1,94 @@
+#ifndef MATCHEM_TELEMETRY_HPP
+#define MATCHEM_TELEMETRY_HPP
+
+#include "matchem_common.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace matchem {
+
+/**
+ * Counts of the work done inside games, to explain why one build or strategy
+ * is faster than another. Each workspace has its own, so the counters need no
+ * atomics; they are summed with merge once the games are done. Matchem only
+ * touches them in builds configured with -DTELEMETRY=ON, see matchem.hpp.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct Telemetry
+////////////////////////////////////////////////////////////////////////////////
+{
+  enum Counter {
+    GAMES,              // games played
+    TRUTH_QUERIES,      // truth queries asked
+    FACTS_INFERRED,     // matches deduced by process_ask_result without asking
+    MAX_INFER_DEPTH,    // deepest chain of deductions from a single answer
+    SET_STATE_CALLS,    // known info updates
+    ODDS_CELLS,         // odds entries written
+    GUESS_ROWS,         // side1s whose guess pick was computed, not reused
+    GUESSES,            // guesses made
+    DETERMINED_GUESSES, // guesses made when the known info already fixed every pair
+    NUM_COUNTERS
+  };
+
+  static const char* name(const Counter counter);
+
+  uint64_t counters[NUM_COUNTERS];
+
+  // How many deductions deep process_ask_result is right now
+  int infer_depth;
+
+  KOKKOS_INLINE_FUNCTION
+  Telemetry() { reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    for (int c = 0; c < NUM_COUNTERS; ++c) {
+      counters[c] = 0;
+    }
+    infer_depth = 0;
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void add(const Counter counter, const uint64_t n) { counters[counter] += n; }
+
+  KOKKOS_INLINE_FUNCTION
+  void enter_inference()
+  {
+    ++counters[FACTS_INFERRED];
+    ++infer_depth;
+    if (static_cast<uint64_t>(infer_depth) > counters[MAX_INFER_DEPTH]) {
+      counters[MAX_INFER_DEPTH] = infer_depth;
+    }
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void leave_inference() { --infer_depth; }
+
+  KOKKOS_INLINE_FUNCTION
+  void merge(const Telemetry& other)
+  {
+    for (int c = 0; c < NUM_COUNTERS; ++c) {
+      if (c == MAX_INFER_DEPTH) {
+        counters[c] = other.counters[c] > counters[c] ? other.counters[c] : counters[c];
+      }
+      else {
+        counters[c] += other.counters[c];
+      }
+    }
+  }
+
+  // One line per counter, totals and per game
+  void print(std::ostream& out) const;
+
+  // The totals as a JSON object
+  void write_json(std::ostream& out) const;
+  void write_json(const std::string& filename) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,241 @@
+#include "matchem_tournament.hpp"
+#include "matchem_exception.hpp"
+#include "matchem_kokkos.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <numeric>
+
+namespace matchem {
+
+constexpr int TournamentStats::MAX_PLAYERS;
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemTournament::MatchemTournament(const MatchemConfig& config) :
+////////////////////////////////////////////////////////////////////////////////
+  m_config(config),
+  m_seed(std::rand()),
+  m_players(),
+  m_names()
+{
+  std::vector<MatchemConfig> player_configs;
+  for (const StrategyType strategy : m_config.tournament_strategies()) {
+    player_configs.push_back(m_config);
+    player_configs.back().set_strategy(strategy);
+    m_names.push_back(strategy_name(strategy));
+  }
+  add_players(player_configs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemTournament::MatchemTournament(
+////////////////////////////////////////////////////////////////////////////////
+  const MatchemConfig& config,
+  const std::vector<MatchemConfig>& player_configs,
+  const std::vector<std::string>& names) :
+  m_config(config),
+  m_seed(std::rand()),
+  m_players(),
+  m_names(names)
+{
+  my_require(names.size() == player_configs.size(), "Every tournament player needs a name");
+  add_players(player_configs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemTournament::add_players(const std::vector<MatchemConfig>& player_configs)
+////////////////////////////////////////////////////////////////////////////////
+{
+  my_require(player_configs.size() >= 2 && player_configs.size() <= TournamentStats::MAX_PLAYERS,
+             "A tournament needs between 2 and " + obj_to_str(static_cast<int>(TournamentStats::MAX_PLAYERS)) +
+             " players");
+  my_require(m_config.curves_file().empty() && m_config.decision_budgets_us().empty(),
+             "Tournaments do not track curves or decision budgets");
+
+  for (const MatchemConfig& player_config : player_configs) {
+    m_players.emplace_back(new Matchem(player_config));
+    // Every player has to hand out the same workspace slots to the same teams
+    my_require(m_players.back()->m_tu.get_num_concurrent_teams() == m_players[0]->m_tu.get_num_concurrent_teams() &&
+               m_players.back()->m_policy.team_size() == m_players[0]->m_policy.team_size(),
+               "Tournament players disagree on the number of concurrent teams");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemTournament::run()
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const TournamentStats stats =
+    m_config.target_ci() > 0.0 ? play_to_target() : play_games(0, Matchem::get_num_games(m_config));
+  report(stats);
+
+  const auto finish = std::chrono::steady_clock::now();
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+  std::cout << "Tournament took " << 1e-6*duration.count() << " seconds" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TournamentStats MatchemTournament::play_games(const int first_game, const int num_games)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::vector<int> entrants(num_players());
+  std::iota(entrants.begin(), entrants.end(), 0);
+  return play_games(first_game, num_games, entrants);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TournamentStats MatchemTournament::play_games(const int first_game, const int num_games, const std::vector<int>& entrants)
+////////////////////////////////////////////////////////////////////////////////
+{
+  constexpr int N = Matchem::SIZE;
+  const int num_entrants = entrants.size();
+  const int64_t num_states = factorial(N);
+  const uint64_t seed = m_seed;
+  const double ns_per_tick = 1e3 / cycles_per_usec();
+
+  int players[TournamentStats::MAX_PLAYERS];
+  Matchem* matchems[TournamentStats::MAX_PLAYERS];
+  bool fused[TournamentStats::MAX_PLAYERS];
+  for (int e = 0; e < num_entrants; ++e) {
+    players[e]  = entrants[e];
+    matchems[e] = m_players[entrants[e]].get();
+    fused[e]    = matchems[e]->can_fuse();
+  }
+  Matchem* slots = m_players[0].get();
+  int next_game = 0;
+  int* next = &next_game;
+
+  // One team per workspace slot, never more teams than games. Games differ a
+  // lot in length, so workers take the next game as they finish one.
+  const int workers = std::min(slots->m_tu.get_num_concurrent_teams(), num_games);
+  const auto policy = ExeSpaceUtils<>::get_default_team_policy(workers, slots->m_policy.team_size());
+  TournamentStats stats;
+  Kokkos::parallel_reduce("MatchemTournament::play_games", policy, KOKKOS_LAMBDA(const Matchem::MemberType& team, TournamentStats& local) {
+    const int slot = slots->m_tu.get_workspace_idx(team);
+    const int ws_idx = slots->get_team_ws(team, slot);
+
+    // The other threads of the team play copies of the same games, which
+    // must not be counted again
+    TournamentStats copies;
+    TournamentStats& mine = team.team_rank() == 0 ? local : copies;
+
+    for (int split_game = Matchem::take_games(team, next, 1); split_game < num_games;
+         split_game = Matchem::take_games(team, next, 1)) {
+      const int game = first_game + split_game;
+
+      // The hidden state only depends on the game, so every player gets the same one
+      Rng rng(hash_combine(seed, game));
+      const int hidden = static_cast<int>(rng.below(num_states));
+
+      int rounds[TournamentStats::MAX_PLAYERS];
+      for (int e = 0; e < num_entrants; ++e) {
+        const uint64_t start = read_cycles();
+        matchems[e]->init_indv_exact(ws_idx, hidden);
+        rounds[e] = matchems[e]->play_indv(ws_idx, fused[e], nullptr, &team);
+        mine.total_ns[players[e]] += static_cast<uint64_t>((read_cycles() - start) * ns_per_tick);
+        mine.rounds[players[e]].add(rounds[e]);
+      }
+      for (int a = 0; a < num_entrants; ++a) {
+        for (int b = a + 1; b < num_entrants; ++b) {
+          // Entrants may come in any order, diffs are kept lower index first
+          if (players[a] < players[b]) {
+            mine.diffs[players[a]][players[b]].add(rounds[a], rounds[b]);
+          }
+          else {
+            mine.diffs[players[b]][players[a]].add(rounds[b], rounds[a]);
+          }
+        }
+      }
+    }
+
+    slots->m_tu.release_workspace_idx(team, slot);
+  }, StatsReducer<TournamentStats>(stats));
+
+  return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TournamentStats MatchemTournament::play_to_target()
+////////////////////////////////////////////////////////////////////////////////
+{
+  const double target = m_config.target_ci();
+  const int max_games = Matchem::get_num_games(m_config);
+  const int min_batch = std::min(max_games, std::max(static_cast<int>(Matchem::MIN_CI_BATCH),
+                                                     m_players[0]->m_tu.get_num_concurrent_teams()));
+
+  // Same plan as Matchem::play_to_target, sized for the noisiest difference
+  TournamentStats stats;
+  int batch = min_batch;
+  while (true) {
+    stats.merge(play_games(stats.rounds[0].count, batch));
+
+    const int64_t count = stats.rounds[0].count;
+    const double widest = widest_ci(stats);
+    std::cout << "After " << count << " games: widest difference CI +/- " << widest << std::endl;
+    if (widest <= target || count >= max_games) {
+      break;
+    }
+
+    double needed = 0.0;
+    for (int i = 0; i < num_players(); ++i) {
+      for (int j = i + 1; j < num_players(); ++j) {
+        needed = std::max(needed, std::pow(1.96 * stats.diffs[i][j].stddev() / target, 2));
+      }
+    }
+    const int64_t remaining = max_games - count;
+    batch = static_cast<int>(std::min<double>(remaining, std::max<double>(min_batch, needed - count)));
+  }
+
+  if (widest_ci(stats) > target) {
+    std::cout << "Stopped at the cap of " << max_games << " games before reaching the target CI of +/- " << target
+              << std::endl;
+  }
+  return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double MatchemTournament::widest_ci(const TournamentStats& stats) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  double widest = 0.0;
+  for (int i = 0; i < num_players(); ++i) {
+    for (int j = i + 1; j < num_players(); ++j) {
+      widest = std::max(widest, stats.diffs[i][j].ci95());
+    }
+  }
+  return widest;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemTournament::report(const TournamentStats& stats) const
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::cout << std::setw(12) << "player" << std::setw(12) << "avg rounds" << std::setw(12) << "+/- (95%)"
+            << std::setw(10) << "stddev" << std::setw(12) << "us/game" << std::endl;
+  for (int i = 0; i < num_players(); ++i) {
+    const SimStats& rounds = stats.rounds[i];
+    std::cout << std::setw(12) << m_names[i] << std::setw(12) << rounds.mean() << std::setw(12) << rounds.ci95()
+              << std::setw(10) << rounds.stddev() << std::setw(12)
+              << (rounds.count > 0 ? 1e-3 * stats.total_ns[i] / rounds.count : 0.0) << std::endl;
+  }
+
+  // Paired over the same games, so these CIs leave out whatever the
+  // players agree on about how hard each game was
+  std::cout << "Paired differences (first minus second, in rounds):" << std::endl;
+  for (int i = 0; i < num_players(); ++i) {
+    for (int j = i + 1; j < num_players(); ++j) {
+      const PairedStats& diff = stats.diffs[i][j];
+      std::cout << "  " << m_names[i] << " - " << m_names[j] << ": "
+                << diff.mean() << " +/- " << diff.ci95() << ", faster in " << diff.wins << ", slower in "
+                << diff.losses << ", tied in " << diff.count - diff.wins - diff.losses << " of " << diff.count
+                << " games" << std::endl;
+    }
+  }
+}
+
+}
@@ -0,0 +1,146 @@
+#ifndef MATCHEM_TOURNAMENT_HPP
+#define MATCHEM_TOURNAMENT_HPP
+
+#include "matchem.hpp"
+#include "matchem_config.hpp"
+#include "matchem_stats.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace matchem {
+
+/**
+ * Rounds and time of every player in a tournament, and the paired difference
+ * of every two of them (only [i][j] with i < j are used)
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+struct TournamentStats
+////////////////////////////////////////////////////////////////////////////////
+{
+  static constexpr int MAX_PLAYERS = 16;
+
+  SimStats rounds[MAX_PLAYERS];
+  PairedStats diffs[MAX_PLAYERS][MAX_PLAYERS];
+  uint64_t total_ns[MAX_PLAYERS];
+
+  KOKKOS_INLINE_FUNCTION
+  TournamentStats() { reset(); }
+
+  KOKKOS_INLINE_FUNCTION
+  void reset()
+  {
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+      rounds[i].reset();
+      total_ns[i] = 0;
+      for (int j = 0; j < MAX_PLAYERS; ++j) {
+        diffs[i][j].reset();
+      }
+    }
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void merge(const TournamentStats& other)
+  {
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+      rounds[i].merge(other.rounds[i]);
+      total_ns[i] += other.total_ns[i];
+      for (int j = 0; j < MAX_PLAYERS; ++j) {
+        diffs[i][j].merge(other.diffs[i][j]);
+      }
+    }
+  }
+};
+
+/**
+ * Compares players with common random numbers: the hidden state of every
+ * game is drawn once from the game index and every player plays it, one
+ * after the other in the same workspace slot, so the differences between
+ * players are measured game by game instead of between independent runs.
+ * A player is a strategy and its settings. Each gets its own Matchem, since
+ * they differ in the state they keep (bandit rollout workspaces, policy
+ * tables, models), and keeps it from one batch of games to the next.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class MatchemTournament
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  // One player per strategy of the config
+  MatchemTournament(const MatchemConfig& config);
+
+  // Players with any settings, named for the report
+  MatchemTournament(const MatchemConfig& config,
+                    const std::vector<MatchemConfig>& player_configs,
+                    const std::vector<std::string>& names);
+
+  /**
+   * run - Play the games, or enough of them for the target CI of every
+   *       difference, and report how the players compare
+   */
+  void run();
+
+  /**
+   * play_games - Play games first_game to first_game + num_games - 1 with
+   *              every player, or only with the entrants (player indices)
+   */
+  TournamentStats play_games(const int first_game, const int num_games);
+  TournamentStats play_games(const int first_game, const int num_games, const std::vector<int>& entrants);
+
+  /**
+   * play_to_target - Play batches of games until every paired difference is
+   *                  known to within the target CI or the cap is reached
+   */
+  TournamentStats play_to_target();
+
+  int num_players() const { return static_cast<int>(m_players.size()); }
+
+  const std::string& name(const int player) const { return m_names[player]; }
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// FORBIDDEN METHODS /////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemTournament(const MatchemTournament&) = delete;
+  MatchemTournament& operator=(const MatchemTournament&) = delete;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// INTERNAL METHODS //////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  void add_players(const std::vector<MatchemConfig>& player_configs);
+
+  // Widest CI of any paired difference
+  double widest_ci(const TournamentStats& stats) const;
+
+  void report(const TournamentStats& stats) const;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// DATA MEMBERS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemConfig m_config;
+
+  // Hidden states are a function of this and the game index only
+  uint64_t m_seed;
+
+  std::vector<std::unique_ptr<Matchem> > m_players;
+  std::vector<std::string> m_names;
+
+  //////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////// FRIENDS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  friend struct matchem::tests::UnitWrap;
+};
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef MATCHEM_TREE_HPP
+#define MATCHEM_TREE_HPP
+
+#include "matchem_common.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace matchem {
+
+/**
+ * The decision tree of a deterministic strategy. Levels alternate between
+ * truth queries and guesses, starting with the round 0 query. A query node's
+ * children are indexed by the answer (0 or 1), a guess node's by the score
+ * (a perfect score ends the game, so it has no child).
+ *
+ * Nodes live in one flat arena and are only ever added. A game that walks off
+ * the tree computes the missing decision and races to hang it under its parent
+ * with a compare-and-swap; losers just follow the winner's node. Since the
+ * strategy is deterministic both nodes hold the same decision.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+template <int N>
+class DecisionTree
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  static constexpr int32_t NONE = -1;
+
+  struct Node
+  {
+    int8_t decision[N]; // query is decision[0..1], a guess uses all N
+    std::atomic<int32_t> children[N];
+  };
+
+  DecisionTree() : m_nodes(), m_capacity(0), m_next(0) {}
+
+  /**
+   * init - Allocate room for capacity nodes. A capacity of zero leaves the
+   *        tree disabled.
+   */
+  void init(const size_t capacity)
+  {
+    m_nodes.reset(capacity > 0 ? new Node[capacity] : nullptr);
+    m_capacity = capacity;
+    m_next = 0;
+  }
+
+  /**
+   * clear - Drop every node, keeping the memory
+   */
+  void clear() { m_next = 0; }
+
+  bool enabled() const { return m_capacity > 0; }
+
+  // The tree has no root until the round 0 query is added
+  int32_t root() const { return m_next.load(std::memory_order_acquire) > 0 ? 0 : NONE; }
+
+  const int8_t* decision(const int32_t node) const { return m_nodes[node].decision; }
+
+  int32_t child(const int32_t node, const int outcome) const
+  { return m_nodes[node].children[outcome].load(std::memory_order_acquire); }
+
+  /**
+   * add_root - Add the root. Must be called before any game walks the tree.
+   */
+  void add_root(const int* decision, const int size)
+  {
+    const int32_t node = allocate(decision, size);
+    assert(node == 0);
+    (void)node;
+  }
+
+  /**
+   * insert_child - Hang a node with this decision under parent unless another
+   *                thread got there first. Returns the child that ended up
+   *                there, or NONE if the arena is full.
+   */
+  int32_t insert_child(const int32_t parent, const int outcome, const int* decision, const int size)
+  {
+    int32_t existing = child(parent, outcome);
+    if (existing != NONE) {
+      return existing;
+    }
+
+    const int32_t node = allocate(decision, size);
+    if (node == NONE) {
+      return NONE;
+    }
+
+    if (m_nodes[parent].children[outcome].compare_exchange_strong(existing, node, std::memory_order_acq_rel)) {
+      return node;
+    }
+    return existing; // our node is wasted, that is rare and harmless
+  }
+
+  size_t num_nodes() const
+  {
+    const size_t next = m_next.load(std::memory_order_relaxed);
+    return next < m_capacity ? next : m_capacity;
+  }
+
+  size_t capacity() const { return m_capacity; }
+
+ private:
+
+  int32_t allocate(const int* decision, const int size)
+  {
+    const size_t node = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (node >= m_capacity) {
+      return NONE;
+    }
+
+    Node& result = m_nodes[node];
+    for (int k = 0; k < N; ++k) {
+      result.decision[k] = k < size ? decision[k] : -1;
+      result.children[k].store(NONE, std::memory_order_relaxed);
+    }
+    // Publishing the node (root() or the parent's CAS) releases these writes
+    return static_cast<int32_t>(node);
+  }
+
+  std::unique_ptr<Node[]> m_nodes;
+  size_t m_capacity;
+  std::atomic<size_t> m_next;
+};
+
+}
+
+#endif
@@ -0,0 +1,208 @@
+#include "matchem_tuner.hpp"
+#include "matchem.hpp"
+#include "matchem_exception.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+namespace matchem {
+
+namespace {
+
+// What sample_settings picks from
+const int ROLLOUTS_GRID[]      = {8, 16, 32, 64, 128, 256};
+const int CANDIDATES_GRID[]    = {2, 4, 8, 16};
+const double EXPLORATION_GRID[] = {0.5, 1.0, 2.0, 4.0};
+
+constexpr int NUM_ROLLOUTS    = sizeof(ROLLOUTS_GRID) / sizeof(ROLLOUTS_GRID[0]);
+constexpr int NUM_CANDIDATES  = sizeof(CANDIDATES_GRID) / sizeof(CANDIDATES_GRID[0]);
+constexpr int NUM_EXPLORATION = sizeof(EXPLORATION_GRID) / sizeof(EXPLORATION_GRID[0]);
+
+double us_per_game(const TournamentStats& stats, const int player)
+{
+  const int64_t count = stats.rounds[player].count;
+  return count > 0 ? 1e-3 * stats.total_ns[player] / count : 0.0;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemTuner::MatchemTuner(const MatchemConfig& config) :
+////////////////////////////////////////////////////////////////////////////////
+  m_config(config),
+  m_settings(sample_settings(config)),
+  m_tournament(),
+  m_stats()
+{
+  init_tournament();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+MatchemTuner::MatchemTuner(const MatchemConfig& config, const std::vector<Setting>& settings) :
+////////////////////////////////////////////////////////////////////////////////
+  m_config(config),
+  m_settings(settings),
+  m_tournament(),
+  m_stats()
+{
+  init_tournament();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<MatchemTuner::Setting> MatchemTuner::sample_settings(const MatchemConfig& config)
+////////////////////////////////////////////////////////////////////////////////
+{
+  const int num_grid = NUM_ROLLOUTS * NUM_CANDIDATES * NUM_EXPLORATION;
+  my_require(config.tune_candidates() >= 2 && config.tune_candidates() <= std::min(num_grid + 1, static_cast<int>(TournamentStats::MAX_PLAYERS)),
+             "Can not tune " + obj_to_str(config.tune_candidates()) + " candidates");
+
+  // Start from where we are, so the report says how much tuning bought
+  std::vector<Setting> settings(1, Setting{config.bandit_rollouts(), config.bandit_candidates(), config.bandit_exploration()});
+
+  // The first few of a random order of the grid, skipping the start
+  std::vector<int> order(num_grid);
+  for (int g = 0; g < num_grid; ++g) {
+    order[g] = g;
+  }
+  Rng rng(std::rand());
+  for (int g = num_grid - 1; g > 0; --g) {
+    std::swap(order[g], order[rng.below(g + 1)]);
+  }
+  for (int g = 0; g < num_grid && static_cast<int>(settings.size()) < config.tune_candidates(); ++g) {
+    const Setting setting{ROLLOUTS_GRID[order[g] % NUM_ROLLOUTS],
+                          CANDIDATES_GRID[order[g] / NUM_ROLLOUTS % NUM_CANDIDATES],
+                          EXPLORATION_GRID[order[g] / (NUM_ROLLOUTS * NUM_CANDIDATES)]};
+    const Setting& start = settings[0];
+    if (setting.rollouts != start.rollouts || setting.candidates != start.candidates ||
+        setting.exploration < start.exploration || setting.exploration > start.exploration) {
+      settings.push_back(setting);
+    }
+  }
+  return settings;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemTuner::init_tournament()
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::vector<MatchemConfig> player_configs;
+  std::vector<std::string> names;
+  for (size_t s = 0; s < m_settings.size(); ++s) {
+    player_configs.push_back(m_config);
+    player_configs.back().set_strategy(BANDIT);
+    player_configs.back().set_bandit_rollouts(m_settings[s].rollouts);
+    player_configs.back().set_bandit_candidates(m_settings[s].candidates);
+    player_configs.back().set_bandit_exploration(m_settings[s].exploration);
+    names.push_back("#" + obj_to_str(s));
+  }
+  m_tournament.reset(new MatchemTournament(m_config, player_configs, names));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MatchemTuner::run()
+////////////////////////////////////////////////////////////////////////////////
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const int best = tune();
+
+  std::vector<int> everyone(m_settings.size());
+  for (size_t s = 0; s < m_settings.size(); ++s) {
+    everyone[s] = s;
+  }
+
+  std::cout << "Quality versus cost frontier:" << std::endl;
+  std::cout << std::setw(6) << "#" << std::setw(12) << "avg rounds" << std::setw(12) << "+/- (95%)" << std::setw(12)
+            << "us/game" << std::setw(10) << "games" << "  setting" << std::endl;
+  for (const int s : frontier(m_stats, everyone)) {
+    std::cout << std::setw(6) << s << std::setw(12) << m_stats.rounds[s].mean() << std::setw(12)
+              << m_stats.rounds[s].ci95() << std::setw(12) << us_per_game(m_stats, s) << std::setw(10)
+              << m_stats.rounds[s].count << "  " << describe(m_settings[s]) << std::endl;
+  }
+
+  std::cout << "Best setting: " << describe(m_settings[best]) << std::endl;
+  if (best != 0) {
+    // Paired over the games the start played, which the best played too
+    const PairedStats& diff = m_stats.diffs[0][best];
+    std::cout << "Improvement over " << describe(m_settings[0]) << ": " << diff.mean() << " +/- " << diff.ci95()
+              << " rounds over " << diff.count << " games" << std::endl;
+  }
+
+  const auto finish = std::chrono::steady_clock::now();
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+  std::cout << "Tuning took " << 1e-6*duration.count() << " seconds" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int MatchemTuner::tune()
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::vector<int> survivors(m_settings.size());
+  for (size_t s = 0; s < m_settings.size(); ++s) {
+    survivors[s] = s;
+  }
+
+  // Every rung plays new games, the same ones for every survivor, and
+  // survivors are ranked on all the games they have played
+  int first_game = 0;
+  int batch = m_config.num_runs();
+  for (int rung = 0; survivors.size() > 1; ++rung) {
+    m_stats.merge(m_tournament->play_games(first_game, batch, survivors));
+    first_game += batch;
+    survivors = halve(m_stats, survivors);
+
+    std::cout << "Rung " << rung << ": " << first_game << " games, leader #" << survivors[0] << " at "
+              << m_stats.rounds[survivors[0]].mean() << " rounds, " << survivors.size() << " settings left"
+              << std::endl;
+    batch *= 2;
+  }
+  return survivors[0];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<int> MatchemTuner::halve(const TournamentStats& stats, const std::vector<int>& survivors)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::vector<int> ranked(survivors);
+  std::stable_sort(ranked.begin(), ranked.end(), [&](const int a, const int b) {
+    const double mean_a = stats.rounds[a].mean(), mean_b = stats.rounds[b].mean();
+    return mean_a < mean_b || (!(mean_b < mean_a) && us_per_game(stats, a) < us_per_game(stats, b));
+  });
+  ranked.resize((ranked.size() + 1) / 2);
+  return ranked;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector<int> MatchemTuner::frontier(const TournamentStats& stats, const std::vector<int>& players)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::vector<int> by_cost(players);
+  std::stable_sort(by_cost.begin(), by_cost.end(), [&](const int a, const int b) {
+    return us_per_game(stats, a) < us_per_game(stats, b);
+  });
+
+  // Walking up in cost, a player is on the frontier if it takes fewer rounds
+  // than everything cheaper
+  std::vector<int> result;
+  for (const int p : by_cost) {
+    if (result.empty() || stats.rounds[p].mean() < stats.rounds[result.back()].mean()) {
+      result.push_back(p);
+    }
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string MatchemTuner::describe(const Setting& setting)
+////////////////////////////////////////////////////////////////////////////////
+{
+  std::ostringstream out;
+  out << "--strategy=bandit --bandit-rollouts=" << setting.rollouts << " --bandit-candidates=" << setting.candidates
+      << " --bandit-exploration=" << setting.exploration;
+  return out.str();
+}
+
+}
@@ -0,0 +1,115 @@
+#ifndef MATCHEM_TUNER_HPP
+#define MATCHEM_TUNER_HPP
+
+#include "matchem_config.hpp"
+#include "matchem_tournament.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace matchem {
+
+namespace tests {
+struct UnitWrap;
+}
+
+/**
+ * Searches the settings of the bandit strategy (rollouts, candidates and
+ * exploration) for the one that finishes games in the fewest rounds, by
+ * successive halving: every setting plays a batch of games, the worse half is
+ * dropped, the rest play twice as many new games, and so on until one is
+ * left. All settings are players of one tournament, so every rung plays the
+ * same hidden states for everybody and each setting keeps its workspaces from
+ * one rung to the next.
+ *
+ * Settings that were dropped early have fewer games behind them, so the
+ * quality-versus-cost frontier is only as sharp as the rung they reached.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+class MatchemTuner
+////////////////////////////////////////////////////////////////////////////////
+{
+ public:
+
+  struct Setting
+  {
+    int rollouts;
+    int candidates;
+    double exploration;
+  };
+
+  // The config's own setting plus config.tune_candidates() - 1 others
+  // sampled from a grid
+  MatchemTuner(const MatchemConfig& config);
+
+  MatchemTuner(const MatchemConfig& config, const std::vector<Setting>& settings);
+
+  /**
+   * run - Tune, then report the best setting and the frontier
+   */
+  void run();
+
+  /**
+   * tune - Run successive halving, returns the index of the best setting
+   */
+  int tune();
+
+  /**
+   * halve - The better half (rounded up) of the survivors, best first. Fewer
+   *         rounds wins, less time per game breaks ties.
+   */
+  static std::vector<int> halve(const TournamentStats& stats, const std::vector<int>& survivors);
+
+  /**
+   * frontier - The players no other player beats on both rounds and time per
+   *            game, cheapest first
+   */
+  static std::vector<int> frontier(const TournamentStats& stats, const std::vector<int>& players);
+
+  const std::vector<Setting>& settings() const { return m_settings; }
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// FORBIDDEN METHODS /////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemTuner(const MatchemTuner&) = delete;
+  MatchemTuner& operator=(const MatchemTuner&) = delete;
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// INTERNAL METHODS //////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  static std::vector<Setting> sample_settings(const MatchemConfig& config);
+
+  void init_tournament();
+
+  // The command line options for a setting
+  static std::string describe(const Setting& setting);
+
+  //////////////////////////////////////////////////////////////////////////////
+  ////////////////////////// DATA MEMBERS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  MatchemConfig m_config;
+
+  std::vector<Setting> m_settings;
+
+  std::unique_ptr<MatchemTournament> m_tournament;
+
+  // Every game of every rung so far
+  TournamentStats m_stats;
+
+  //////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////// FRIENDS //////////////////////////////////////
+  //////////////////////////////////////////////////////////////////////////////
+
+  friend struct matchem::tests::UnitWrap;
+};
+
+}
+
+#endif
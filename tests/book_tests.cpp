@@ -0,0 +1,125 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_book.hpp"
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::BookTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_round_trip()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const std::string filename = "book_tests_round_trip.book";
+    constexpr int size = 6;
+    constexpr int num_entries = 3000; // enough to make the table grow
+
+    {
+      OpeningBook book;
+      book.reset(size, 7, 2);
+      for (int n = 0; n < num_entries; ++n) {
+        book.add_query(hash_combine(HISTORY_ROOT, n), n % size, (n + 1) % size);
+        int guess[size];
+        for (int i = 0; i < size; ++i) {
+          guess[i] = (i + n) % size;
+        }
+        book.add_guess(hash_combine(HISTORY_ROOT, n), guess);
+      }
+      REQUIRE(book.num_entries() == 2*num_entries);
+      book.save(filename);
+    }
+
+    OpeningBook book;
+    book.open(filename, size, 7);
+    REQUIRE(book.num_entries() == 2*num_entries);
+    REQUIRE(book.depth() == 2);
+    for (int n = 0; n < num_entries; ++n) {
+      std::pair<int, int> query;
+      REQUIRE(book.find_query(hash_combine(HISTORY_ROOT, n), query));
+      REQUIRE(query == std::make_pair(n % size, (n + 1) % size));
+
+      int guess[size];
+      REQUIRE(book.find_guess(hash_combine(HISTORY_ROOT, n), guess));
+      for (int i = 0; i < size; ++i) {
+        REQUIRE(guess[i] == (i + n) % size);
+      }
+    }
+
+    std::pair<int, int> query;
+    REQUIRE(!book.find_query(HISTORY_ROOT, query));
+
+    REQUIRE_THROWS(book.open(filename, size + 1, 7));
+    REQUIRE_THROWS(book.open(filename, size, 8));
+
+    std::remove(filename.c_str());
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_same_games()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const std::string filename = "book_tests_same_games.book";
+
+    MatchemConfig config(BUILD_BOOK, 1, false);
+    config.set_book_file(filename);
+    config.set_book_depth(2);
+    {
+      Matchem builder(config);
+      builder.build_book();
+      REQUIRE(!builder.m_book.empty());
+    }
+
+    // The book holds what the strategy would have done anyway, so games must
+    // play out exactly the same with and without it.
+    MatchemConfig plain_config(BASIC, 1, false);
+    MatchemConfig book_config(BASIC, 1, false);
+    book_config.set_book_file(filename);
+    Matchem plain(plain_config);
+    Matchem booked(book_config);
+
+    for (int game = 0; game < 50; ++game) {
+      srand(game);
+      plain.init_indv(0);
+      const int plain_rounds = plain.run_indv(0);
+
+      srand(game);
+      booked.init_indv(0);
+      const int booked_rounds = booked.run_indv(0);
+
+      REQUIRE(plain_rounds == booked_rounds);
+      REQUIRE(plain.m_history(0) == booked.m_history(0));
+    }
+
+    std::remove(filename.c_str());
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("book_round_trip", "[book]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::BookTests::test_round_trip();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("book_same_games", "[book]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::BookTests::test_same_games();
+}
+
+} // empty namespace
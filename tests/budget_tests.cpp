@@ -0,0 +1,144 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_budget.hpp"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::BudgetTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_deadline()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const DecisionBudget unlimited;
+    REQUIRE(!unlimited.limited());
+    REQUIRE(!unlimited.expired());
+    REQUIRE(unlimited.used() == 0);
+
+    const DecisionBudget budget(static_cast<uint64_t>(200 * cycles_per_usec()));
+    REQUIRE(budget.limited());
+    REQUIRE(!budget.hit_deadline());
+    while (!budget.expired()) {}
+    REQUIRE(budget.hit_deadline());
+    REQUIRE(budget.used() >= static_cast<uint64_t>(200 * cycles_per_usec()));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_anytime_bandit()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // The bandit out of time before its first rollout falls back on arm 0, which is
+    // always what the heuristic would have done
+    MatchemConfig heuristic_config(BASIC, 1, false);
+    MatchemConfig bandit_config(BASIC, 1, false);
+    bandit_config.set_strategy(BANDIT);
+    Matchem heuristic(heuristic_config);
+    Matchem bandit(bandit_config);
+    bandit.m_budget_cycles = 1;
+
+    for (int game = 0; game < 20; ++game) {
+      srand(game);
+      heuristic.init_indv(0);
+      const int heuristic_rounds = heuristic.run_indv(0);
+
+      srand(game);
+      bandit.init_indv(0);
+      const int bandit_rounds = bandit.run_indv(0);
+
+      REQUIRE(heuristic_rounds == bandit_rounds);
+      REQUIRE(heuristic.m_history(0) == bandit.m_history(0));
+    }
+    REQUIRE(bandit.m_budget_decisions(0) > 0);
+    REQUIRE(bandit.m_budget_deadlines(0) > 0);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_bandit_threads()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // With the same time per decision, more threads on a game fit more
+    // rollouts in each decision and must not play worse for it
+    constexpr int NUM_GAMES = 24;
+    const uint64_t budget_cycles = static_cast<uint64_t>(300 * cycles_per_usec());
+    const int max_threads = Kokkos::DefaultExecutionSpace::concurrency();
+
+    std::vector<int> games;
+    for (int g = 0; g < NUM_GAMES; ++g) {
+      games.push_back(g * 7919);
+    }
+
+    double prev_rollouts = 0;
+    double first_mean = 0, first_ci95 = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+      if (max_threads % threads != 0) {
+        continue;
+      }
+      MatchemConfig config(BASIC, NUM_GAMES, false);
+      config.set_strategy(BANDIT);
+      config.set_bandit_rollouts(1000000);
+      config.set_bandit_threads(threads);
+      config.set_threads(1);
+      config.set_replay_games(games);
+      Matchem matchem(config);
+      matchem.m_budget_cycles = budget_cycles;
+
+      const RunStats stats = matchem.play_games();
+      REQUIRE(stats.rounds.count == NUM_GAMES);
+
+      uint64_t decisions = 0, rollouts = 0;
+      for (size_t ws_idx = 0; ws_idx < matchem.m_bandit_decisions.extent(0); ++ws_idx) {
+        decisions += matchem.m_bandit_decisions(ws_idx);
+        rollouts  += matchem.m_bandit_rollouts(ws_idx);
+      }
+      REQUIRE(decisions > 0);
+      const double rollouts_per_decision = static_cast<double>(rollouts) / decisions;
+      REQUIRE(rollouts_per_decision > prev_rollouts);
+      prev_rollouts = rollouts_per_decision;
+
+      if (threads == 1) {
+        first_mean = stats.rounds.mean();
+        first_ci95 = stats.rounds.ci95();
+      }
+      else {
+        REQUIRE(stats.rounds.mean() <= first_mean + first_ci95 + stats.rounds.ci95());
+      }
+    }
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("budget_deadline", "[budget]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::BudgetTests::test_deadline();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("budget_anytime_bandit", "[budget]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::BudgetTests::test_anytime_bandit();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("budget_bandit_threads", "[budget]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::BudgetTests::test_bandit_threads();
+}
+
+} // empty namespace
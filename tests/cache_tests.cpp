@@ -0,0 +1,208 @@
+#include "tests_common.hpp"
+
+#include "matchem_cache.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::CacheTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  template <int N>
+  static void make_known_info(std::mt19937& gen, int* known_info)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    int hidden[N];
+    for (int i = 0; i < N; ++i) {
+      hidden[i] = i;
+    }
+    std::shuffle(hidden, hidden + N, gen);
+
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    for (int i = 0; i < N; ++i) {
+      int16_t pieces[2] = {0, 0};
+      if (coin(gen) < 0.2) {
+        setb(pieces[0], hidden[i]);
+      }
+      for (int j = 0; j < N; ++j) {
+        if (j != hidden[i] && coin(gen) < 0.3) {
+          setb(pieces[1], j);
+        }
+      }
+      known_info[i] = *reinterpret_cast<int*>(pieces);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  template <int N>
+  static void relabel(const int* known_info, const int* row_perm, const int* col_perm, int* result)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    for (int i = 0; i < N; ++i) {
+      const int16_t* pieces = reinterpret_cast<const int16_t*>(&known_info[i]);
+      int16_t new_pieces[2] = {0, 0};
+      for (int j = 0; j < N; ++j) {
+        for (int b = 0; b < 2; ++b) {
+          if (is_setb(pieces[b], j)) {
+            setb(new_pieces[b], col_perm[j]);
+          }
+        }
+      }
+      result[row_perm[i]] = *reinterpret_cast<int*>(new_pieces);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_canonical_form()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    constexpr int N = 8;
+    std::mt19937 gen(5);
+
+    int same_keys = 0;
+    constexpr int trials = 200;
+    for (int trial = 0; trial < trials; ++trial) {
+      int known_info[N], shuffled[N], row_perm[N], col_perm[N];
+      make_known_info<N>(gen, known_info);
+      for (int i = 0; i < N; ++i) {
+        row_perm[i] = i;
+        col_perm[i] = i;
+      }
+      std::shuffle(row_perm, row_perm + N, gen);
+      std::shuffle(col_perm, col_perm + N, gen);
+      relabel<N>(known_info, row_perm, col_perm, shuffled);
+
+      CanonicalForm<N> form, shuffled_form;
+      canonicalize<N>(known_info, 0, nullptr, 0, nullptr, form);
+      canonicalize<N>(shuffled, 0, nullptr, 0, nullptr, shuffled_form);
+
+      for (int p = 0; p < N; ++p) {
+        REQUIRE(form.row_pos[form.rows[p]] == p);
+        REQUIRE(form.col_pos[form.cols[p]] == p);
+      }
+
+      // Relabeling both into canonical order must give the very same board
+      // whenever the keys agree
+      int canon[N], shuffled_canon[N];
+      relabel<N>(known_info, form.row_pos, form.col_pos, canon);
+      relabel<N>(shuffled, shuffled_form.row_pos, shuffled_form.col_pos, shuffled_canon);
+      const bool same_board = std::equal(canon, canon + N, shuffled_canon);
+      REQUIRE(same_board == (form.key == shuffled_form.key));
+      if (same_board) {
+        ++same_keys;
+      }
+    }
+
+    // Tie-breaking by label can split a few states, but most should match
+    REQUIRE(same_keys > trials * 3 / 4);
+
+    // Scored guesses are part of the form when given
+    int known_info[N], guesses[N], scores[1] = {2};
+    make_known_info<N>(gen, known_info);
+    for (int i = 0; i < N; ++i) {
+      guesses[i] = (i + 1) % N;
+    }
+    CanonicalForm<N> form, scored_form;
+    canonicalize<N>(known_info, 0, nullptr, 0, nullptr, form);
+    canonicalize<N>(known_info, 1, guesses, 1, scores, scored_form);
+    REQUIRE(form.key != scored_form.key);
+    scores[0] = 3;
+    CanonicalForm<N> other_score_form;
+    canonicalize<N>(known_info, 1, guesses, 1, scores, other_score_form);
+    REQUIRE(scored_form.key != other_score_form.key);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void make_decision(const uint64_t key, int8_t* decision)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    for (int k = 0; k < DecisionCache::MAX_SIZE; ++k) {
+      decision[k] = static_cast<int8_t>(hash_combine(key, k) & 0x7f);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_decision_cache()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    DecisionCache cache;
+    REQUIRE(!cache.enabled());
+    cache.init(1 << 16, false);
+    REQUIRE(cache.enabled());
+    REQUIRE(cache.num_slots() == 2*((1 << 16) / 64));
+
+    int8_t decision[DecisionCache::MAX_SIZE], found[DecisionCache::MAX_SIZE];
+    const uint64_t key = DecisionCache::make_key(12345, 0);
+    REQUIRE(!cache.find(key, found));
+    make_decision(key, decision);
+    cache.store(key, 10, decision);
+    REQUIRE(cache.find(key, found));
+    REQUIRE(std::equal(decision, decision + DecisionCache::MAX_SIZE, found));
+
+    // Two more keys in the same bucket: the lower priority one may only take
+    // the always-replace slot, so the high priority entry survives both
+    const uint64_t bucket_mask = cache.num_slots()/2 - 1;
+    uint64_t others[2];
+    int num_others = 0;
+    for (uint64_t n = 1; num_others < 2; ++n) {
+      const uint64_t other = DecisionCache::make_key(n, 0);
+      if ((other & bucket_mask) == (key & bucket_mask)) {
+        others[num_others++] = other;
+      }
+    }
+    for (int o = 0; o < 2; ++o) {
+      make_decision(others[o], decision);
+      cache.store(others[o], 5, decision);
+    }
+    REQUIRE(cache.find(key, found));
+    REQUIRE(!cache.find(others[0], found));
+    REQUIRE(cache.find(others[1], found));
+
+    // Hammer the table from every thread. Whatever comes back must be a
+    // whole decision for the key asked about, never a torn mix.
+    constexpr int num_keys = 20000;
+    DecisionCache* shared = &cache;
+    int bad = 0;
+    Kokkos::parallel_reduce("DecisionCache stress", Kokkos::RangePolicy<Kokkos::DefaultHostExecutionSpace>(0, 8*num_keys),
+                            KOKKOS_LAMBDA(const int n, int& errors) {
+      const uint64_t item = DecisionCache::make_key(n % num_keys, 1);
+      int8_t mine[DecisionCache::MAX_SIZE], theirs[DecisionCache::MAX_SIZE];
+      make_decision(item, mine);
+      if (shared->find(item, theirs)) {
+        errors += std::equal(mine, mine + DecisionCache::MAX_SIZE, theirs) ? 0 : 1;
+      }
+      else {
+        shared->store(item, n % 7, mine);
+      }
+    }, bad);
+    REQUIRE(bad == 0);
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("cache_canonical_form", "[cache]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::CacheTests::test_canonical_form();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("cache_decision_cache", "[cache]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::CacheTests::test_decision_cache();
+}
+
+} // empty namespace
@@ -0,0 +1,127 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::CalibrationTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_split()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Replays are the same games however they are handed out
+    std::vector<int> games;
+    for (int g = 0; g < 60; ++g) {
+      games.push_back(g * 7919);
+    }
+    MatchemConfig config(BASIC, 1, false);
+    config.set_replay_games(games);
+    Matchem matchem(config);
+    const int max_workers = matchem.m_tu.get_num_concurrent_teams();
+    REQUIRE(matchem.m_split.workers == max_workers);
+    REQUIRE(matchem.m_split.games_per_item == 1);
+
+    const RunStats reference = matchem.play_games();
+    REQUIRE(reference.rounds.count == 60);
+    for (const Matchem::WorkSplit split : {Matchem::WorkSplit{1, 1}, Matchem::WorkSplit{1, 7},
+                                           Matchem::WorkSplit{max_workers, 64}}) {
+      matchem.m_split = split;
+      const RunStats stats = matchem.play_games();
+      REQUIRE(stats.rounds.count == 60);
+      REQUIRE(stats.rounds.sum == reference.rounds.sum);
+      REQUIRE(stats.rounds.sum_sq == reference.rounds.sum_sq);
+    }
+
+    // Asking for more threads than there are gets all of them
+    MatchemConfig asked(BASIC, 100, false);
+    asked.set_threads(max_workers + 1);
+    asked.set_games_per_item(3);
+    Matchem split_matchem(asked);
+    REQUIRE(split_matchem.m_split.workers == max_workers);
+    REQUIRE(split_matchem.m_split.games_per_item == 3);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_file()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const std::string calibration_file = "calibration_tests.txt";
+    std::remove(calibration_file.c_str());
+
+    Matchem::WorkSplit split{0, 0};
+    REQUIRE(!Matchem::load_calibration(calibration_file, "a", split));
+    Matchem::save_calibration(calibration_file, "a", Matchem::WorkSplit{4, 16});
+    Matchem::save_calibration(calibration_file, "b", Matchem::WorkSplit{2, 1});
+    Matchem::save_calibration(calibration_file, "a", Matchem::WorkSplit{8, 4});
+    REQUIRE(Matchem::load_calibration(calibration_file, "a", split));
+    REQUIRE(split.workers == 8);
+    REQUIRE(split.games_per_item == 4);
+    REQUIRE(Matchem::load_calibration(calibration_file, "b", split));
+    REQUIRE(split.workers == 2);
+    REQUIRE(!Matchem::load_calibration(calibration_file, "c", split));
+    std::remove(calibration_file.c_str());
+
+    // The first Matchem probes and keeps its pick, the second reads it back
+    MatchemConfig config(BASIC, 100, false);
+    config.set_calibration_file(calibration_file);
+    srand(0);
+    Matchem first(config);
+    REQUIRE(first.m_split.workers >= 1);
+    REQUIRE(first.m_split.workers <= first.m_tu.get_num_concurrent_teams());
+    REQUIRE(first.m_split.games_per_item >= 1);
+    REQUIRE(Matchem::load_calibration(calibration_file, first.calibration_key(), split));
+
+    Matchem second(config);
+    REQUIRE(second.m_split.workers == first.m_split.workers);
+    REQUIRE(second.m_split.games_per_item == first.m_split.games_per_item);
+    int lines = 0;
+    std::ifstream in(calibration_file);
+    for (std::string line; std::getline(in, line); ++lines) {}
+    REQUIRE(lines == 1);
+
+    // The probe leaves the run's games alone
+    srand(1);
+    const RunStats calibrated = first.play_games();
+    MatchemConfig plain_config(BASIC, 100, false);
+    Matchem plain(plain_config);
+    srand(1);
+    const RunStats reference = plain.play_games();
+    REQUIRE(calibrated.rounds.sum == reference.rounds.sum);
+    REQUIRE(calibrated.rounds.sum_sq == reference.rounds.sum_sq);
+
+    std::remove(calibration_file.c_str());
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("calibration_split", "[calibration]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::CalibrationTests::test_split();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("calibration_file", "[calibration]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::CalibrationTests::test_file();
+}
+
+} // empty namespace
@@ -1,7 +1,12 @@
 #include "tests_common.hpp"
 
+#include "matchem.hpp"
+
 #include "catch.hpp"
 
+#include <cstdlib>
+#include <vector>
+
 namespace matchem {
 namespace tests {
 
@@ -13,6 +18,114 @@ struct UnitWrap::FullTests
   /////////////////////////////////////////////////////////////////////////////
   {}
 
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_fused()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // The per-phase functions are the reference, the fused round must play
+    // the very same games and leave the same trail behind
+    MatchemConfig config(BASIC, 1, false);
+    Matchem reference(config);
+    Matchem fused(config);
+    REQUIRE(fused.can_fuse());
+
+    for (int game = 0; game < 200; ++game) {
+      srand(game);
+      reference.init_indv(0);
+      const int reference_rounds = reference.run_indv(0);
+
+      srand(game);
+      fused.init_indv(0);
+      const int fused_rounds = fused.run_indv_fused(0);
+
+      REQUIRE(reference_rounds == fused_rounds);
+      REQUIRE(reference.m_history(0) == fused.m_history(0));
+      REQUIRE(reference.m_zobrist(0) == fused.m_zobrist(0));
+      for (int i = 0; i < Matchem::SIZE; ++i) {
+        REQUIRE(reference.m_guess_state(0, i) == fused.m_guess_state(0, i));
+        REQUIRE(reference.m_known_info(0, i) == fused.m_known_info(0, i));
+#ifdef EXTRA_TRACKING
+        for (int r = 0; r < fused_rounds; ++r) {
+          REQUIRE(reference.m_full_info(0, i, r) == fused.m_full_info(0, i, r));
+        }
+#endif
+      }
+#ifdef EXTRA_TRACKING
+      for (int r = 0; r < fused_rounds; ++r) {
+        REQUIRE(reference.m_round_info(0, r) == fused.m_round_info(0, r));
+      }
+#endif
+    }
+
+    MatchemConfig bandit_config(BASIC, 1, false);
+    bandit_config.set_strategy(BANDIT);
+    Matchem bandit(bandit_config);
+    REQUIRE(!bandit.can_fuse());
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_bandit_seed()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // With the same seed a game plays out the same, in whatever order the
+    // games come and however they are spread over threads
+    MatchemConfig config(BASIC, 1, false);
+    config.set_strategy(BANDIT);
+    config.set_bandit_rollouts(16);
+    srand(3);
+    Matchem forward(config);
+    srand(3);
+    Matchem backward(config);
+
+    constexpr int NUM_GAMES = 6;
+    int rounds[NUM_GAMES];
+    for (int g = 0; g < NUM_GAMES; ++g) {
+      forward.init_indv_exact(0, g * 104729);
+      rounds[g] = forward.run_indv(0);
+      REQUIRE(rounds[g] < static_cast<int>(Matchem::MAX_ROUNDS));
+    }
+    for (int g = NUM_GAMES - 1; g >= 0; --g) {
+      backward.init_indv_exact(0, g * 104729);
+      REQUIRE(backward.run_indv(0) == rounds[g]);
+    }
+
+    std::vector<int> games;
+    for (int g = 0; g < NUM_GAMES; ++g) {
+      games.push_back(g * 104729);
+    }
+    config.set_replay_games(games);
+    srand(3);
+    Matchem replay(config);
+    const RunStats spread = replay.play_games();
+    replay.m_split = Matchem::WorkSplit{1, NUM_GAMES};
+    const RunStats serial = replay.play_games();
+    REQUIRE(spread.rounds.count == NUM_GAMES);
+    REQUIRE(spread.rounds.sum == serial.rounds.sum);
+    REQUIRE(spread.rounds.sum_sq == serial.rounds.sum_sq);
+    REQUIRE(spread.rounds.max < static_cast<int>(Matchem::MAX_ROUNDS));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_bandit_one_candidate()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // With one candidate the bandit has nothing to compare, it must play the
+    // heuristic's game and never swap in an option it did not keep
+    MatchemConfig heuristic_config(BASIC, 1, false);
+    MatchemConfig bandit_config(BASIC, 1, false);
+    bandit_config.set_strategy(BANDIT);
+    bandit_config.set_bandit_candidates(1);
+    Matchem heuristic(heuristic_config);
+    Matchem bandit(bandit_config);
+
+    for (int game = 0; game < 50; ++game) {
+      heuristic.init_indv_exact(0, game * 7919);
+      bandit.init_indv_exact(0, game * 7919);
+      REQUIRE(heuristic.run_indv(0) == bandit.run_indv(0));
+      REQUIRE(heuristic.m_history(0) == bandit.m_history(0));
+    }
+  }
+
 };
 
 }
@@ -27,4 +140,25 @@ TEST_CASE("test_one", "[full]")
   matchem::tests::UnitWrap::FullTests::test_one();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("full_fused", "[full]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::FullTests::test_fused();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("full_bandit_seed", "[full]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::FullTests::test_bandit_seed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("full_bandit_one_candidate", "[full]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::FullTests::test_bandit_one_candidate();
+}
+
 } // empty namespace
@@ -0,0 +1,109 @@
+#include "tests_common.hpp"
+
+#include "matchem_model.hpp"
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <random>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::ModelTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_train()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    constexpr int F = LinearModel::NUM_FEATURES;
+    constexpr int size = 4;
+    constexpr int num_cells = size*size;
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // Boards with random odds and a few known misses. The teacher always asks
+    // about the least likely open cell, the opposite of the starting weights.
+    auto make_sample = [&](const LinearModel::Head head) {
+      LinearModel::Sample sample;
+      sample.head = head;
+      sample.odds.resize(num_cells);
+      sample.cells.resize(num_cells);
+      int best = -1;
+      for (int c = 0; c < num_cells; ++c) {
+        const bool miss = c % size != 0 && unit(gen) < 0.25f;
+        sample.cells[c] = miss ? LinearModel::NO_MATCH_CELL : LinearModel::OPEN_CELL;
+        sample.odds[c] = miss ? 0.0f : unit(gen);
+        if (!miss && (best == -1 || sample.odds[c] < sample.odds[best])) {
+          best = c;
+        }
+      }
+      sample.labels.push_back(best);
+      return sample;
+    };
+
+    std::vector<LinearModel::Sample> samples;
+    for (int n = 0; n < 200; ++n) {
+      samples.push_back(make_sample(LinearModel::QUERY_HEAD));
+    }
+
+    LinearModel model;
+    model.set_size(size);
+    model.train(samples, 200, 1.0);
+
+    int agree = 0;
+    constexpr int trials = 200;
+    for (int n = 0; n < trials; ++n) {
+      const LinearModel::Sample sample = make_sample(LinearModel::QUERY_HEAD);
+      float features[F*num_cells], scores[num_cells];
+      LinearModel::get_features(size, sample.odds.data(), sample.cells.data(), features);
+      model.score(LinearModel::QUERY_HEAD, features, num_cells, scores);
+
+      int best = -1;
+      for (int c = 0; c < num_cells; ++c) {
+        float expected = 0.0f;
+        for (int f = 0; f < F; ++f) {
+          expected += model.weights(LinearModel::QUERY_HEAD)[f] * features[f*num_cells + c];
+        }
+        REQUIRE(scores[c] == Approx(expected));
+        if (sample.cells[c] == LinearModel::OPEN_CELL && (best == -1 || scores[c] > scores[best])) {
+          best = c;
+        }
+      }
+      agree += best == sample.labels[0] ? 1 : 0;
+    }
+    REQUIRE(agree > trials * 3 / 4);
+
+    // The guess head had no samples, so it is untouched
+    REQUIRE(model.weights(LinearModel::GUESS_HEAD)[0] == 1.0f);
+
+    const std::string filename = "model_tests_train.model";
+    model.save(filename);
+    LinearModel loaded;
+    loaded.load(filename, size);
+    for (int h = 0; h < LinearModel::NUM_HEADS; ++h) {
+      const LinearModel::Head head = static_cast<LinearModel::Head>(h);
+      for (int f = 0; f < F; ++f) {
+        REQUIRE(loaded.weights(head)[f] == model.weights(head)[f]);
+      }
+    }
+    REQUIRE_THROWS(loaded.load(filename, size + 1));
+    std::remove(filename.c_str());
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("model_train", "[model]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::ModelTests::test_train();
+}
+
+} // empty namespace
@@ -0,0 +1,99 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_perf.hpp"
+
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::PerfTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_events()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    PerfCounters::Event event;
+    for (const std::string& name : PerfCounters::default_events()) {
+      REQUIRE(PerfCounters::find_event(name, event));
+      REQUIRE(event.name == name);
+    }
+    REQUIRE(PerfCounters::find_event("llc-misses", event));
+
+    REQUIRE(PerfCounters::find_event("raw:0x1c7", event));
+    REQUIRE(event.config == 0x1c7);
+    REQUIRE(PerfCounters::find_event("raw:c7", event));
+    REQUIRE(event.config == 0xc7);
+    REQUIRE(!PerfCounters::find_event("raw:", event));
+    REQUIRE(!PerfCounters::find_event("raw:0xz1", event));
+    REQUIRE(!PerfCounters::find_event("flops", event));
+
+    REQUIRE_THROWS(PerfCounters({"cycles", "flops"}, 1));
+    REQUIRE_THROWS(PerfCounters({"cycles", "cycles"}, 1));
+    REQUIRE_THROWS(PerfCounters({}, 1));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_games()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Whether or not this machine lets us count, the games are played and
+    // credited to the threads that played them
+    MatchemConfig config(BASIC, 200, false);
+    config.set_perf_counters({"cycles", "instructions", "branch-misses"});
+    Matchem matchem(config);
+    REQUIRE(matchem.m_perf);
+
+    const RunStats stats = matchem.play_games();
+    const PerfCounters& perf = *matchem.m_perf;
+    REQUIRE(perf.games() == 200);
+    REQUIRE(perf.rounds() == stats.rounds.sum);
+
+    std::ostringstream out;
+    perf.report(out);
+    if (perf.available()) {
+      REQUIRE(out.str().find("per game") != std::string::npos);
+      REQUIRE(out.str().find("per round") != std::string::npos);
+    }
+    else {
+      REQUIRE(out.str().find("unavailable") != std::string::npos);
+      REQUIRE(perf.count(0) == 0);
+    }
+
+    matchem.reset_counters();
+    REQUIRE(perf.games() == 0);
+
+    // Only the modes that report them count them
+    MatchemConfig tune(TUNE, 10, false);
+    tune.set_perf_counters(PerfCounters::default_events());
+    REQUIRE_THROWS(Matchem(tune));
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("perf_events", "[perf]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::PerfTests::test_events();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("perf_games", "[perf]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::PerfTests::test_games();
+}
+
+} // empty namespace
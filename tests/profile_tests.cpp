@@ -0,0 +1,124 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_profile.hpp"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <sstream>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::ProfileTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_merge()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    PhaseProfile a, b;
+    a.add(PhaseProfile::MAKE_GUESS, 100);
+    a.add(PhaseProfile::MAKE_GUESS, 50);
+    b.add(PhaseProfile::MAKE_GUESS, 10);
+    b.add(PhaseProfile::INIT, 7);
+    a.merge(b);
+    REQUIRE(a.calls[PhaseProfile::MAKE_GUESS] == 3);
+    REQUIRE(a.cycles[PhaseProfile::MAKE_GUESS] == 160);
+    REQUIRE(a.calls[PhaseProfile::INIT] == 1);
+    REQUIRE(a.calls[PhaseProfile::TRUTH_QUERY] == 0);
+
+    // A timer without a profile does nothing, one with adds one call
+    PhaseSections sections;
+    { PhaseTimer timer(nullptr, PhaseProfile::INIT, sections); }
+    { PhaseTimer timer(&a, PhaseProfile::PROCESS_ASK, sections); }
+    REQUIRE(a.calls[PhaseProfile::INIT] == 1);
+    REQUIRE(a.calls[PhaseProfile::PROCESS_ASK] == 1);
+
+    std::ostringstream out;
+    a.print(out);
+    REQUIRE(out.str().find("make_guess") != std::string::npos);
+    REQUIRE(out.str().find("process_guess") != std::string::npos);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_games()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+#ifdef PHASE_PROFILING
+    // Every round asks once, guesses once and scores the guess once. The
+    // fused round times the same phases, except that it scores the guess
+    // while it builds it.
+    MatchemConfig config(BASIC, 1, false);
+    Matchem reference(config);
+    Matchem fused(config);
+    REQUIRE(fused.can_fuse());
+
+    const uint64_t games = 50;
+    uint64_t total_rounds = 0;
+    for (uint64_t game = 0; game < games; ++game) {
+      srand(game);
+      reference.init_indv(0);
+      total_rounds += reference.run_indv(0);
+
+      srand(game);
+      fused.init_indv(0);
+      fused.run_indv_fused(0);
+    }
+
+    const PhaseProfile& timed = reference.m_profile(0);
+    REQUIRE(timed.calls[PhaseProfile::INIT] == games);
+    REQUIRE(timed.calls[PhaseProfile::TRUTH_QUERY] == total_rounds);
+    REQUIRE(timed.calls[PhaseProfile::PROCESS_ASK] <= total_rounds);
+    REQUIRE(timed.calls[PhaseProfile::PROCESS_ASK] > 0);
+    REQUIRE(timed.calls[PhaseProfile::MAKE_GUESS] == total_rounds);
+    REQUIRE(timed.calls[PhaseProfile::COUNT_MATCHES] == total_rounds);
+    REQUIRE(timed.calls[PhaseProfile::PROCESS_GUESS] == total_rounds);
+
+    const PhaseProfile& fused_timed = fused.m_profile(0);
+    for (int p = 0; p < PhaseProfile::NUM_PHASES; ++p) {
+      if (p != PhaseProfile::COUNT_MATCHES) {
+        REQUIRE(fused_timed.calls[p] == timed.calls[p]);
+      }
+    }
+    REQUIRE(fused_timed.calls[PhaseProfile::COUNT_MATCHES] == 0);
+
+    // Rollouts count towards the bandit decision they are part of
+    MatchemConfig bandit_config(BASIC, 1, false);
+    bandit_config.set_strategy(BANDIT);
+    Matchem bandit(bandit_config);
+    srand(1);
+    bandit.init_indv(0);
+    const uint64_t bandit_rounds = bandit.run_indv(0);
+    REQUIRE(bandit.m_profile(0).calls[PhaseProfile::MAKE_GUESS] == bandit_rounds);
+    for (int ws_idx = 1; ws_idx < bandit.m_num_ws; ++ws_idx) {
+      for (int p = 0; p < PhaseProfile::NUM_PHASES; ++p) {
+        REQUIRE(bandit.m_profile(ws_idx).calls[p] == 0);
+      }
+    }
+#endif
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("profile_merge", "[profile]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::ProfileTests::test_merge();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("profile_games", "[profile]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::ProfileTests::test_games();
+}
+
+} // empty namespace
@@ -0,0 +1,108 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::QueryTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_query_tree()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+#ifdef EXTRA_TRACKING
+    // The tournament tree only recomputes dirty rows, it must still pick the
+    // very pair a full scan would after every kind of update
+    MatchemConfig config(BASIC, 1, false);
+    Matchem matchem(config);
+    constexpr int ws_idx = 0;
+    const int max_rounds = Matchem::MAX_ROUNDS;
+
+    int checks = 0;
+    for (int game = 0; game < 200; ++game) {
+      srand(game);
+      matchem.init_indv(ws_idx);
+
+      int matches = 0;
+      for (int round = 0; matches < Matchem::SIZE; ++round) {
+        REQUIRE(round < max_rounds);
+        matchem.ask_truth(ws_idx, round);
+        REQUIRE(matchem.get_best_odds_query(ws_idx) == matchem.scan_best_odds_query(ws_idx));
+        ++checks;
+
+        matchem.make_guess(ws_idx, round);
+        matches = matchem.get_num_matches(ws_idx);
+        matchem.process_guess_result(ws_idx, round, matches);
+      }
+    }
+    REQUIRE(checks > 1000);
+#endif
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_incremental_guess()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Repairing last round's guess must give exactly what a rebuild from
+    // scratch gives
+    MatchemConfig config(BASIC, 1, false);
+    Matchem matchem(config);
+    constexpr int ws_idx = 0;
+    const int max_rounds = Matchem::MAX_ROUNDS;
+    auto my_guess = matchem::subview(matchem.m_guess_state, ws_idx);
+
+    for (int game = 0; game < 200; ++game) {
+      srand(game);
+      matchem.init_indv(ws_idx);
+
+      int matches = 0;
+      for (int round = 0; matches < Matchem::SIZE; ++round) {
+        REQUIRE(round < max_rounds);
+        matchem.ask_truth(ws_idx, round);
+
+        matchem.make_heuristic_guess(ws_idx, round);
+        int repaired[Matchem::SIZE];
+        for (int i = 0; i < Matchem::SIZE; ++i) {
+          repaired[i] = my_guess(i);
+        }
+
+        matchem.mark_all_dirty(ws_idx);
+        matchem.make_heuristic_guess(ws_idx, round);
+        for (int i = 0; i < Matchem::SIZE; ++i) {
+          REQUIRE(repaired[i] == my_guess(i));
+        }
+
+        matches = matchem.get_num_matches(ws_idx);
+        matchem.process_guess_result(ws_idx, round, matches);
+      }
+    }
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("query_tree", "[query]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::QueryTests::test_query_tree();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("query_incremental_guess", "[query]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::QueryTests::test_incremental_guess();
+}
+
+} // empty namespace
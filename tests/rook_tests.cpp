@@ -0,0 +1,275 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_rook.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::RookTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  template <int N>
+  static void make_board(std::mt19937& gen, const double miss_rate, int* hidden, int* allowed, int* guess)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    for (int i = 0; i < N; ++i) {
+      hidden[i] = i;
+      guess[i]  = i;
+    }
+    std::shuffle(hidden, hidden + N, gen);
+    std::shuffle(guess, guess + N, gen);
+
+    // The hidden state must always remain possible
+    for (int i = 0; i < N; ++i) {
+      allowed[i] = 0;
+      for (int j = 0; j < N; ++j) {
+        if (j == hidden[i] || coin(gen) >= miss_rate) {
+          setb(allowed[i], j);
+        }
+      }
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  template <int N>
+  static void check_kernel(std::mt19937& gen, const double miss_rate)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    int hidden[N], allowed[N], guess[N];
+    make_board<N>(gen, miss_rate, hidden, allowed, guess);
+
+    std::vector<int64_t> ws(match_count_dist_ws_size<N>());
+    match_dist_t<N> dist, brute_dist;
+    match_count_dist<N>(allowed, guess, ws.data(), dist);
+    match_count_dist_brute<N>(allowed, guess, brute_dist);
+
+    int64_t total = 0;
+    for (int k = 0; k <= N; ++k) {
+      REQUIRE(dist[k] == brute_dist[k]);
+      total += dist[k];
+    }
+    REQUIRE(total > 0);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_kernel()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    std::mt19937 gen(42);
+    for (int trial = 0; trial < 20; ++trial) {
+      check_kernel<1>(gen, 0.5);
+      check_kernel<4>(gen, 0.3);
+      check_kernel<6>(gen, 0.0);
+      check_kernel<6>(gen, 0.4);
+      check_kernel<7>(gen, 0.6);
+    }
+
+    // Fresh board: the distribution is the rencontres numbers
+    constexpr int N = 5;
+    int allowed[N], guess[N];
+    for (int i = 0; i < N; ++i) {
+      allowed[i] = (1 << N) - 1;
+      guess[i] = i;
+    }
+    std::vector<int64_t> ws(match_count_dist_ws_size<N>());
+    match_dist_t<N> dist;
+    match_count_dist<N>(allowed, guess, ws.data(), dist);
+    const int64_t expected[N+1] = {44, 45, 20, 10, 0, 1};
+    for (int k = 0; k <= N; ++k) {
+      REQUIRE(dist[k] == expected[k]);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  template <int N>
+  static void check_sampling(std::mt19937& gen, Rng& rng, const double miss_rate)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    int hidden[N], allowed[N], guess[N];
+    make_board<N>(gen, miss_rate, hidden, allowed, guess);
+
+    std::vector<int64_t> ws(match_count_dist_ws_size<N>());
+    match_dist_t<N> dist;
+    match_count_dist<N>(allowed, guess, ws.data(), dist);
+    int64_t total = 0;
+    for (int k = 0; k <= N; ++k) {
+      total += dist[k];
+    }
+
+    count_completions<N>(allowed, ws.data());
+    REQUIRE(ws[0] == total);
+
+    // Every placement that fits the board should come up about equally often
+    constexpr int samples_per_state = 400;
+    std::map<std::vector<int>, int> counts;
+    for (int s = 0; s < samples_per_state*total; ++s) {
+      std::vector<int> placement(N);
+      sample_placement<N>(allowed, ws.data(), rng, placement.data());
+      int used = 0;
+      for (int i = 0; i < N; ++i) {
+        REQUIRE(is_setb(allowed[i], placement[i]));
+        REQUIRE(!is_setb(used, placement[i]));
+        setb(used, placement[i]);
+      }
+      ++counts[placement];
+    }
+    REQUIRE(static_cast<int64_t>(counts.size()) == total);
+    for (const auto& item : counts) {
+      REQUIRE(std::abs(item.second - samples_per_state) < samples_per_state / 4);
+    }
+
+    // Completing a placement from scratch or from a known row must fit the board
+    for (int start = -1; start < N; ++start) {
+      int placement[N];
+      for (int i = 0; i < N; ++i) {
+        placement[i] = i == start ? hidden[i] : -1;
+      }
+      REQUIRE(complete_placement<N>(allowed, placement));
+      int used = 0;
+      for (int i = 0; i < N; ++i) {
+        REQUIRE(is_setb(allowed[i], placement[i]));
+        REQUIRE(!is_setb(used, placement[i]));
+        setb(used, placement[i]);
+      }
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_sampling()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    std::mt19937 gen(99);
+    Rng rng(99);
+    for (int trial = 0; trial < 10; ++trial) {
+      check_sampling<3>(gen, rng, 0.0);
+      check_sampling<4>(gen, rng, 0.3);
+      check_sampling<5>(gen, rng, 0.6);
+    }
+
+    // No placement fits a board where two rows want the same single column
+    int allowed[3] = {1, 1, 7};
+    int placement[3] = {-1, -1, -1};
+    REQUIRE(!complete_placement<3>(allowed, placement));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_game_dist()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    constexpr int SIZE = Matchem::SIZE;
+
+    MatchemConfig config(BASIC, 1, false);
+    Matchem matchem(config);
+
+    srand(7);
+    matchem.init_indv(0);
+    for (int round = 0; round < 3; ++round) {
+      matchem.ask_truth(0, round);
+      matchem.make_guess(0, round);
+    }
+
+    auto guess = matchem::subview(matchem.m_guess_state, 0);
+    Matchem::match_dist_t dist, brute_dist;
+    matchem.get_match_count_dist(0, guess, dist);
+
+    int allowed[SIZE];
+    for (int i = 0; i < SIZE; ++i) {
+      allowed[i] = matchem.get_pot_match_mask(0, i);
+    }
+    match_count_dist_brute<SIZE>(allowed, guess.data(), brute_dist);
+
+    for (int k = 0; k <= SIZE; ++k) {
+      REQUIRE(dist[k] == brute_dist[k]);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  template <int N>
+  static void bench_one(std::mt19937& gen)
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    constexpr int reps = 10;
+    int hidden[N], allowed[N], guess[N];
+    make_board<N>(gen, 0.35, hidden, allowed, guess);
+
+    std::vector<int64_t> ws(match_count_dist_ws_size<N>());
+    match_dist_t<N> dist, brute_dist;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      match_count_dist<N>(allowed, guess, ws.data(), dist);
+    }
+    const double dp_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / reps;
+
+    start = std::chrono::steady_clock::now();
+    match_count_dist_brute<N>(allowed, guess, brute_dist);
+    const double brute_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int64_t total = 0;
+    for (int k = 0; k <= N; ++k) {
+      REQUIRE(dist[k] == brute_dist[k]);
+      total += dist[k];
+    }
+
+    std::cout << "SIZE " << N << ": " << total << " consistent states, rook dp " << dp_time
+              << "s, enumeration " << brute_time << "s, speedup " << brute_time / dp_time << std::endl;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void bench_kernel()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    std::mt19937 gen(1234);
+    bench_one<8>(gen);
+    bench_one<9>(gen);
+    bench_one<10>(gen);
+    bench_one<11>(gen);
+    bench_one<12>(gen);
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("rook_kernel", "[rook]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::RookTests::test_kernel();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("rook_sampling", "[rook]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::RookTests::test_sampling();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("rook_game_dist", "[rook]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::RookTests::test_game_dist();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("rook_bench", "[.bench]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::RookTests::bench_kernel();
+}
+
+} // empty namespace
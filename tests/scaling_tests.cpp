@@ -0,0 +1,96 @@
+#include "tests_common.hpp"
+
+#include "matchem_scaling.hpp"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::ScalingTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_factors()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    REQUIRE(MatchemScaling::thread_counts(1) == std::vector<int>({1}));
+    REQUIRE(MatchemScaling::thread_counts(8) == std::vector<int>({1, 2, 4, 8}));
+    REQUIRE(MatchemScaling::thread_counts(6) == std::vector<int>({1, 2, 4, 6}));
+
+    // 100 games in a second on 1 thread, in half a second on 4
+    MatchemScaling::Point base{1, 100, 1.0, ScalingStats()};
+    base.stats.busy_ns[0] = 900000000;
+    MatchemScaling::Point point{4, 100, 0.5, ScalingStats()};
+    point.stats.busy_ns[0] = 300000000;
+    point.stats.busy_ns[1] = 250000000;
+    point.stats.busy_ns[2] = 200000000;
+    point.stats.busy_ns[3] = 250000000;
+
+    const MatchemScaling::Factors f = MatchemScaling::factors(base, point);
+    REQUIRE(f.efficiency == Approx(0.5));
+    REQUIRE(f.per_game == Approx(0.9));
+    REQUIRE(f.balance == Approx(1.0 / 1.2));
+    REQUIRE(f.sched == Approx(0.6 / 0.9));
+    REQUIRE(f.per_game * f.balance * f.sched == Approx(f.efficiency));
+
+    const MatchemScaling::Factors same = MatchemScaling::factors(base, base);
+    REQUIRE(same.efficiency == Approx(1.0));
+    REQUIRE(same.per_game * same.balance * same.sched == Approx(1.0));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_same_games()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    MatchemConfig config(SCALING, 40, false);
+    srand(0);
+    MatchemScaling scaling(config);
+
+    // Every width plays the very same games, whichever worker gets them
+    const MatchemScaling::Point first = scaling.measure(1, 40);
+    REQUIRE(first.stats.rounds.count == 40);
+    REQUIRE(first.stats.games[0] == 40);
+    REQUIRE(first.stats.busy_ns[0] > 0);
+
+    const MatchemScaling::Point again = scaling.measure(1, 40);
+    REQUIRE(again.stats.rounds.sum == first.stats.rounds.sum);
+    REQUIRE(again.stats.rounds.sum_sq == first.stats.rounds.sum_sq);
+
+    const MatchemScaling::Point wide = scaling.measure(scaling.max_threads(), 40);
+    int64_t games = 0;
+    for (int w = 0; w < wide.threads; ++w) {
+      games += wide.stats.games[w];
+    }
+    REQUIRE(games == 40);
+    REQUIRE(wide.stats.rounds.sum == first.stats.rounds.sum);
+    REQUIRE(wide.stats.rounds.sum_sq == first.stats.rounds.sum_sq);
+
+    REQUIRE_THROWS(scaling.measure(scaling.max_threads() + 1, 40));
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("scaling_factors", "[scaling]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::ScalingTests::test_factors();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("scaling_same_games", "[scaling]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::ScalingTests::test_same_games();
+}
+
+} // empty namespace
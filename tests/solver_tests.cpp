@@ -0,0 +1,103 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_solver.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::SolverTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_solve()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    for (int n = 1; n <= 4; ++n) {
+      MatchemConfig config(SOLVE, 1, false);
+      config.set_solve_size(n);
+      MatchemSolver solver(config);
+      const double value = solver.solve();
+
+      PolicyTable policy;
+      solver.export_policy(policy);
+      REQUIRE(policy.size() == n);
+
+      // Play the exported policy against every hidden state, it must achieve
+      // exactly the value the solver claimed.
+      std::vector<int> hidden(n), guess(n);
+      std::iota(hidden.begin(), hidden.end(), 0);
+      int total_rounds = 0, num_games = 0;
+      do {
+        uint64_t history = HISTORY_ROOT;
+        int matches = 0, rounds = 0;
+        while (matches < n) {
+          std::pair<int, int> query;
+          REQUIRE(policy.find_query(history, query));
+          history = history_after_ask(history, hidden[query.first] == query.second);
+
+          REQUIRE(policy.find_guess(history, guess.data()));
+          matches = 0;
+          for (int i = 0; i < n; ++i) {
+            matches += (guess[i] == hidden[i]) ? 1 : 0;
+          }
+          history = history_after_guess(history, matches);
+          ++rounds;
+          REQUIRE(rounds <= n*n);
+        }
+        total_rounds += rounds;
+        ++num_games;
+      } while (std::next_permutation(hidden.begin(), hidden.end()));
+
+      REQUIRE(approx_equal(static_cast<double>(total_rounds) / num_games, value, 1e-9));
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_known_values()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Size 3: ask (0,0). If yes, two states are left and a guess finishes half
+    // of them. If no, four are left and the best guess finishes one of them
+    // and splits the other three apart.
+    MatchemConfig config(SOLVE, 1, false);
+    config.set_solve_size(3);
+    MatchemSolver solver(config);
+    REQUIRE(approx_equal(solver.solve(), 1.0 + (2.0/6)*0.5 + (4.0/6)*0.75, 1e-9));
+
+    // No policy can exist for a simulator set size beyond the solver
+    if (Matchem::SIZE > MatchemSolver::MAX_SIZE) {
+      MatchemConfig optimal(BASIC, 1, false);
+      optimal.set_strategy(OPTIMAL);
+      optimal.set_policy_file("unused.policy");
+      REQUIRE_THROWS(Matchem(optimal));
+    }
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("solver_solve", "[solver]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::SolverTests::test_solve();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("solver_known_values", "[solver]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::SolverTests::test_known_values();
+}
+
+} // empty namespace
@@ -0,0 +1,326 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_stats.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::StatsTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_moments()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    SimStats stats;
+    REQUIRE(stats.count == 0);
+    REQUIRE(stats.mean() == 0.0);
+    REQUIRE(stats.variance() == 0.0);
+
+    // 1..10, one game each
+    for (int rounds = 1; rounds <= 10; ++rounds) {
+      stats.add(rounds);
+    }
+    REQUIRE(stats.count == 10);
+    REQUIRE(stats.min == 1);
+    REQUIRE(stats.max == 10);
+    REQUIRE(stats.mean() == Approx(5.5));
+    REQUIRE(stats.variance() == Approx(55.0 / 6.0));
+    REQUIRE(stats.ci95() == Approx(1.96 * std::sqrt(55.0 / 6.0 / 10.0)));
+    REQUIRE(stats.percentile(0.5) == 5);
+    REQUIRE(stats.percentile(0.51) == 6);
+    REQUIRE(stats.percentile(0.9) == 9);
+    REQUIRE(stats.percentile(1.0) == 10);
+    REQUIRE(stats.prob_within(0) == 0.0);
+    REQUIRE(stats.prob_within(3) == Approx(0.3));
+    REQUIRE(stats.prob_within(SimStats::NUM_BINS + 5) == 1.0);
+
+    // The longest game there can be has a bin
+    SimStats longest;
+    longest.add(Matchem::MAX_ROUNDS);
+    REQUIRE(longest.histogram[Matchem::MAX_ROUNDS] == 1);
+    REQUIRE(longest.percentile(1.0) == static_cast<int>(Matchem::MAX_ROUNDS));
+
+    // Merging two halves is the same as adding everything to one
+    SimStats low, high;
+    for (int rounds = 1; rounds <= 10; ++rounds) {
+      (rounds <= 4 ? low : high).add(rounds);
+    }
+    low.merge(high);
+    REQUIRE(low.count == stats.count);
+    REQUIRE(low.sum == stats.sum);
+    REQUIRE(low.sum_sq == stats.sum_sq);
+    REQUIRE(low.min == stats.min);
+    REQUIRE(low.max == stats.max);
+    for (int r = 0; r < SimStats::NUM_BINS; ++r) {
+      REQUIRE(low.histogram[r] == stats.histogram[r]);
+    }
+
+    // Merging an empty batch changes nothing
+    low.merge(SimStats());
+    REQUIRE(low.min == 1);
+    REQUIRE(low.max == 10);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_reducer()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Games are spread over threads and the order they draw their hidden
+    // states in is up to the scheduler, so check the merged result is
+    // consistent rather than comparing against a serial run
+    MatchemConfig config(BASIC, 500, false);
+    Matchem matchem(config);
+    const SimStats stats = matchem.play_games().rounds;
+    REQUIRE(stats.count == 500);
+
+    int64_t count = 0, sum = 0, sum_sq = 0;
+    int min = -1, max = -1;
+    for (int r = 0; r < SimStats::NUM_BINS; ++r) {
+      if (stats.histogram[r] > 0) {
+        min = min == -1 ? r : min;
+        max = r;
+      }
+      count  += stats.histogram[r];
+      sum    += r * stats.histogram[r];
+      sum_sq += r * r * stats.histogram[r];
+    }
+    REQUIRE(count == stats.count);
+    REQUIRE(sum == stats.sum);
+    REQUIRE(sum_sq == stats.sum_sq);
+    REQUIRE(min == stats.min);
+    REQUIRE(max == stats.max);
+    REQUIRE(stats.prob_within(max) == 1.0);
+    REQUIRE(stats.prob_within(min - 1) == 0.0);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_curves()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    MatchemConfig config(BASIC, 300, false);
+    config.set_curves_file("stats_tests_curves.csv"); // play_games does not write it
+    Matchem matchem(config);
+    const RunStats run_stats = matchem.play_games();
+    const SimStats& stats = run_stats.rounds;
+    const RoundCurves& curves = run_stats.curves;
+
+    // Every game plays round r if it took more than r rounds
+    int64_t longer = stats.count;
+    for (int r = 0; r < RoundCurves::NUM_ROUNDS; ++r) {
+      longer -= stats.histogram[r];
+      REQUIRE(curves.games[r] == longer);
+    }
+
+    // Only the longest games play the last round and they all win it. The
+    // first round already learned something, so the odds are no longer flat.
+    const int size = Matchem::SIZE;
+    REQUIRE(curves.matches[stats.max - 1] == size * stats.histogram[stats.max]);
+    REQUIRE(curves.marginal_entropy[0] / curves.games[0] < size * std::log2(size));
+    for (int r = 0; r < stats.max; ++r) {
+      REQUIRE(curves.known[r] <= size * curves.games[r]);
+      REQUIRE(curves.matches[r] <= size * curves.games[r]);
+      REQUIRE(curves.entropy[r] >= 0.0);
+    }
+
+    // Before any query every hidden state fits, after the first one fewer do
+    const double all_states = std::log2(static_cast<double>(factorial(size)));
+    matchem.init_indv(0);
+    REQUIRE(matchem.get_entropy(0) == Approx(all_states));
+    REQUIRE(curves.entropy[0] / curves.games[0] < all_states);
+
+    std::ostringstream csv;
+    curves.write_csv(csv);
+    std::istringstream lines(csv.str());
+    std::string line;
+    int num_lines = 0;
+    while (std::getline(lines, line)) {
+      ++num_lines;
+    }
+    REQUIRE(num_lines == stats.max + 1);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_latency()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Buckets are contiguous and bucket_end is where the next one starts
+    for (uint64_t ns = 0; ns < 5000; ++ns) {
+      const int b = LatencyStats::bucket(ns);
+      REQUIRE(ns < LatencyStats::bucket_end(b));
+      REQUIRE(LatencyStats::bucket(LatencyStats::bucket_end(b)) == b + 1);
+    }
+    REQUIRE(LatencyStats::bucket(1023) == 35);
+    REQUIRE(LatencyStats::bucket(1024) == 36);
+    REQUIRE(LatencyStats::bucket(std::numeric_limits<uint64_t>::max()) == LatencyStats::NUM_BUCKETS - 1);
+
+    // Two threads' worth of games, merged, keep the slowest of both
+    constexpr int num_slowest = LatencyStats::NUM_SLOWEST;
+    LatencyStats even, odd;
+    for (int game = 0; game < 100; ++game) {
+      const uint64_t ns = 1000 + 37 * ((game * 61) % 100);
+      LatencyStats& stats = game % 2 == 0 ? even : odd;
+      stats.add(ns, stats.is_slow(ns) ? game : -1);
+    }
+    REQUIRE(even.num_slowest == num_slowest);
+    even.merge(odd);
+    REQUIRE(even.count == 100);
+    REQUIRE(even.num_slowest == num_slowest);
+    for (int k = 0; k < num_slowest; ++k) {
+      REQUIRE(even.slowest_ns[k] == static_cast<uint64_t>(1000 + 37 * (99 - k)));
+      REQUIRE((even.slowest_game[k] * 61) % 100 == 99 - k);
+    }
+    REQUIRE(even.percentile_ns(0.01) == 1024); // 1000 ns
+    REQUIRE(even.percentile_ns(1.0) == 5120);  // 4663 ns
+
+    // Ids of games played are the ones that replay them
+    const std::vector<int> games = {0, 4321, 3628799};
+    MatchemConfig config(BASIC, 1, false);
+    config.set_replay_games(games);
+    Matchem matchem(config);
+    const LatencyStats latency = matchem.play_games().latency;
+    REQUIRE(latency.count == 3);
+    REQUIRE(latency.num_slowest == 3);
+    std::vector<int> seen;
+    for (int k = 0; k < latency.num_slowest; ++k) {
+      seen.push_back(latency.slowest_game[k]);
+    }
+    std::sort(seen.begin(), seen.end());
+    REQUIRE(seen == games);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_target_ci()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const int min_batch = Matchem::MIN_CI_BATCH;
+
+    // The spread of the heuristic is about 5 rounds, so +/- 0.5 takes a few
+    // hundred games
+    MatchemConfig config(BASIC, 1, false);
+    config.set_target_ci(0.5);
+    config.set_max_runs(100000);
+    Matchem matchem(config);
+    const SimStats stats = matchem.play_to_target().rounds;
+    REQUIRE(stats.ci95() <= 0.5);
+    REQUIRE(stats.count >= min_batch);
+    REQUIRE(stats.count < 2000);
+
+    // An impossible target stops at the cap
+    MatchemConfig capped_config(BASIC, 1, false);
+    capped_config.set_target_ci(1e-6);
+    capped_config.set_max_runs(700);
+    Matchem capped(capped_config);
+    const SimStats capped_stats = capped.play_to_target().rounds;
+    REQUIRE(capped_stats.count == 700);
+    REQUIRE(capped_stats.ci95() > 1e-6);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_checkpoint()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const std::string filename = "stats_tests_checkpoint.ckpt";
+    std::remove(filename.c_str());
+
+    MatchemConfig config(EXACT, 1, false);
+    config.set_checkpoint_file(filename);
+    Matchem matchem(config);
+    const int num_games = Matchem::get_num_games(config);
+    const int done = num_games - 1000;
+
+    // Pretend everything but the last 1000 games was played already, they
+    // all took 30 rounds
+    SimStats before;
+    for (int game = 0; game < done; ++game) {
+      before.add(30);
+    }
+    matchem.save_checkpoint(filename, done, before);
+
+    SimStats loaded;
+    REQUIRE(matchem.load_checkpoint(filename, loaded) == done);
+    REQUIRE(loaded.count == before.count);
+    REQUIRE(loaded.sum_sq == before.sum_sq);
+    REQUIRE(loaded.histogram[30] == done);
+
+    // Resuming only plays the rest, and plays it the same way a plain batch
+    // of those games does
+    const SimStats resumed = matchem.play_exhaustive().rounds;
+    const SimStats rest = matchem.play_games(done, 1000).rounds;
+    REQUIRE(resumed.count == num_games);
+    REQUIRE(resumed.sum == before.sum + rest.sum);
+    REQUIRE(resumed.histogram[30] == done + rest.histogram[30]);
+    REQUIRE(matchem.load_checkpoint(filename, loaded) == num_games);
+
+    // A checkpoint of another strategy is refused
+    MatchemConfig other_config(EXACT, 1, false);
+    other_config.set_strategy(DISTILLED);
+    other_config.set_model_file("unused.model");
+    std::ofstream("unused.model") << "size 10 features 7\nquery 1 0 0 0 0 0 0\nguess 1 0 0 0 0 0 0\n";
+    Matchem other(other_config);
+    REQUIRE_THROWS(other.load_checkpoint(filename, loaded));
+
+    std::remove("unused.model");
+    std::remove(filename.c_str());
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("stats_moments", "[stats]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::StatsTests::test_moments();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("stats_reducer", "[stats]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::StatsTests::test_reducer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("stats_curves", "[stats]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::StatsTests::test_curves();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("stats_latency", "[stats]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::StatsTests::test_latency();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("stats_target_ci", "[stats]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::StatsTests::test_target_ci();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("stats_checkpoint", "[stats]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::StatsTests::test_checkpoint();
+}
+
+} // empty namespace
@@ -0,0 +1,132 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_sweep.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::SweepTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_grid()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    const std::string grid_file = "sweep_tests_grid.txt";
+    {
+      std::ofstream out(grid_file);
+      out << "# heuristic once, bandit for every rollout count\n"
+          << "strategy = heuristic, bandit\n"
+          << "num-runs = 20\n"
+          << "bandit-rollouts = 1, 2  # cheap\n"
+          << "set-size = " << MatchemConfig::SET_SIZE << ", " << MatchemConfig::SET_SIZE + 1 << "\n";
+    }
+
+    MatchemConfig config(SWEEP, 1000, false);
+    config.set_grid_file(grid_file);
+    const std::vector<MatchemSweep::Row> rows = MatchemSweep::read_grid(grid_file, config);
+    REQUIRE(rows.size() == 6);
+    REQUIRE(rows[0].strategy == HEURISTIC);
+    REQUIRE(rows[1].strategy == BANDIT);
+    REQUIRE(rows[1].bandit_rollouts == 1);
+    REQUIRE(rows[2].bandit_rollouts == 2);
+    REQUIRE(rows[2].bandit_candidates == config.bandit_candidates());
+    REQUIRE(rows[2].num_runs == 20);
+    REQUIRE(MatchemSweep::playable(rows[2]));
+    REQUIRE(!MatchemSweep::playable(rows[3]));
+
+    srand(0);
+    MatchemSweep sweep(config);
+    sweep.play();
+    const std::vector<MatchemSweep::Result>& results = sweep.results();
+    REQUIRE(results.size() == 6);
+    for (size_t r = 0; r < results.size(); ++r) {
+      REQUIRE(results[r].played == (r < 3));
+      REQUIRE(results[r].rounds.count == (r < 3 ? 20 : 0));
+    }
+
+    std::ostringstream csv;
+    MatchemSweep::write_csv(csv, results);
+    int lines = 0;
+    std::istringstream in(csv.str());
+    for (std::string line; std::getline(in, line); ++lines) {
+      REQUIRE(std::count(line.begin(), line.end(), ',') == 13);
+    }
+    REQUIRE(lines == 7);
+
+    std::remove(grid_file.c_str());
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_reconfigure()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // A Matchem built for bandit and switched to the heuristic plays the same
+    // games as one built for the heuristic
+    MatchemConfig heuristic_config(BASIC, 1, false);
+    MatchemConfig bandit_config(BASIC, 1, false);
+    bandit_config.set_strategy(BANDIT);
+    bandit_config.set_bandit_rollouts(2);
+    Matchem heuristic(heuristic_config);
+    Matchem reused(bandit_config);
+
+    srand(3);
+    reused.init_indv(0);
+    reused.run_indv(0);
+    reused.reconfigure(heuristic_config);
+    REQUIRE(reused.get_config().strategy() == HEURISTIC);
+#ifdef TELEMETRY
+    REQUIRE(reused.m_telemetry(0).counters[Telemetry::GUESSES] == 0);
+#endif
+
+    for (int game = 0; game < 20; ++game) {
+      srand(game);
+      heuristic.init_indv(0);
+      const int heuristic_rounds = heuristic.run_indv(0);
+
+      srand(game);
+      reused.init_indv(0);
+      const int reused_rounds = reused.run_indv(0);
+
+      REQUIRE(heuristic_rounds == reused_rounds);
+      REQUIRE(heuristic.m_history(0) == reused.m_history(0));
+    }
+
+    // Going back to bandit is fine, the rollout workspaces are still there,
+    // but a Matchem built for the heuristic has none
+    reused.reconfigure(bandit_config);
+    REQUIRE_THROWS(heuristic.reconfigure(bandit_config));
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("sweep_grid", "[sweep]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::SweepTests::test_grid();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("sweep_reconfigure", "[sweep]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::SweepTests::test_reconfigure();
+}
+
+} // empty namespace
@@ -0,0 +1,114 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_telemetry.hpp"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <sstream>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::TelemetryTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_counters()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    Telemetry a, b;
+    a.add(Telemetry::TRUTH_QUERIES, 3);
+    a.enter_inference();
+    a.enter_inference();
+    a.leave_inference();
+    a.enter_inference();
+    a.leave_inference();
+    a.leave_inference();
+    REQUIRE(a.infer_depth == 0);
+    REQUIRE(a.counters[Telemetry::FACTS_INFERRED] == 3);
+    REQUIRE(a.counters[Telemetry::MAX_INFER_DEPTH] == 2);
+
+    b.add(Telemetry::TRUTH_QUERIES, 4);
+    b.enter_inference();
+    b.leave_inference();
+    a.merge(b);
+    REQUIRE(a.counters[Telemetry::TRUTH_QUERIES] == 7);
+    REQUIRE(a.counters[Telemetry::FACTS_INFERRED] == 4);
+    REQUIRE(a.counters[Telemetry::MAX_INFER_DEPTH] == 2); // a max, not a sum
+
+    std::ostringstream json;
+    a.write_json(json);
+    REQUIRE(json.str().find("\"truth_queries\": 7") != std::string::npos);
+    REQUIRE(json.str().find("\"determined_guesses\": 0\n}") != std::string::npos);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_games()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+#ifdef TELEMETRY
+    // The fused round does the same work as the per-phase functions, so it
+    // must count the same
+    MatchemConfig config(BASIC, 1, false);
+    Matchem reference(config);
+    Matchem fused(config);
+    REQUIRE(fused.can_fuse());
+
+    int total_rounds = 0;
+    for (int game = 0; game < 100; ++game) {
+      srand(game);
+      reference.init_indv(0);
+      total_rounds += reference.run_indv(0);
+
+      srand(game);
+      fused.init_indv(0);
+      fused.run_indv_fused(0);
+    }
+
+    const Telemetry& counted = reference.m_telemetry(0);
+    for (int c = 0; c < Telemetry::NUM_COUNTERS; ++c) {
+      REQUIRE(counted.counters[c] == fused.m_telemetry(0).counters[c]);
+    }
+
+    // The heuristic asks and guesses once a round and every query or
+    // deduction sets a state. A determined guess wins, so a game has at most
+    // one.
+    REQUIRE(counted.infer_depth == 0);
+    REQUIRE(counted.counters[Telemetry::TRUTH_QUERIES] == static_cast<uint64_t>(total_rounds));
+    REQUIRE(counted.counters[Telemetry::GUESSES] == static_cast<uint64_t>(total_rounds));
+    REQUIRE(counted.counters[Telemetry::SET_STATE_CALLS] >=
+            counted.counters[Telemetry::FACTS_INFERRED] + counted.counters[Telemetry::TRUTH_QUERIES] / 2);
+    REQUIRE(counted.counters[Telemetry::FACTS_INFERRED] > 0);
+    REQUIRE(counted.counters[Telemetry::MAX_INFER_DEPTH] >= 1);
+    REQUIRE(counted.counters[Telemetry::DETERMINED_GUESSES] > 0);
+    REQUIRE(counted.counters[Telemetry::DETERMINED_GUESSES] <= 100);
+    REQUIRE(counted.counters[Telemetry::ODDS_CELLS] > 0);
+    REQUIRE(counted.counters[Telemetry::GUESS_ROWS] > 0);
+    REQUIRE(counted.counters[Telemetry::GUESS_ROWS] <= static_cast<uint64_t>(total_rounds * Matchem::SIZE));
+#endif
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("telemetry_counters", "[telemetry]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TelemetryTests::test_counters();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("telemetry_games", "[telemetry]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TelemetryTests::test_games();
+}
+
+} // empty namespace
@@ -16,6 +16,23 @@ namespace tests {
 struct UnitWrap
 {
   struct FullTests;
+  struct RookTests;
+  struct SolverTests;
+  struct BookTests;
+  struct CacheTests;
+  struct TreeTests;
+  struct ModelTests;
+  struct BudgetTests;
+  struct QueryTests;
+  struct StatsTests;
+  struct TelemetryTests;
+  struct TournamentTests;
+  struct TuneTests;
+  struct SweepTests;
+  struct ScalingTests;
+  struct CalibrationTests;
+  struct ProfileTests;
+  struct PerfTests;
 };
 
 }
@@ -0,0 +1,138 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_tournament.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::TournamentTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_paired()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // A deterministic strategy against itself ties every game
+    MatchemConfig config(TOURNAMENT, 200, false);
+    config.set_tournament_strategies({HEURISTIC, HEURISTIC});
+    srand(0);
+    MatchemTournament tournament(config);
+    const TournamentStats stats = tournament.play_games(0, 200);
+
+    const PairedStats& diff = stats.diffs[0][1];
+    REQUIRE(diff.count == 200);
+    REQUIRE(diff.sum == 0);
+    REQUIRE(diff.sum_sq == 0);
+    REQUIRE(diff.wins == 0);
+    REQUIRE(diff.losses == 0);
+    REQUIRE(diff.ci95() == 0.0);
+    REQUIRE(stats.rounds[0].count == 200);
+    for (int r = 0; r < SimStats::NUM_BINS; ++r) {
+      REQUIRE(stats.rounds[0].histogram[r] == stats.rounds[1].histogram[r]);
+    }
+
+    // Games are a function of their index, not of when they are played
+    TournamentStats halves = tournament.play_games(0, 120);
+    halves.merge(tournament.play_games(120, 80));
+    for (int r = 0; r < SimStats::NUM_BINS; ++r) {
+      REQUIRE(halves.rounds[0].histogram[r] == stats.rounds[0].histogram[r]);
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_same_games()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Every strategy sees the same hidden state in a game, the one the seed
+    // and the game index pick
+    const int num_games = 50;
+    MatchemConfig config(TOURNAMENT, num_games, false);
+    config.set_tournament_strategies({HEURISTIC, BANDIT});
+    config.set_bandit_rollouts(4);
+    srand(1);
+    MatchemTournament tournament(config);
+    const TournamentStats stats = tournament.play_games(0, num_games);
+
+    MatchemConfig heuristic_config(BASIC, 1, false);
+    Matchem heuristic(heuristic_config);
+    const int64_t num_states = factorial(Matchem::SIZE);
+    int64_t heuristic_sum = 0;
+    for (int game = 0; game < num_games; ++game) {
+      Rng rng(hash_combine(tournament.m_seed, game));
+      heuristic.init_indv_exact(0, static_cast<int>(rng.below(num_states)));
+      heuristic_sum += heuristic.run_indv(0);
+    }
+    REQUIRE(stats.rounds[0].sum == heuristic_sum);
+
+    const PairedStats& diff = stats.diffs[0][1];
+    REQUIRE(diff.count == num_games);
+    REQUIRE(diff.sum == stats.rounds[0].sum - stats.rounds[1].sum);
+    REQUIRE(diff.wins + diff.losses <= num_games);
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_few_games()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Fewer games than threads, so the players only have workspaces for some
+    // of the threads. Every game must still be played exactly once.
+    const int num_games = std::max(1, Kokkos::DefaultExecutionSpace::concurrency() - 1);
+    MatchemConfig config(TOURNAMENT, num_games, false);
+    config.set_tournament_strategies({HEURISTIC, HEURISTIC});
+    srand(2);
+    MatchemTournament tournament(config);
+    REQUIRE(tournament.m_players[0]->m_tu.get_num_concurrent_teams() <= num_games);
+
+    const TournamentStats stats = tournament.play_games(0, num_games);
+    REQUIRE(stats.rounds[0].count == num_games);
+    REQUIRE(stats.rounds[1].count == num_games);
+    REQUIRE(stats.diffs[0][1].count == num_games);
+
+    MatchemConfig heuristic_config(BASIC, 1, false);
+    Matchem heuristic(heuristic_config);
+    const int64_t num_states = factorial(Matchem::SIZE);
+    int64_t heuristic_sum = 0;
+    for (int game = 0; game < num_games; ++game) {
+      Rng rng(hash_combine(tournament.m_seed, game));
+      heuristic.init_indv_exact(0, static_cast<int>(rng.below(num_states)));
+      heuristic_sum += heuristic.run_indv(0);
+    }
+    REQUIRE(stats.rounds[0].sum == heuristic_sum);
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("tournament_paired", "[tournament]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TournamentTests::test_paired();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("tournament_same_games", "[tournament]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TournamentTests::test_same_games();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("tournament_few_games", "[tournament]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TournamentTests::test_few_games();
+}
+
+} // empty namespace
@@ -0,0 +1,107 @@
+#include "tests_common.hpp"
+
+#include "matchem.hpp"
+#include "matchem_tree.hpp"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::TreeTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_unrank()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    constexpr int N = 5;
+    std::set<std::vector<int> > seen;
+    std::vector<int> prev;
+    for (int rank = 0; rank < factorial(N); ++rank) {
+      std::vector<int> perm(N);
+      unrank_permutation<N>(rank, perm.data());
+      REQUIRE(rank_permutation<N>(perm.data()) == rank);
+      if (rank > 0) {
+        REQUIRE(prev < perm);
+      }
+      seen.insert(perm);
+      prev = perm;
+    }
+    REQUIRE(static_cast<int64_t>(seen.size()) == factorial(N));
+    REQUIRE(prev == std::vector<int>({4, 3, 2, 1, 0}));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_same_games()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    MatchemConfig plain_config(BASIC, 1, false);
+    MatchemConfig tree_config(BASIC, 1, false);
+    tree_config.set_decision_tree_mb(16);
+    Matchem plain(plain_config);
+    Matchem tree(tree_config);
+
+    // A tree that fills up almost at once, so games fall off it
+    Matchem small(plain_config);
+    small.m_tree.init(50);
+    small.seed_tree();
+
+    // Every game is played twice through the tree, the second time it should
+    // not need the strategy at all
+    for (int game = 0; game < 100; ++game) {
+      srand(game);
+      plain.init_indv(0);
+      const int plain_rounds = plain.run_indv(0);
+
+      for (int pass = 0; pass < 2; ++pass) {
+        srand(game);
+        tree.init_indv(0);
+        const uint64_t computes = tree.m_tree_computes(0);
+        REQUIRE(tree.run_indv_tree(0) == plain_rounds);
+        if (pass == 1) {
+          REQUIRE(tree.m_tree_computes(0) == computes);
+        }
+      }
+
+      srand(game);
+      small.init_indv(0);
+      REQUIRE(small.run_indv_tree(0) == plain_rounds);
+    }
+    REQUIRE(small.m_tree.num_nodes() == 50);
+
+    // Exact mode enumerates hidden states instead of drawing them
+    for (int game = 0; game < 1000; ++game) {
+      const int rank = game * 3617;
+      plain.init_indv_exact(0, rank);
+      tree.init_indv_exact(0, rank);
+      REQUIRE(tree.run_indv_tree(0) == plain.run_indv(0));
+    }
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("tree_unrank", "[tree]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TreeTests::test_unrank();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("tree_same_games", "[tree]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TreeTests::test_same_games();
+}
+
+} // empty namespace
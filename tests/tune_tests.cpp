@@ -0,0 +1,90 @@
+#include "tests_common.hpp"
+
+#include "matchem_tuner.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace matchem {
+namespace tests {
+
+struct UnitWrap::TuneTests
+{
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_halve_frontier()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    // Player p takes rounds[p] every game and costs us[p] per game
+    const int rounds[] = {30, 25, 27, 25, 40};
+    const int us[]     = {10, 50, 20, 40, 5};
+    TournamentStats stats;
+    for (int p = 0; p < 5; ++p) {
+      for (int game = 0; game < 4; ++game) {
+        stats.rounds[p].add(rounds[p]);
+      }
+      stats.total_ns[p] = 4 * 1000 * us[p];
+    }
+
+    // 1 and 3 tie on rounds, 3 is cheaper
+    REQUIRE(MatchemTuner::halve(stats, {0, 1, 2, 3, 4}) == std::vector<int>({3, 1, 2}));
+    REQUIRE(MatchemTuner::halve(stats, {0, 4}) == std::vector<int>({0}));
+    REQUIRE(MatchemTuner::halve(stats, {2}) == std::vector<int>({2}));
+
+    // 1 costs more than 3 for the same rounds
+    REQUIRE(MatchemTuner::frontier(stats, {0, 1, 2, 3, 4}) == std::vector<int>({4, 0, 2, 3}));
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  static void test_successive_halving()
+  /////////////////////////////////////////////////////////////////////////////
+  {
+    MatchemConfig config(TUNE, 4, false);
+    const std::vector<MatchemTuner::Setting> settings = {{1, 1, 0.0}, {2, 2, 1.0}, {1, 2, 2.0}};
+    srand(0);
+    MatchemTuner tuner(config, settings);
+    const int best = tuner.tune();
+    REQUIRE(best >= 0);
+    REQUIRE(best < 3);
+
+    // 3 settings play 4 games, the 2 left play 8 more
+    const TournamentStats& stats = tuner.m_stats;
+    REQUIRE(stats.rounds[best].count == 12);
+    int64_t total = 0;
+    for (int s = 0; s < 3; ++s) {
+      total += stats.rounds[s].count;
+      REQUIRE(stats.total_ns[s] > 0);
+    }
+    REQUIRE(total == 4 + 12 + 12);
+    for (int s = 0; s < 3; ++s) {
+      if (s != best) {
+        REQUIRE(stats.diffs[std::min(s, best)][std::max(s, best)].count == stats.rounds[s].count);
+      }
+    }
+  }
+
+};
+
+}
+}
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("tune_halve_frontier", "[tune]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TuneTests::test_halve_frontier();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("tune_successive_halving", "[tune]")
+////////////////////////////////////////////////////////////////////////////////
+{
+  matchem::tests::UnitWrap::TuneTests::test_successive_halving();
+}
+
+} // empty namespace